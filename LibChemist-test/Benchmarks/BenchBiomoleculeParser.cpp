@@ -0,0 +1,63 @@
+#include "LibChemist/BiomoleculeParser.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <sstream>
+
+using namespace LibChemist;
+
+//Makes an mmCIF file of a synthetic protein with natoms atoms, in residues of
+//ten atoms and chains of a thousand residues
+std::string make_mmcif(size_t natoms)
+{
+    const std::array<const char*,5> names({"N","CA","C","O","CB"});
+    const std::array<const char*,5> symbols({"N","C","C","O","C"});
+    std::stringstream ss;
+    ss<<"data_BENCH\n#\nloop_\n";
+    for(const char* field: {"group_PDB","id","type_symbol","label_atom_id",
+                            "label_alt_id","label_comp_id","label_asym_id",
+                            "label_seq_id","pdbx_PDB_ins_code","Cartn_x",
+                            "Cartn_y","Cartn_z","occupancy","B_iso_or_equiv",
+                            "auth_seq_id","auth_asym_id","pdbx_PDB_model_num"})
+        ss<<"_atom_site."<<field<<"\n";
+    ss.precision(3);
+    ss<<std::fixed;
+    for(size_t i=0;i<natoms;++i)
+    {
+        const size_t residue=i/10, chain=residue/1000;
+        const std::string chain_id(1,static_cast<char>('A'+chain%26));
+        ss<<"ATOM "<<i+1<<" "<<symbols[i%5]<<" "<<names[i%5]<<" . ALA "
+          <<chain_id<<" "<<residue%1000+1<<" ? "<<0.01*(i%997)<<" "
+          <<0.02*(i%991)<<" "<<-0.03*(i%983)<<" 1.00 10.00 "
+          <<residue%1000+1<<" "<<chain_id<<" 1\n";
+    }
+    ss<<"#\n";
+    return ss.str();
+}
+
+//Parses input n times with nthreads threads and returns the atoms per second
+double throughput(const std::string& input, size_t nthreads, size_t n,
+                  Biomolecule& rv)
+{
+    Timer timer;
+    for(size_t i=0;i<n;++i)
+        rv=parse_mmcif_buffer(input,nthreads);
+    return rv.atoms.size()*n/timer.get_time();
+}
+
+int main()
+{
+    Tester tester("Benchmarking mmCIF parser throughput");
+    const size_t natoms=200000;
+    const std::string input=make_mmcif(natoms);
+    Biomolecule serial_rv, parallel_rv;
+    const double serial_aps=throughput(input,1,3,serial_rv);
+    const double parallel_aps=throughput(input,0,3,parallel_rv);
+    std::cout<<"Input size (MB): "<<input.size()/(1024.0*1024.0)<<std::endl;
+    std::cout<<"1 thread (atoms/s): "<<serial_aps<<std::endl;
+    std::cout<<"All threads (atoms/s): "<<parallel_aps<<std::endl;
+    tester.test("Parsed all atoms",serial_rv.atoms.size()==natoms &&
+                serial_rv.nresidues()==natoms/10 &&
+                serial_rv.nchains()==natoms/10000);
+    tester.test("Same system in parallel",serial_rv==parallel_rv);
+    return tester.results();
+}
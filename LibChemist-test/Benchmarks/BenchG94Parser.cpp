@@ -0,0 +1,232 @@
+#include "LibChemist/BasisSetDatabase.hpp"
+#include "LibChemist/BasisSetExchangeParser.hpp"
+#include "LibChemist/BasisSetLibrary.hpp"
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/lut/AtomicInfo.hpp"
+#include "LibChemist/ShellTypes.hpp"
+#include "TestHelpers.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <regex>
+
+using namespace LibChemist;
+using data_type=BasisSetFileParser::data_type;
+using action_type=BasisSetFileParser::action_type;
+using parsed_type=std::map<data_type,std::vector<double>>;
+
+//The regex-based G94 parser G94 used to be, kept around as a reference point
+struct RegexG94: public MapBasisSetFileParser
+{
+    action_type worth_parsing(const std::string& line)const override
+    {
+        if(std::regex_search(line,new_atom))
+            return action_type::new_atom;
+        else if(std::regex_search(line,new_shell))
+            return action_type::new_shell;
+        else if(std::regex_search(line,same_shell))
+            return action_type::same_shell;
+        return action_type::none;
+    }
+
+    parsed_type parse(const std::string& line)const override
+    {
+        parsed_type rv;
+        std::stringstream tokenizer(line);
+        if(std::regex_search(line,new_atom))
+        {
+            std::string symbol;
+            tokenizer>>symbol;
+            rv[data_type::Z].push_back(detail_::sym2Z_.at(symbol));
+        }
+        else if(std::regex_search(line,new_shell))
+        {
+            std::string am;
+            tokenizer>>am;
+            std::transform(am.begin(), am.end(), am.begin(), ::tolower);
+            rv[data_type::angular_momentum].push_back(am_str2int(am));
+        }
+        else if(std::regex_search(line,same_shell))
+        {
+            double a,c;
+            tokenizer>>a;
+            rv[data_type::exponent].push_back(a);
+            while(tokenizer>>c)
+                rv[data_type::coefficient].push_back(c);
+        }
+        return rv;
+    }
+
+    const std::regex new_atom{"^\\s*\\D{1,2}\\s*0\\s*$"};
+    const std::regex new_shell{"^\\s*[a-zA-Z]+\\s*\\d+\\s*1.00\\s*$"};
+    const std::regex same_shell{"^\\s*(?:\\d+.\\d+\\s*)+$"};
+};
+
+//Makes a G94 library with nshells contracted shells on each of H through Kr
+std::string make_library(size_t nshells, size_t nprims)
+{
+    const std::array<std::string,4> ams({"S","P","D","SP"});
+    std::stringstream ss;
+    ss<<"! Synthetic basis set library\n\n****\n";
+    for(size_t Z=1;Z<=36;++Z)
+    {
+        ss<<detail_::Z2sym_.at(Z)<<"     0\n";
+        for(size_t i=0;i<nshells;++i)
+        {
+            const std::string& am=ams[i%ams.size()];
+            ss<<am<<"   "<<nprims<<"   1.00\n";
+            for(size_t j=0;j<nprims;++j)
+            {
+                ss<<"   "<<std::fixed<<1000.0/(j+1)+0.1*i<<"   "
+                  <<1.0/(i+j+1);
+                if(am=="SP")ss<<"   "<<0.5/(i+j+1);
+                ss<<"\n";
+            }
+        }
+        ss<<"****\n";
+    }
+    return ss.str();
+}
+
+//Writes basis as a Basis Set Exchange JSON document
+std::string make_bse_json(const std::map<size_t,std::vector<BasisShell>>& basis)
+{
+    std::stringstream ss;
+    ss<<std::setprecision(17)<<"{\"name\": \"synthetic\", \"elements\": {";
+    for(auto Zi=basis.begin();Zi!=basis.end();++Zi)
+    {
+        ss<<(Zi==basis.begin() ? "" : ",")<<"\n\""<<Zi->first
+          <<"\": {\"electron_shells\": [";
+        for(size_t i=0;i<Zi->second.size();++i)
+        {
+            const BasisShell& shell=Zi->second[i];
+            ss<<(i ? "," : "")<<"\n{\"function_type\": \"gto\", "
+              <<"\"angular_momentum\": [";
+            if(shell.l>=0)ss<<shell.l;
+            for(int l=0;l<=-shell.l;++l)ss<<(l ? ", " : "")<<l;
+            ss<<"], \"exponents\": [";
+            for(size_t j=0;j<shell.nprim;++j)
+                ss<<(j ? ", " : "")<<"\""<<shell.alpha(j)<<"\"";
+            ss<<"], \"coefficients\": [";
+            for(size_t k=0;k<shell.ngen;++k)
+            {
+                ss<<(k ? ", " : "")<<"[";
+                for(size_t j=0;j<shell.nprim;++j)
+                    ss<<(j ? ", " : "")<<"\""<<shell.coef(j,k)<<"\"";
+                ss<<"]";
+            }
+            ss<<"]}";
+        }
+        ss<<"]}";
+    }
+    ss<<"}}\n";
+    return ss.str();
+}
+
+//Parses input n times and returns the throughput in MB/s
+double throughput(const std::string& input, const BasisSetFileParser& parser,
+                  size_t n, std::map<size_t,std::vector<BasisShell>>& rv)
+{
+    Timer timer;
+    for(size_t i=0;i<n;++i)
+    {
+        std::stringstream ss(input);
+        rv=parse_basis_set_file(ss,parser);
+    }
+    return input.size()*n/(1024.0*1024.0)/timer.get_time();
+}
+
+//Same as above, but for the overloads taking a path
+double throughput(const std::string& path, size_t size,
+                  const BasisSetFileParser& parser, size_t nthreads, size_t n,
+                  std::map<size_t,std::vector<BasisShell>>& rv)
+{
+    Timer timer;
+    for(size_t i=0;i<n;++i)
+        rv=(nthreads ? parse_basis_set_file(path,parser,nthreads) :
+                       parse_basis_set_file(path,parser));
+    return size*n/(1024.0*1024.0)/timer.get_time();
+}
+
+int main()
+{
+    Tester tester("Benchmarking G94 parser throughput");
+    const std::string input=make_library(20,8);
+    std::map<size_t,std::vector<BasisShell>> regex_rv, g94_rv;
+    const double regex_mbs=throughput(input,RegexG94(),1,regex_rv);
+    const double g94_mbs=throughput(input,G94(),10,g94_rv);
+    std::cout<<"Input size (MB): "<<input.size()/(1024.0*1024.0)<<std::endl;
+    std::cout<<"Regex parser (MB/s): "<<regex_mbs<<std::endl;
+    std::cout<<"G94 parser (MB/s): "<<g94_mbs<<std::endl;
+    tester.test("Same basis sets",regex_rv==g94_rv);
+
+    const std::string path("BenchG94Parser.g94");
+    std::ofstream(path)<<input;
+    std::map<size_t,std::vector<BasisShell>> mmap_rv, parallel_rv;
+    const double mmap_mbs=throughput(path,input.size(),G94(),0,10,mmap_rv);
+    const double parallel_mbs=throughput(path,input.size(),G94(),4,10,
+                                         parallel_rv);
+    std::map<size_t,std::vector<BasisShell>> pipelined_rv;
+    Timer pipelined_timer;
+    for(size_t i=0;i<10;++i)
+        pipelined_rv=parse_basis_set_file(path,G94(),ReadMode::pipelined);
+    const double pipelined_mbs=
+        input.size()*10/(1024.0*1024.0)/pipelined_timer.get_time();
+
+    //Only parse what a water molecule needs
+    SetOfAtoms h2o;
+    h2o.insert(create_atom({0.0,0.0,0.0},8));
+    h2o.insert(create_atom({0.0,1.4,1.1},1));
+    h2o.insert(create_atom({0.0,-1.4,1.1},1));
+    G94 parser;
+    std::map<size_t,std::vector<BasisShell>> lazy_rv;
+    Timer timer;
+    for(size_t i=0;i<10;++i)
+    {
+        BasisSetLibrary lib(path,parser);
+        lazy_rv=lib.basis_set(h2o);
+    }
+    const double lazy_mbs=input.size()*10/(1024.0*1024.0)/timer.get_time();
+    std::remove(path.c_str());
+    std::cout<<"G94 parser, mapped file (MB/s): "<<mmap_mbs<<std::endl;
+    std::cout<<"G94 parser, pipelined file (MB/s): "<<pipelined_mbs
+             <<std::endl;
+    std::cout<<"Library, water only (effective MB/s): "<<lazy_mbs<<std::endl;
+    tester.test("Same basis set for water",
+                lazy_rv.size()==2 && lazy_rv.at(1)==g94_rv.at(1) &&
+                lazy_rv.at(8)==g94_rv.at(8));
+    std::cout<<"G94 parser, 4 threads (MB/s): "<<parallel_mbs<<std::endl;
+
+    //Load every element from a compiled database instead of the text
+    const std::string db_path("BenchG94Parser.db");
+    write_basis_set_database(db_path,{{"bench",g94_rv}});
+    std::map<size_t,std::vector<BasisShell>> db_rv;
+    Timer db_timer;
+    for(size_t i=0;i<10;++i)
+    {
+        const BasisSetDatabase db(db_path);
+        db_rv.clear();
+        for(size_t Z: db.elements("bench"))
+            db_rv.emplace(Z,db.shells("bench",Z));
+    }
+    const double db_mbs=input.size()*10/(1024.0*1024.0)/db_timer.get_time();
+    std::remove(db_path.c_str());
+    std::cout<<"Database, all elements (effective MB/s): "<<db_mbs<<std::endl;
+
+    //The same library as a Basis Set Exchange JSON document
+    const std::string json=make_bse_json(g94_rv);
+    std::map<size_t,std::vector<BasisShell>> bse_rv;
+    Timer bse_timer;
+    for(size_t i=0;i<10;++i)
+        bse_rv=parse_bse_json_buffer(json);
+    const double bse_mbs=json.size()*10/(1024.0*1024.0)/bse_timer.get_time();
+    std::cout<<"BSE JSON reader (MB/s): "<<bse_mbs<<std::endl;
+    tester.test("Same basis sets from BSE JSON",bse_rv==g94_rv);
+    tester.test("Same basis sets from database",db_rv==g94_rv);
+    tester.test("Same basis sets from file",mmap_rv==g94_rv);
+    tester.test("Same basis sets from pipelined file",pipelined_rv==g94_rv);
+    tester.test("Same basis sets in parallel",parallel_rv==g94_rv);
+    tester.test("Parsed all elements",g94_rv.size()==36);
+    return tester.results();
+}
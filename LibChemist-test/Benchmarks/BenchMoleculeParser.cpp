@@ -0,0 +1,73 @@
+#include "LibChemist/MoleculeParser.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <sstream>
+
+using namespace LibChemist;
+
+//Makes an SDF library of nmols chains of natoms atoms, ligand-sized
+std::string make_sdf(size_t nmols, size_t natoms)
+{
+    const std::array<const char*,5> symbols({"C","C","N","O","S"});
+    std::stringstream ss;
+    ss.precision(4);
+    ss<<std::fixed;
+    for(size_t i=0;i<nmols;++i)
+    {
+        char counts[64];
+        std::snprintf(counts,sizeof(counts),"%3zu%3zu  0  0  0  0  0  0  0  0"
+                      "999 V2000\n",natoms,natoms-1);
+        ss<<"ligand"<<i<<"\n  bench\n\n"<<counts;
+        for(size_t j=0;j<natoms;++j)
+        {
+            char line[128];
+            std::snprintf(line,sizeof(line),"%10.4f%10.4f%10.4f %-3s 0  0  0"
+                          "  0  0  0  0  0  0  0  0  0\n",1.5*j,0.01*i,
+                          -0.5*(j%2),symbols[(i+j)%symbols.size()]);
+            ss<<line;
+        }
+        for(size_t j=1;j<natoms;++j)
+        {
+            char line[64];
+            std::snprintf(line,sizeof(line),"%3zu%3zu%3zu  0\n",j,j+1,
+                          j%3 ? size_t(1) : size_t(2));
+            ss<<line;
+        }
+        ss<<"M  END\n> <ID>\n"<<i<<"\n\n$$$$\n";
+    }
+    return ss.str();
+}
+
+int main()
+{
+    Tester tester("Benchmarking SDF reader throughput");
+    const size_t nmols=5000;
+    const std::string input=make_sdf(nmols,40);
+
+    Timer stream_timer;
+    std::stringstream ss(input);
+    MoleculeStream stream(ss,MoleculeFormat::sdf);
+    std::vector<Molecule> stream_rv;
+    Molecule mol;
+    while(stream.next(mol))stream_rv.push_back(mol);
+    const double stream_mps=nmols/stream_timer.get_time();
+
+    Timer serial_timer;
+    const auto serial_rv=parse_molecule_buffer(input,MoleculeFormat::sdf,1);
+    const double serial_mps=nmols/serial_timer.get_time();
+
+    Timer parallel_timer;
+    const auto parallel_rv=parse_molecule_buffer(input,MoleculeFormat::sdf);
+    const double parallel_mps=nmols/parallel_timer.get_time();
+
+    std::cout<<"Input size (MB): "<<input.size()/(1024.0*1024.0)<<std::endl;
+    std::cout<<"Streamed (molecules/s): "<<stream_mps<<std::endl;
+    std::cout<<"Buffer, 1 thread (molecules/s): "<<serial_mps<<std::endl;
+    std::cout<<"Buffer, all threads (molecules/s): "<<parallel_mps<<std::endl;
+    tester.test("Parsed all molecules",serial_rv.size()==nmols &&
+                serial_rv.back().atoms.size()==40 &&
+                serial_rv.back().bonds.nbonds()==39);
+    tester.test("Same molecules streamed",stream_rv==serial_rv);
+    tester.test("Same molecules in parallel",parallel_rv==serial_rv);
+    return tester.results();
+}
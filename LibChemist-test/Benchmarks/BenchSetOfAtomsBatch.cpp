@@ -0,0 +1,53 @@
+#include "LibChemist/SetOfAtomsParser.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace LibChemist;
+
+//Writes nfiles small xyz files, ligand-sized, and returns their paths
+std::vector<std::string> make_files(size_t nfiles, size_t natoms)
+{
+    const std::array<const char*,5> symbols({"C","H","N","O","S"});
+    std::vector<std::string> paths;
+    for(size_t i=0;i<nfiles;++i)
+    {
+        paths.push_back("BenchSetOfAtomsBatch"+std::to_string(i)+".xyz");
+        std::ofstream os(paths.back());
+        os<<natoms<<"\nLigand "<<i<<"\n0 1\n";
+        for(size_t j=0;j<natoms;++j)
+            os<<symbols[(i+j)%symbols.size()]<<" "<<0.1*j<<" "<<0.01*i<<" "
+              <<-0.2*j<<"\n";
+    }
+    return paths;
+}
+
+int main()
+{
+    Tester tester("Benchmarking batch parsing of small xyz files");
+    const std::vector<std::string> paths=make_files(2000,40);
+
+    XYZParser parser;
+    std::vector<SetOfAtoms> serial_rv;
+    Timer serial_timer;
+    for(const auto& path: paths)
+        serial_rv.push_back(parse_SetOfAtoms_file(path,parser));
+    const double serial_fps=paths.size()/serial_timer.get_time();
+
+    Timer batch_timer;
+    const auto batch_rv=parse_SetOfAtoms_files(paths,parser,1);
+    const double batch_fps=paths.size()/batch_timer.get_time();
+
+    Timer parallel_timer;
+    const auto parallel_rv=parse_SetOfAtoms_files(paths,parser);
+    const double parallel_fps=paths.size()/parallel_timer.get_time();
+
+    for(const auto& path: paths)std::remove(path.c_str());
+    std::cout<<"One file at a time (files/s): "<<serial_fps<<std::endl;
+    std::cout<<"Batch, 1 thread (files/s): "<<batch_fps<<std::endl;
+    std::cout<<"Batch, all threads (files/s): "<<parallel_fps<<std::endl;
+    tester.test("Same systems, 1 thread",serial_rv==batch_rv);
+    tester.test("Same systems, all threads",serial_rv==parallel_rv);
+    tester.test("Parsed all atoms",serial_rv.back().size()==40);
+    return tester.results();
+}
@@ -0,0 +1,47 @@
+#include "LibChemist/detail_/TextParsing.hpp"
+#include "TestHelpers.hpp"
+#include <algorithm>
+
+using namespace LibChemist::detail_;
+
+//The lookup symbol_to_Z used to do: fold into a heap string, then hash it
+size_t map_lookup(std::string_view sym)
+{
+    std::string temp(sym);
+    std::transform(temp.begin(),temp.end(),temp.begin(),::tolower);
+    temp[0]=std::toupper(temp[0]);
+    return sym2Z_.at(temp);
+}
+
+//Looks up every symbol n times and returns the lookups per second
+template<typename Fxn>
+double lookups(const std::vector<std::string>& syms, size_t n, Fxn fxn,
+               size_t& sum)
+{
+    sum=0;
+    Timer timer;
+    for(size_t i=0;i<n;++i)
+        for(const std::string& sym: syms)sum+=fxn(sym);
+    return syms.size()*n/timer.get_time();
+}
+
+int main()
+{
+    Tester tester("Benchmarking element symbol lookups");
+
+    //Mostly organic elements, in the mix of cases files actually use
+    std::vector<std::string> syms;
+    const std::array<const char*,12> common({"C","H","N","O","S","P","CL",
+                                             "Fe","ZN","Br","na","Mg"});
+    for(size_t i=0;i<4096;++i)syms.push_back(common[(i*7)%common.size()]);
+    for(const auto& x: Z2sym_)syms.push_back(x.second);
+
+    size_t map_sum,hash_sum;
+    const double map_ps=lookups(syms,200,map_lookup,map_sum);
+    const double hash_ps=lookups(syms,200,symbol_to_Z,hash_sum);
+    std::cout<<"unordered_map lookups per second: "<<map_ps<<std::endl;
+    std::cout<<"Perfect hash lookups per second: "<<hash_ps<<std::endl;
+    std::cout<<"Speed-up: "<<hash_ps/map_ps<<std::endl;
+    tester.test("Same atomic numbers",map_sum==hash_sum);
+    return tester.results();
+}
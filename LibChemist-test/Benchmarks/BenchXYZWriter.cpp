@@ -0,0 +1,64 @@
+#include "LibChemist/SetOfAtomsWriter.hpp"
+#include "LibChemist/XYZTrajectory.hpp"
+#include "LibChemist/lut/AtomicInfo.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+using namespace LibChemist;
+
+//Makes nframes frames of a natoms system, jiggling the coordinates a bit
+std::vector<SetOfAtoms> make_frames(size_t nframes, size_t natoms)
+{
+    const std::array<size_t,5> Zs({6,1,7,8,16});
+    std::vector<SetOfAtoms> frames(nframes);
+    for(size_t i=0;i<nframes;++i)
+        for(size_t j=0;j<natoms;++j)
+            frames[i].push_back(create_atom({0.1*j+1E-3*i,0.01*i/3.0,
+                                             -0.2*j/7.0},Zs[j%Zs.size()]));
+    return frames;
+}
+
+int main()
+{
+    Tester tester("Benchmarking xyz trajectory writing");
+    const std::vector<SetOfAtoms> frames=make_frames(500,100);
+    const std::string path("BenchXYZWriter.xyz");
+
+    //What we used to do, with enough digits to round trip
+    Timer stream_timer;
+    {
+        std::ofstream os(path);
+        os<<std::setprecision(std::numeric_limits<double>::max_digits10);
+        for(const SetOfAtoms& frame: frames)
+        {
+            os<<frame.size()<<"\n"<<frame.charge<<" "<<frame.multiplicity
+              <<"\n";
+            for(const Atom& ai: frame)
+                os<<detail_::Z2sym_.at(ai.Z)<<" "<<ai.coord[0]<<" "
+                  <<ai.coord[1]<<" "<<ai.coord[2]<<"\n";
+        }
+    }
+    const double stream_fps=frames.size()/stream_timer.get_time();
+
+    Timer writer_timer;
+    {
+        XYZWriter writer(path);
+        for(const SetOfAtoms& frame: frames)
+            writer.write(frame);
+    }
+    const double writer_fps=frames.size()/writer_timer.get_time();
+
+    std::ifstream file(path);
+    size_t nread=0;
+    bool same=true;
+    for(const SetOfAtoms& frame: XYZTrajectory(file))
+        same=same && nread<frames.size() && frame==frames[nread++];
+    std::remove(path.c_str());
+    std::cout<<"std::ofstream (frames/s): "<<stream_fps<<std::endl;
+    std::cout<<"XYZWriter (frames/s): "<<writer_fps<<std::endl;
+    tester.test("Frames round trip",same && nread==frames.size());
+    return tester.results();
+}
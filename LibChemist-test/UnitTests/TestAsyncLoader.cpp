@@ -0,0 +1,82 @@
+#include "LibChemist/AsyncLoader.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace LibChemist;
+
+std::string g94_example=
+        "****\n"
+        "H     0\n"
+        "S   2   1.00\n"
+        "     13.0100000              0.0196850\n"
+        "      1.9620000              0.1379770\n"
+        "****\n"
+        "O     0\n"
+        "S   1   1.00\n"
+        "      0.5000000              1.0000000\n"
+        "P   1   1.00\n"
+        "      0.2500000              1.0000000\n"
+        "****\n";
+
+int main()
+{
+    Tester tester("Testing asynchronous loading");
+    const std::string basis_path("TestAsyncLoader.g94");
+    std::ofstream(basis_path)<<g94_example;
+    std::vector<std::string> paths;
+    for(size_t i=0;i<8;++i)
+    {
+        paths.push_back("TestAsyncLoader"+std::to_string(i)+".xyz");
+        std::ofstream(paths.back())<<"O 0.0 0.0 "<<i<<"\nH 0.0 1.0 "<<i
+                                   <<"\nH 0.0 -1.0 "<<i<<"\n";
+    }
+
+    //What loading the jobs one step at a time gives
+    const auto basis=parse_basis_set_file(basis_path,G94());
+    std::vector<SetOfAtoms> corr;
+    for(const auto& path: paths)
+        corr.push_back(apply_basis_set("test",basis,
+                                       parse_SetOfAtoms_file(path,
+                                                             XYZParser())));
+
+    //Also with a single thread, where the halves of a job can't overlap
+    for(size_t nthreads: {1,4})
+    {
+        AsyncLoader loader(nthreads);
+        std::vector<std::future<SetOfAtoms>> jobs;
+        for(const auto& path: paths)
+            jobs.push_back(loader.load(path,basis_path,"test"));
+        bool same=loader.nthreads()==nthreads;
+        for(size_t i=0;i<jobs.size();++i)
+        {
+            const SetOfAtoms atoms=jobs[i].get();
+            same=same && atoms==corr[i] &&
+                 get_basis("test",atoms)==get_basis("test",corr[i]);
+        }
+        tester.test("Loaded jobs with "+std::to_string(nthreads)+" threads",
+                    same);
+    }
+
+    //Errors end up in the job they belong to
+    std::future<SetOfAtoms> bad_molecule, bad_basis, good;
+    {
+        AsyncLoader loader(2);
+        bad_molecule=loader.load("not_a_file.xyz",basis_path,"test");
+        bad_basis=loader.load(paths[0],"not_a_file.g94","test");
+        good=loader.load(paths[1],basis_path,"test",
+                         std::make_shared<XYZParser>(),
+                         std::make_shared<G94>());
+    }
+    auto throws=[](std::future<SetOfAtoms>& job){
+        try{job.get();}
+        catch(const std::runtime_error&){return true;}
+        return false;
+    };
+    tester.test("Failed jobs throw",throws(bad_molecule) && throws(bad_basis));
+    tester.test("Jobs are done when the loader goes",good.get()==corr[1]);
+
+    std::remove(basis_path.c_str());
+    for(const auto& path: paths)std::remove(path.c_str());
+    return tester.results();
+}
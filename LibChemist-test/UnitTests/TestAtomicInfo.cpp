@@ -1,5 +1,6 @@
 #include "LibChemist/lut/AtomicInfo.hpp"
 #include "TestHelpers.hpp"
+#include <cctype>
 
 using namespace LibChemist::detail_;
 
@@ -16,6 +17,23 @@ int main()
     tester.test("Uranium symbol",Z2sym_.at(92)=="U");
     tester.test("Helium atomic number",sym2Z_.at("He")==2);
 
+    //The perfect hash agrees with sym2Z_, whatever the case
+    static_assert(find_symbol_Z("He")==2,"Lookup is usable at compile time");
+    bool same=true;
+    for(const auto& x: sym2Z_)
+    {
+        std::string upper(x.first),lower(x.first);
+        for(char& c: upper)c=std::toupper(c);
+        for(char& c: lower)c=std::tolower(c);
+        same=same && find_symbol_Z(x.first)==x.second &&
+             find_symbol_Z(upper)==x.second && find_symbol_Z(lower)==x.second;
+    }
+    tester.test("Perfect hash lookup",same && symbols_.size()==sym2Z_.size());
+    bool none=true;
+    for(const char* x: {"","Xx","Heee","H1","1","@","[e","h ","H\xC3\xA9","Q"})
+        none=none && find_symbol_Z(x)==no_symbol_Z_;
+    tester.test("Perfect hash rejects non-symbols",none);
+
     //Spot check atomic_data_
     AtomicData corr_Os({76,"Os","Osmium",5,"D",190.23,190.2,190.26,
                    2.7212056206592723,0.0,
@@ -1,5 +1,7 @@
 #include "LibChemist/BasisSet.hpp"
 #include "TestHelpers.hpp"
+#include <algorithm>
+#include <stdexcept>
 
 using namespace LibChemist;
 
@@ -24,23 +26,47 @@ int main()
     bs.add_shell(origin.data(),Cart);
     bs.add_shell(origin.data(),Pure);
     
-    BasisSet corr;
-    tester.test("Default is not equal",corr!=bs);
-
-    corr.centers=std::vector<double>(6,0.0);
-    corr.coefs=std::vector<double>({8.1,2.6,7.1,
-                                    1.4,6.8,7.1,
-                                    9.1,5.4,6.0});
-    corr.alphas=std::vector<double>({3.1,4.5,6.9,
-                                     3.1,4.5,6.9});
-    corr.nprims=std::vector<size_t>({3,3});
-    corr.ngens=std::vector<size_t>({1,2});
-    corr.types=std::vector<ShellType>({ShellType::CartesianGaussian,
-                                       ShellType::SphericalGaussian});
-    corr.ls=std::vector<int>({2,-1});
+    BasisSet corr(std::vector<double>(6,0.0),{1,2},{3,3},
+                  {8.1,2.6,7.1,
+                   1.4,6.8,7.1,
+                   9.1,5.4,6.0},
+                  {3.1,4.5,6.9,
+                   3.1,4.5,6.9},
+                  {ShellType::CartesianGaussian,ShellType::SphericalGaussian},
+                  {2,-1});
+    tester.test("Default is not equal",BasisSet()!=bs);
     tester.test("Add shell",corr==bs);
+    tester.test("Offsets of arrays",corr.size()==10 && corr.max_am()==2 &&
+                corr.coefficient_offset(2)==9 && corr.function_offset(1)==6 &&
+                corr.ncenters()==1);
+
+    bool threw=false;
+    try{
+        BasisSet(std::vector<double>(6,0.0),{1,2},{3,3},{8.1},{3.1,4.5,6.9},
+                 {ShellType::CartesianGaussian,ShellType::SphericalGaussian},
+                 {2,-1});
+    }
+    catch(const std::invalid_argument&){threw=true;}
+    tester.test("Arrays too short",threw);
+    threw=false;
+    try{
+        BasisSet(std::vector<double>(3,0.0),{1,2},{3,3},{},{},
+                 {ShellType::CartesianGaussian,ShellType::SphericalGaussian},
+                 {2,-1});
+    }
+    catch(const std::invalid_argument&){threw=true;}
+    tester.test("Too few centers",threw);
+
     tester.test("Max angular momentum",bs.max_am()==2);
     tester.test("Number of basis functions",bs.size()==10);
+    tester.test("Offsets",bs.nshells()==2 && bs.primitive_offset(1)==3 &&
+                bs.primitive_offset(2)==6 && bs.coefficient_offset(1)==3 &&
+                bs.coefficient_offset(2)==9 && bs.function_offset(1)==6 &&
+                bs.function_offset(2)==10 && bs.center_index(1)==0 &&
+                bs.ncenters()==1);
+    const BasisSet empty;
+    tester.test("Empty basis set",empty.size()==0 && empty.max_am()==0 &&
+                empty.ncenters()==0 && empty.primitive_offset(0)==0);
 
     BasisSet Copy(bs);
     tester.test("Copy constructor",Copy==bs && Copy==corr);
@@ -55,44 +81,141 @@ int main()
     tester.test("Copy assignment",Copy==Move && Move==bs && Move==corr);
     
     //Ungeneralize test
-    BasisSet corr_ungen;
-    corr_ungen.centers=std::vector<double>(9,0.0);
-    corr_ungen.coefs=std::vector<double>({8.1,2.6,7.1,
-                                          1.4,6.8,7.1,
-                                          9.1,5.4,6.0});
-    corr_ungen.alphas=std::vector<double>({3.1,4.5,6.9,
-                                           3.1,4.5,6.9,
-                                           3.1,4.5,6.9});
-    corr_ungen.nprims=std::vector<size_t>({3,3,3});
-    corr_ungen.ngens=std::vector<size_t>({1,1,1});
-    corr_ungen.types=std::vector<ShellType>({ShellType::CartesianGaussian,
-                                       ShellType::SphericalGaussian,
-                                       ShellType::SphericalGaussian});
-    corr_ungen.ls=std::vector<int>({2,0,1});
+    BasisSet corr_ungen(std::vector<double>(9,0.0),{1,1,1},{3,3,3},
+                        {8.1,2.6,7.1,
+                         1.4,6.8,7.1,
+                         9.1,5.4,6.0},
+                        {3.1,4.5,6.9,
+                         3.1,4.5,6.9,
+                         3.1,4.5,6.9},
+                        {ShellType::CartesianGaussian,
+                         ShellType::SphericalGaussian,
+                         ShellType::SphericalGaussian},
+                        {2,0,1});
     tester.test("Ungeneralize",corr_ungen==ungeneralize_basis_set(bs));
 
     //Concatenation test
-    BasisSet corr_concat;
-    corr_concat.centers=std::vector<double>(12,0.0);
-    corr_concat.coefs=std::vector<double>({8.1,2.6,7.1,
-                                    1.4,6.8,7.1,
-                                    9.1,5.4,6.0,
-                                    8.1,2.6,7.1,
-                                    1.4,6.8,7.1,
-                                    9.1,5.4,6.0});
-    corr_concat.alphas=std::vector<double>({3.1,4.5,6.9,
-                                     3.1,4.5,6.9,
-                                     3.1,4.5,6.9,
-                                     3.1,4.5,6.9
-                                    });
-    corr_concat.nprims=std::vector<size_t>(4,3);
-    corr_concat.ngens=std::vector<size_t>({1,2,1,2});
-    corr_concat.types=std::vector<ShellType>({ShellType::CartesianGaussian,
-                                              ShellType::SphericalGaussian,
-                                              ShellType::CartesianGaussian,
-                                              ShellType::SphericalGaussian});
-    corr_concat.ls=std::vector<int>({2,-1,2,-1});
+    BasisSet corr_concat(std::vector<double>(12,0.0),{1,2,1,2},
+                         std::vector<size_t>(4,3),
+                         {8.1,2.6,7.1,
+                          1.4,6.8,7.1,
+                          9.1,5.4,6.0,
+                          8.1,2.6,7.1,
+                          1.4,6.8,7.1,
+                          9.1,5.4,6.0},
+                         {3.1,4.5,6.9,
+                          3.1,4.5,6.9,
+                          3.1,4.5,6.9,
+                          3.1,4.5,6.9},
+                         {ShellType::CartesianGaussian,
+                          ShellType::SphericalGaussian,
+                          ShellType::CartesianGaussian,
+                          ShellType::SphericalGaussian},
+                         {2,-1,2,-1});
     tester.test("Concatenation",corr_concat==basis_set_concatenate(bs,Copy));
+    tester.test("Concatenated offsets",bs.size()==20 &&
+                bs.coefficient_offset(3)==12 && bs.function_offset(3)==16 &&
+                bs.ncenters()==1);
+
+    //Shells on other centers, and a second general contraction
+    std::vector<double> other({0.0,0.0,1.0});
+    bs.add_shell(other.data(),Pure);
+    bs.add_shell(other.data(),Cart);
+    bs.add_shell(origin.data(),Cart);
+    tester.test("Center indices",bs.ncenters()==2 && bs.center_index(3)==0 &&
+                bs.center_index(4)==1 && bs.center_index(5)==1 &&
+                bs.center_index(6)==0);
+    //Enough centers that the table of them has to grow
+    BasisSet many;
+    for(size_t i=0;i<100;++i)
+    {
+        const double center[]={double(i%10),double(i/10),-0.0};
+        many.add_shell(center,Cart);
+    }
+    const double first_center[]={0.0,0.0,0.0};
+    many.add_shell(first_center,Pure);
+    tester.test("Many centers",many.ncenters()==100 &&
+                many.center_index(57)==57 && many.center_index(100)==0);
+    BasisSet moved(std::move(many));
+    tester.test("Moved from is empty",many==BasisSet() &&
+                many.ncenters()==0 && many.size()==0 && many.max_am()==0 &&
+                moved.ncenters()==100);
+    BasisSet twice(bs);
+    basis_set_concatenate(twice,bs);
+    tester.test("Concatenated centers",twice.ncenters()==2 &&
+                twice.center_index(7)==0 && twice.center_index(11)==1);
+    BasisSet self(bs);
+    basis_set_concatenate(self,self);
+    tester.test("Concatenated with itself",self==twice &&
+                self.size()==2*bs.size());
+    BasisSet ungen=ungeneralize_basis_set(bs);
+    tester.test("Ungeneralize after a general contraction",
+                ungen.nshells()==10 && ungen.size()==bs.size() &&
+                std::equal(ungen.coefs().begin()+18,ungen.coefs().begin()+24,
+                           gen_cs.begin()) &&
+                ungen.function_offset(8)==bs.function_offset(5));
+
+
+    //Shell views point into the arrays and agree with the shells they came
+    //from
+    const BasisShell corr_shells[]={Cart,Pure,Cart,Pure,Pure,Cart,Cart};
+    bool views=bs.shells().size()==7 &&
+               std::distance(bs.shells().begin(),bs.shells().end())==7;
+    for(size_t i=0;i<bs.nshells();++i)
+    {
+        const ShellView view=bs.shell(i);
+        views=views && view.to_shell()==corr_shells[i] &&
+              view.center==bs.centers().data()+3*i &&
+              view.alphas.data()==bs.alphas().data()+bs.primitive_offset(i) &&
+              view.coefs.data()==bs.coefs().data()+bs.coefficient_offset(i) &&
+              view.nfunctions(0)==corr_shells[i].nfunctions(0);
+    }
+    const std::vector<double> second_contraction({9.1,5.4,6.0});
+    tester.test("Shell views",views && bs.shell(1).coef(2,1)==6.0 &&
+                bs.shell(1).contraction(1)==second_contraction);
+
+    size_t nfunctions=0,nviews=0;
+    for(const ShellView& shell: bs.shells())
+    {
+        for(size_t j=0;j<shell.ngen;++j)nfunctions+=shell.nfunctions(j);
+        ++nviews;
+    }
+    tester.test("Range-based for over shells",nfunctions==bs.size() &&
+                nviews==bs.nshells());
+
+    bool same_views=true;
+    size_t i=0;
+    for(auto it=bs.shells().begin();it!=bs.shells().end();++i)
+    {
+        const ShellView view=*it++;
+        same_views=same_views && view.to_shell()==corr_shells[i] &&
+                   view.coefs.data()==bs.shell(i).coefs.data();
+    }
+    auto it=bs.shells().begin();
+    ++it;
+    tester.test("Shell iterator",same_views && i==7 && it->ngen==2 &&
+                (*it).coefs.data()==bs.shell(1).coefs.data() &&
+                empty.shells().empty() &&
+                empty.shells().begin()==empty.shells().end());
 
+    //Jumping around the shells is as good as indexing them
+    const auto shells=bs.shells();
+    const auto first=shells.begin(), last=shells.end();
+    bool random_access=(last-first==7 && first<last && last>=first &&
+                        !(last<first));
+    for(std::ptrdiff_t k=0;k<7;++k)
+    {
+        const ShellView view=*(first+k);
+        random_access=random_access && view.to_shell()==corr_shells[k] &&
+                      first[k].coefs.data()==bs.shell(k).coefs.data() &&
+                      (last-(7-k))->alphas.data()==view.alphas.data() &&
+                      (k+first)-first==k;
+    }
+    auto jump=first;
+    jump+=5;
+    jump-=2;
+    tester.test("Random access shell iterator",random_access &&
+                jump==first+3 && --jump==first+2 && jump[-1].ngen==2 &&
+                (last-1)->to_shell()==corr_shells[6]);
     return tester.results();
 }
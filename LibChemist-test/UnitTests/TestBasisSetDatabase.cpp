@@ -0,0 +1,122 @@
+#include "LibChemist/BasisSetDatabase.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace LibChemist;
+
+std::string small_basis=
+        "****\n"
+        "H     0 \n"
+        "S   3   1.00\n"
+        "     13.0100000              0.0196850        \n"
+        "      1.9620000              0.1379770        \n"
+        "      0.4446000              0.4781480        \n"
+        "****\n";
+
+std::string big_basis=
+        "****\n"
+        "H     0 \n"
+        "S   1   1.00\n"
+        "      0.1220000              1.0000000        \n"
+        "****\n"
+        "C     0 \n"
+        "S   2   1.00\n"
+        "   6665.0000000              0.0006920        \n"
+        "   1000.0000000              0.0053290        \n"
+        "SP   2   1.00\n"
+        "    0.1687144              0.5000000              0.2500000 \n"
+        "    0.0500000              0.7500000              0.1250000 \n"
+        "****\n";
+
+int main()
+{
+    Tester tester("Testing memory-mapped basis set databases");
+
+    namespace fs=std::filesystem;
+    const fs::path dir("TestBasisSetDatabase.dir");
+    fs::create_directory(dir);
+    std::ofstream(dir/"small.gbs")<<small_basis;
+    std::ofstream(dir/"big.gbs")<<big_basis;
+    std::ofstream(dir/"README")<<"Not a basis set";
+    G94 parser;
+    const auto small=parse_basis_set_file((dir/"small.gbs").string(),parser);
+    const auto big=parse_basis_set_file((dir/"big.gbs").string(),parser);
+
+    const std::string path("TestBasisSetDatabase.db");
+    compile_basis_set_database(dir.string(),path,parser,".gbs",2);
+    fs::remove_all(dir);
+    const BasisSetDatabase db(path);
+    tester.test("Size",db.size()==2);
+    tester.test("Names",db.names()==std::vector<std::string>({"big","small"}));
+    tester.test("Count",db.count("big") && !db.count("README") &&
+                        db.count("big",6) && !db.count("small",6));
+    tester.test("Elements",db.elements("big")==std::vector<size_t>({1,6}));
+    tester.test("Shells",db.shells("small",1)==small.at(1) &&
+                         db.shells("big",1)==big.at(1) &&
+                         db.shells("big",6)==big.at(6));
+
+    const auto views=db.views("big",6);
+    tester.test("Views",views.size()==2 && views[1].l==-1 &&
+                        views[1].ngen==2 && views[1].nprim==2 &&
+                        views[1].alpha(1)==0.05 &&
+                        views[1].coef(0,1)==0.25 &&
+                        views[1].coef(1,0)==0.75);
+
+    SetOfAtoms h2o;
+    h2o.insert(create_atom({0.0,0.0,0.0},8));
+    h2o.insert(create_atom({0.0,1.4,1.1},1));
+    h2o.insert(create_atom({0.0,-1.4,1.1},1));
+    tester.test("Apply basis set",apply_basis_set("big",db,h2o)==
+                                  apply_basis_set("big",big,h2o));
+
+    bool threw=false;
+    try{db.shells("big",8);}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Missing element throws",threw);
+    threw=false;
+    try{db.elements("sto-3g");}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Missing basis set throws",threw);
+
+    //Round trip through the writer, and a database that was cut short
+    write_basis_set_database(path,{{"small",small}});
+    tester.test("Rewritten database",BasisSetDatabase(path).names()==
+                                     std::vector<std::string>({"small"}));
+    //Overwrites the 64-bit word at byte offset of a fresh copy of the
+    //database, and returns true if opening it throws
+    auto corrupt_throws=[&](std::streamoff offset, std::uint64_t value){
+        write_basis_set_database(path,{{"small",small}});
+        {
+            std::fstream file(path,std::ios::binary|std::ios::in|
+                                   std::ios::out);
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(&value),sizeof(value));
+        }
+        try{BasisSetDatabase corrupt(path);}
+        catch(const std::runtime_error&){return true;}
+        return false;
+    };
+    //The 72-byte header is followed by one basis, element and shell record
+    tester.test("Overflowing shell count throws",
+                corrupt_throws(40,std::uint64_t(1)<<61));
+    tester.test("Element past the table throws",corrupt_throws(88,2));
+    tester.test("Shell past the table throws",corrupt_throws(112,1));
+    tester.test("Exponents past the table throws",corrupt_throws(160,1));
+    tester.test("Too many coefficients throws",corrupt_throws(144,4));
+    tester.test("Uncorrupted database opens",!corrupt_throws(144,1));
+    fs::resize_file(path,fs::file_size(path)-8);
+    threw=false;
+    try{BasisSetDatabase truncated(path);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Truncated database throws",threw);
+    std::ofstream(path)<<small_basis;
+    threw=false;
+    try{BasisSetDatabase not_db(path);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Text file throws",threw);
+    std::remove(path.c_str());
+
+    return tester.results();
+}
@@ -0,0 +1,207 @@
+#include "LibChemist/BasisSetExchangeParser.hpp"
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/detail_/JsonReader.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace LibChemist;
+using token_type=detail_::JsonReader::token_type;
+
+//A shortened BSE entry with the same shells as g94_example
+std::string bse_example=R"({
+  "molssi_bse_schema": {"schema_type": "complete", "schema_version": "0.1"},
+  "revision_description": "Data from \"the\" original\\\u00e9 \ud83d\ude00",
+  "name": "made-up",
+  "function_types": ["gto", "gto_spherical"],
+  "elements": {
+    "1": {
+      "references": [{"reference_description": "", "reference_keys": []}],
+      "electron_shells": [
+        {
+          "function_type": "gto",
+          "region": "valence",
+          "angular_momentum": [0],
+          "exponents": ["13.0100000", "1.9620000", "0.4446000"],
+          "coefficients": [["0.0196850", "0.1379770", "0.4781480"]]
+        },
+        {
+          "function_type": "gto",
+          "region": "valence",
+          "angular_momentum": [0],
+          "exponents": ["0.1220000"],
+          "coefficients": [["1.0000000"]]
+        }
+      ]
+    },
+    "6": {
+      "electron_shells": [
+        {
+          "angular_momentum": [0, 1],
+          "coefficients": [["0.1", "0.2"], [0.3, 4E-1]],
+          "exponents": [0.5, "0.25D0"],
+          "function_type": "gto_spherical"
+        }
+      ],
+      "ecp_electrons": 2,
+      "ecp_potentials": [{"angular_momentum": [0], "r_exponents": [2],
+                          "gaussian_exponents": ["1.0"],
+                          "coefficients": [["1.0"]], "ecp_type": "scalar_ecp"}]
+    },
+    "8": {"references": []},
+    "1": {
+      "electron_shells": [
+        {
+          "function_type": "gto",
+          "angular_momentum": [2],
+          "exponents": ["1.1"],
+          "coefficients": [["1.0"]]
+        }
+      ]
+    }
+  }
+}
+)";
+
+std::string g94_example=
+        "****\n"
+        "H     0 \n"
+        "S   3   1.00\n"
+        "     13.0100000              0.0196850        \n"
+        "      1.9620000              0.1379770        \n"
+        "      0.4446000              0.4781480        \n"
+        "S   1   1.00\n"
+        "      0.1220000              1.0000000        \n"
+        "****\n"
+        "C     0 \n"
+        "SP   2   1.00\n"
+        "      0.5   0.1   0.3\n"
+        "      0.25  0.2   0.4\n"
+        "****\n"
+        "H     0 \n"
+        "D   1   1.00\n"
+        "      1.1   1.0\n"
+        "****\n";
+
+//Pulls the bytes of data one at a time, so every token straddles a refill
+detail_::ByteSource trickle(const std::string& data)
+{
+    return [&data,pos=size_t(0)](char* buffer, size_t n) mutable {
+        if(pos==data.size() || !n)return size_t(0);
+        buffer[0]=data[pos++];
+        return size_t(1);
+    };
+}
+
+//Reads all the tokens of a document as "type:value" strings
+std::vector<std::string> tokens(detail_::JsonReader&& reader)
+{
+    std::vector<std::string> rv;
+    for(token_type t;(t=reader.next())!=token_type::end;)
+        rv.push_back(std::to_string(static_cast<int>(t))+":"+
+                     std::string(reader.value()));
+    return rv;
+}
+
+//True if reading all of json throws
+bool malformed(const std::string& json)
+{
+    try{tokens(detail_::JsonReader(json));}
+    catch(const std::runtime_error&){return true;}
+    return false;
+}
+
+int main()
+{
+    Tester tester("Testing Basis Set Exchange JSON parsing");
+
+    const std::string doc=R"( {"a" : [1, -2.5e3, "x\ny\"", true, null,
+                                      {}, []], "b":{"c":false}} )";
+    const auto corr_tokens=tokens(detail_::JsonReader(doc));
+    tester.test("JSON tokens",corr_tokens.size()==19 &&
+                corr_tokens[0]=="0:" && corr_tokens[1]=="4:a" &&
+                corr_tokens[4]=="6:-2.5e3" &&
+                corr_tokens[5]=="5:x\ny\"" && corr_tokens[7]=="7:null" &&
+                corr_tokens[13]=="4:b");
+    tester.test("JSON tokens, one byte at a time",
+                tokens(detail_::JsonReader(trickle(doc),1))==corr_tokens);
+    const std::string escapes=R"(["\u00e9\ud83d\ude00\/\\"])";
+    std::vector<std::string> escape_tokens=tokens(
+                detail_::JsonReader(trickle(escapes),1));
+    tester.test("JSON escapes",escape_tokens.size()==3 &&
+                escape_tokens[1]=="5:\xc3\xa9\xf0\x9f\x98\x80/\\");
+
+    bool all_threw=true;
+    for(const char* bad: {"{\"a\" 1}","{\"a\":1,}","[1 2]","[1,]","{1:2}",
+                          "[}","{\"a\":}","[\"abc","[1]]","[1] 2","[truth]",
+                          "[\"\\q\"]","[\"\\u12\"]",""})
+        all_threw=all_threw && malformed(bad);
+    tester.test("Malformed JSON throws",all_threw);
+
+    std::stringstream g94_ss(g94_example);
+    const auto corr=parse_basis_set_file(g94_ss,G94());
+    tester.test("Same shells as G94",
+                parse_bse_json_buffer(bse_example)==corr && corr.size()==2 &&
+                corr.at(1).size()==3);
+    std::stringstream ss(bse_example);
+    tester.test("Parse from stream",parse_bse_json(ss)==corr);
+
+    const std::string path("TestBasisSetExchangeParser.json");
+    std::ofstream(path)<<bse_example;
+    tester.test("Parse from file",parse_bse_json_file(path)==corr);
+#ifdef ENABLE_ZLIB
+    {
+        gzFile gz=gzopen(path.c_str(),"wb");
+        gzwrite(gz,bse_example.data(),bse_example.size());
+        gzclose(gz);
+    }
+    tester.test("Parse from gzip file",parse_bse_json_file(path)==corr);
+#endif
+    std::remove(path.c_str());
+
+    //General contractions and the other function types
+    const std::string general=R"({"elements": {"3": {"electron_shells": [
+        {"function_type": "gto_cartesian", "angular_momentum": [1],
+         "exponents": ["2.0", "1.0"],
+         "coefficients": [["0.1", "0.2"], ["0.3", "0.4"], ["0.5", "0.6"]]},
+        {"function_type": "sto", "angular_momentum": [0],
+         "exponents": ["1.5"], "coefficients": [["1.0"]]}]}}})";
+    const auto rv=parse_bse_json_buffer(general);
+    const BasisShell corr_general(ShellType::CartesianGaussian,1,3,
+                                  std::vector<double>({2.0,1.0}),
+                                  std::vector<double>({0.1,0.2,0.3,0.4,
+                                                       0.5,0.6}));
+    const BasisShell corr_sto(ShellType::Slater,0,1,
+                              std::vector<double>({1.5}),
+                              std::vector<double>({1.0}));
+    tester.test("General contraction",rv.size()==1 && rv.at(3).size()==2 &&
+                rv.at(3)[0]==corr_general && rv.at(3)[1]==corr_sto);
+
+    auto shell_throws=[](const std::string& shell){
+        try
+        {
+            parse_bse_json_buffer("{\"elements\": {\"1\": {\"electron_shells\""
+                                  ": ["+shell+"]}}}");
+        }
+        catch(const std::runtime_error&){return true;}
+        return false;
+    };
+    tester.test("Too few coefficients throws",shell_throws(
+        R"({"angular_momentum": [0], "exponents": ["1.0", "2.0"],
+            "coefficients": [["1.0"]]})"));
+    tester.test("Fused shell needs a contraction per momentum",shell_throws(
+        R"({"angular_momentum": [0, 1], "exponents": ["1.0"],
+            "coefficients": [["1.0"]]})"));
+    tester.test("Odd fused shell throws",shell_throws(
+        R"({"angular_momentum": [1, 2], "exponents": ["1.0"],
+            "coefficients": [["1.0"], ["1.0"]]})"));
+    tester.test("Unknown function type throws",shell_throws(
+        R"({"function_type": "gto_magic", "angular_momentum": [0],
+            "exponents": ["1.0"], "coefficients": [["1.0"]]})"));
+    tester.test("Truncated document throws",shell_throws(
+        R"({"angular_momentum": [0], "exponents": ["1.0"],)"));
+    return tester.results();
+}
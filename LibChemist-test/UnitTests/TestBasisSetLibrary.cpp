@@ -0,0 +1,64 @@
+#include "LibChemist/BasisSetLibrary.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace LibChemist;
+
+//Same file as TestBasisSetParser, plus a second H block to test merging
+std::string g94_example=
+        "! A header that should be ignored\n"
+        "\n"
+        "****\n"
+        "H     0 \n"
+        "S   3   1.00\n"
+        "     13.0100000              0.0196850        \n"
+        "      1.9620000              0.1379770        \n"
+        "      0.4446000              0.4781480        \n"
+        "****\n"
+        "C     0 \n"
+        "S   2   1.00\n"
+        "   6665.0000000              0.0006920        \n"
+        "   1000.0000000              0.0053290        \n"
+        "SP   1   1.00\n"
+        "    0.1687144              1.0000000              1.0000000 \n"
+        "****\n"
+        "H     0 \n"
+        "S   1   1.00\n"
+        "      0.1220000              1.0000000        \n"
+        "****\n";
+
+int main()
+{
+    Tester tester("Testing lazily loaded basis set libraries");
+
+    const std::string path("TestBasisSetLibrary.g94");
+    std::ofstream(path)<<g94_example;
+    const auto corr=parse_basis_set_file(path,G94());
+
+    G94 parser;
+    BasisSetLibrary lib(path,parser);
+    std::remove(path.c_str());
+    tester.test("Elements",lib.elements()==std::vector<size_t>({1,6}));
+    tester.test("Count",lib.count(1) && lib.count(6) && !lib.count(8));
+    tester.test("Shells split over blocks",lib.shells(1)==corr.at(1));
+    tester.test("Shells",lib.shells(6)==corr.at(6));
+    tester.test("Cached shells",&lib.shells(6)==&lib.shells(6));
+    bool threw=false;
+    try{lib.shells(8);}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Missing element throws",threw);
+
+    //H2O, O is not in the library and should be skipped
+    SetOfAtoms h2o;
+    h2o.insert(create_atom({0.0,0.0,0.0},8));
+    h2o.insert(create_atom({0.0,1.4,1.1},1));
+    h2o.insert(create_atom({0.0,-1.4,1.1},1));
+    std::map<size_t,std::vector<BasisShell>> h2o_corr;
+    h2o_corr[1]=corr.at(1);
+    tester.test("Basis set for SetOfAtoms",lib.basis_set(h2o)==h2o_corr);
+    tester.test("Apply basis set",apply_basis_set("bs",lib,h2o)==
+                                  apply_basis_set("bs",corr,h2o));
+
+    return tester.results();
+}
@@ -1,5 +1,12 @@
 #include "LibChemist/BasisSetParser.hpp"
 #include "TestHelpers.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace LibChemist;
 
@@ -33,11 +40,31 @@ std::string g94_example=
         "      0.1510000              1.0000000        \n"
         "SP   1   1.00\n"
         "    0.1687144              1.0000000              1.0000000 \n"
+        "SP   2   1.00\n"
+        "    0.5000000              0.1000000              0.2000000 \n"
+        "    0.2500000              0.3000000              0.4000000 \n"
         "****\n"
         "\n"
         "\n"
         "\n";
 
+//Fortran-style exponents, negative coefficients, and an ECP block to skip
+std::string g94_fortran=
+        "****\n"
+        "LI     0\n"
+        "S   2   1.00\n"
+        "  0.6424189150D+03 -0.2142607810D-02\n"
+        "  9.671465E+01      1.620887D-02\n"
+        "****\n"
+        "LI     0\n"
+        "LI-ECP     1      2\n"
+        "p potential\n"
+        "  1\n"
+        "2      1.0000000              0.0000000\n"
+        "s-p potential\n"
+        "  1\n"
+        "0     30.2200000              3.0000000\n";
+
 int main()
 {
     Tester tester("Testing basis set parsing capabilities");
@@ -65,9 +92,120 @@ int main()
                 BasisShell(ShellType::SphericalGaussian,-1,2,
                            std::vector<double>({0.1687144}),
                            std::vector<double>({1.0000000,1.000000})));
+    g94_corr[6].push_back(
+                BasisShell(ShellType::SphericalGaussian,-1,2,
+                           std::vector<double>({0.5,0.25}),
+                           std::vector<double>({0.1,0.3,0.2,0.4})));
     std::stringstream ss(g94_example);
     auto rv=parse_basis_set_file(ss,G94());
     tester.test("Gaussian94 parser",rv==g94_corr);
 
+    std::stringstream ss2(g94_fortran);
+    auto rv2=parse_basis_set_file(ss2,G94());
+    const BasisShell& li=rv2[3][0];
+    tester.test("Gaussian94 parser, Fortran exponents",
+                rv2.size()==1 && rv2[3].size()==1 && li.nprim==2 &&
+                std::fabs(li.alpha(0)-642.4189150)<1E-10 &&
+                std::fabs(li.alpha(1)-96.71465)<1E-10 &&
+                std::fabs(li.coef(0,0)+0.002142607810)<1E-14 &&
+                std::fabs(li.coef(1,0)-0.01620887)<1E-14);
+
+    const std::string g94_file("TestBasisSetParser.g94");
+    std::ofstream(g94_file)<<g94_example;
+    tester.test("Gaussian94 parser, from file",
+                parse_basis_set_file(g94_file,G94())==g94_corr);
+
+    //Large enough that each thread gets a chunk, repeated elements test merging
+    std::ofstream big(g94_file);
+    for(size_t i=0;i<300;++i)
+        big<<g94_example;
+    big.close();
+    const auto serial=parse_basis_set_file(g94_file,G94());
+    tester.test("Gaussian94 parser, 4 threads",
+                serial.at(6).size()==300*g94_corr[6].size() &&
+                parse_basis_set_file(g94_file,G94(),4)==serial);
+    tester.test("Gaussian94 parser, pipelined",
+                parse_basis_set_file(g94_file,G94(),ReadMode::pipelined)==
+                serial);
+    std::remove(g94_file.c_str());
+
+#ifdef ENABLE_ZLIB
+    //Two gzip members, each spanning several decompression chunks
+    const std::string gz_file=g94_file+".gz";
+    for(const char* mode: {"wb","ab"})
+    {
+        gzFile gz=gzopen(gz_file.c_str(),mode);
+        for(size_t i=0;i<150;++i)
+            gzwrite(gz,g94_example.data(),g94_example.size());
+        gzclose(gz);
+    }
+    tester.test("Gaussian94 parser, gzip",
+                parse_basis_set_file(gz_file,G94())==serial &&
+                parse_basis_set_file(gz_file,G94(),4)==serial &&
+                parse_basis_set_file(gz_file,G94(),ReadMode::pipelined)==
+                serial);
+    //Cut the first member short
+    std::filesystem::resize_file(gz_file,std::filesystem::file_size(gz_file)/3);
+    bool gz_threw=false;
+    try{parse_basis_set_file(gz_file,G94());}
+    catch(const std::runtime_error&){gz_threw=true;}
+    tester.test("Gaussian94 parser, truncated gzip throws",gz_threw);
+    gz_threw=false;
+    try{parse_basis_set_file(gz_file,G94(),ReadMode::pipelined);}
+    catch(const std::runtime_error&){gz_threw=true;}
+    tester.test("Gaussian94 parser, pipelined truncated gzip throws",gz_threw);
+    std::remove(gz_file.c_str());
+#endif
+    bool threw=false;
+    try{parse_basis_set_file(g94_file,G94());}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Missing file throws",threw);
+
+    //The map-based interface is an adapter over the callbacks
+    using data_type=BasisSetFileParser::data_type;
+    using action_type=BasisSetFileParser::action_type;
+    G94 g94;
+    auto data=g94.parse("    0.1687144    1.0000000    2.0000000 ");
+    tester.test("G94 map interface, primitive",
+                g94.worth_parsing("  0.1687144  1.0  2.0")==
+                    action_type::same_shell &&
+                data.at(data_type::exponent)==std::vector<double>({0.1687144})
+                && data.at(data_type::coefficient)==
+                    std::vector<double>({1.0,2.0}));
+    data=g94.parse("SP   2   1.00");
+    tester.test("G94 map interface, shell",
+                g94.worth_parsing("SP   2   1.00")==action_type::new_shell &&
+                data.at(data_type::angular_momentum)[0]==-1);
+    data=g94.parse("He 0");
+    tester.test("G94 map interface, atom",
+                g94.worth_parsing("He 0")==action_type::new_atom &&
+                data.at(data_type::Z)[0]==2);
+    tester.test("G94 map interface, junk",
+                g94.worth_parsing("****")==action_type::none &&
+                g94.parse("****").empty());
+
+    //A parser written against the map-based interface still works
+    struct MapG94: public MapBasisSetFileParser {
+        G94 impl;
+        action_type worth_parsing(const std::string& line)const override
+        {
+            return impl.worth_parsing(line);
+        }
+        std::map<data_type,std::vector<double>>
+        parse(const std::string& line)const override
+        {
+            return impl.BasisSetFileParser::parse(line);
+        }
+    };
+    std::stringstream ss3(g94_example);
+    tester.test("Map-based parser",
+                parse_basis_set_file(ss3,MapG94())==g94_corr);
+
+    //A parser has to implement one of the two interfaces to be usable
+    struct NoG94: public BasisSetFileParser {};
+    struct NoMapG94: public MapBasisSetFileParser {};
+    static_assert(std::is_abstract_v<NoG94> && std::is_abstract_v<NoMapG94> &&
+                  !std::is_abstract_v<MapG94>);
+
     return tester.results();
 }
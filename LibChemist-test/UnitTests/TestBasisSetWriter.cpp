@@ -0,0 +1,63 @@
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/BasisSetWriter.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+
+using namespace LibChemist;
+using basis_type=std::map<size_t,std::vector<BasisShell>>;
+
+int main()
+{
+    Tester tester("Testing basis set writers");
+
+    basis_type basis;
+    basis[1].push_back(BasisShell(ShellType::SphericalGaussian,0,1,
+                                  std::vector<double>({13.01,1.962,0.4446}),
+                                  std::vector<double>({0.019685,0.137977,
+                                                       0.478148})));
+    //Integer-valued exponents must still read back as exponents
+    basis[8].push_back(BasisShell(ShellType::SphericalGaussian,0,1,
+                                  std::vector<double>({5484.0,1E-3}),
+                                  std::vector<double>({1.0/3.0,1.0})));
+    basis[8].push_back(BasisShell(ShellType::SphericalGaussian,-1,2,
+                                  std::vector<double>({0.1}),
+                                  std::vector<double>({0.25,-1E-300})));
+    basis[8].push_back(BasisShell(ShellType::SphericalGaussian,2,1,
+                                  std::vector<double>({1.2}),
+                                  std::vector<double>({1.0})));
+
+    std::string buffer;
+    append_g94(basis,buffer);
+    tester.test("Formatted G94",
+                buffer=="****\nH 0\nS 3 1.00\n13.01 0.019685\n"
+                        "1.962 0.137977\n0.4446 0.478148\n****\n"
+                        "O 0\nS 2 1.00\n5484.0 0.3333333333333333\n"
+                        "0.001 1.0\nSP 1 1.00\n0.1 0.25 -1e-300\n"
+                        "D 1 1.00\n1.2 1.0\n****\n");
+
+    const std::string path("TestBasisSetWriter.g94");
+    write_g94_file(path,basis);
+    tester.test("Exact round trip",parse_basis_set_file(path,G94())==basis);
+
+    basis_type empty;
+    write_g94_file(path,empty);
+    tester.test("Empty basis set",parse_basis_set_file(path,G94()).empty());
+    std::remove(path.c_str());
+
+    basis_type general;
+    general[1].push_back(BasisShell(ShellType::SphericalGaussian,0,2,
+                                    std::vector<double>({1.0}),
+                                    std::vector<double>({0.5,0.5})));
+    bool threw=false;
+    try{append_g94(general,buffer);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("General contraction throws",threw);
+
+    basis_type unknown;
+    unknown[200]=basis[1];
+    threw=false;
+    try{append_g94(unknown,buffer);}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Unknown element throws",threw);
+    return tester.results();
+}
@@ -0,0 +1,152 @@
+#include "LibChemist/BiomoleculeParser.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace LibChemist;
+
+//Two chains, an alternate location, an insertion code, and no element for O
+const std::string pdb_atoms=
+"ATOM      1  N   ALA A   1       1.000   2.000   3.000  1.00  0.00           N\n"
+"ATOM      2  CA AALA A   1       1.500   2.000   3.000  1.00  0.00           C\n"
+"ATOM      3  CA BALA A   1       1.600   2.000   3.000  1.00  0.00           C\n"
+"ATOM      4  N   GLY A   2       2.000   2.000   3.000  1.00  0.00           N\n"
+"ATOM      5  N   GLY A   2A      2.500   2.000   3.000  1.00  0.00           N\n"
+"TER\n"
+"HETATM    6 FE   HEM B   1      -1.000   0.000   0.250  1.00  0.00          FE\n"
+"HETATM    7  O   HOH B   2       0.000  -1.000   0.500  1.00  0.00            \n";
+
+const std::string pdb_example=
+"HEADER    TEST\n"
+"MODEL        1\n"+pdb_atoms+
+"ENDMDL\n"
+"MODEL        2\n"
+"ATOM      1  N   ALA A   1       9.000   9.000   9.000  1.00  0.00           N\n"
+"ENDMDL\n"
+"END\n";
+
+//The same system, with the chains under label_asym_id differing from the
+//author's
+const std::string mmcif_example=
+"data_TEST\n"
+"#\n"
+"_entry.id TEST\n"
+"#\n"
+"loop_\n"
+"_atom_site.group_PDB\n"
+"_atom_site.id\n"
+"_atom_site.type_symbol\n"
+"_atom_site.label_atom_id\n"
+"_atom_site.label_alt_id\n"
+"_atom_site.label_comp_id\n"
+"_atom_site.label_asym_id\n"
+"_atom_site.label_seq_id\n"
+"_atom_site.pdbx_PDB_ins_code\n"
+"_atom_site.Cartn_x\n"
+"_atom_site.Cartn_y\n"
+"_atom_site.Cartn_z\n"
+"_atom_site.auth_seq_id\n"
+"_atom_site.auth_asym_id\n"
+"_atom_site.pdbx_PDB_model_num\n"
+"ATOM 1 N N . ALA C 1 ? 1.000 2.000 3.000 1 A 1\n"
+"ATOM 2 C CA A ALA C 1 ? 1.500 2.000 3.000 1 A 1\n"
+"ATOM 3 C CA B ALA C 1 ? 1.600 2.000 3.000 1 A 1\n"
+"ATOM 4 N N . GLY C 2 ? 2.000 2.000 3.000 2 A 1\n"
+"ATOM 5 N N . GLY C 2 A 2.500 2.000 3.000 2 A 1\n"
+"HETATM 6 FE FE . HEM D . ? -1.000 0.000 0.250 1 B 1\n"
+"HETATM 7 O 'O' . HOH E . ? 0.000 -1.000 0.500 2 B 1\n"
+"ATOM 8 N N . ALA C 1 ? 9.000 9.000 9.000 1 A 2\n"
+"#\n"
+"loop_\n"
+"_atom_type.symbol\n"
+"C\n";
+
+int main()
+{
+    Tester tester("Testing PDB and mmCIF parsing");
+
+    const double angstrom2bohr=1.0/0.52917721067;
+    Biomolecule corr;
+    for(auto ai: std::vector<std::pair<size_t,std::array<double,3>>>{
+            {7,{1.0,2.0,3.0}},{6,{1.5,2.0,3.0}},{7,{2.0,2.0,3.0}},
+            {7,{2.5,2.0,3.0}},{26,{-1.0,0.0,0.25}},{8,{0.0,-1.0,0.5}}})
+    {
+        for(double& x: ai.second)x*=angstrom2bohr;
+        corr.atoms.push_back(create_atom(ai.second,ai.first));
+    }
+    corr.atom_names={"N","CA","N","N","FE","O"};
+    corr.atom_residue={0,0,1,2,3,4};
+    corr.residue_names={"ALA","GLY","GLY","HEM","HOH"};
+    corr.residue_numbers={1,2,2,1,2};
+    corr.residue_chain={0,0,0,1,1};
+    corr.chain_ids={"A","B"};
+
+    Biomolecule pdb=parse_pdb_buffer(pdb_example,1);
+    tester.test("PDB atoms",pdb.atoms.size()==6 &&
+                are_same(pdb.atoms[4].coord,corr.atoms[4].coord,1E-10) &&
+                pdb.atoms[4].Z==26.0 && pdb.atoms[5].Z==8.0);
+    tester.test("PDB residues and chains",pdb.atom_residue==corr.atom_residue &&
+                pdb.residue_numbers==corr.residue_numbers &&
+                pdb.residue_chain==corr.residue_chain &&
+                pdb.chain_ids==corr.chain_ids);
+    tester.test("PDB file",corr==pdb);
+
+    Biomolecule cif=parse_mmcif_buffer(mmcif_example,1);
+    tester.test("mmCIF file",corr==cif);
+
+    //The model number comes from the first row, not the blank line before it
+    std::string blank_cif(mmcif_example);
+    blank_cif.insert(blank_cif.find("ATOM 1 "),"\n");
+    tester.test("mmCIF blank line before rows",
+                corr==parse_mmcif_buffer(blank_cif,1));
+
+    //Enough copies that the file is split between threads, with chunk
+    //boundaries falling inside residues and chains
+    std::string big_pdb, big_cif(mmcif_example.substr(0,
+                                 mmcif_example.find("ATOM 1 ")));
+    const std::string cif_rows=mmcif_example.substr(big_cif.size(),
+                                mmcif_example.find("ATOM 8 ")-big_cif.size());
+    for(size_t i=0;i<2000;++i)
+    {
+        big_pdb+=pdb_atoms;
+        big_cif+=cif_rows;
+    }
+    const Biomolecule big=parse_pdb_buffer(big_pdb,1);
+    tester.test("Many copies, residues and chains",
+                big.atoms.size()==6*2000 && big.nresidues()==5*2000 &&
+                big.nchains()==2*2000 && big.atom_residue.back()==5*2000-1);
+    tester.test("PDB, parallel == serial",big==parse_pdb_buffer(big_pdb,4));
+    tester.test("mmCIF, parallel == serial",
+                big==parse_mmcif_buffer(big_cif,4));
+
+    const std::string pdb_file("TestBiomoleculeParser.pdb");
+    std::ofstream(pdb_file)<<pdb_example;
+    tester.test("PDB file from disk",corr==parse_pdb_file(pdb_file));
+    std::remove(pdb_file.c_str());
+
+#ifdef ENABLE_ZLIB
+    const std::string gz_file("TestBiomoleculeParser.cif.gz");
+    gzFile gz=gzopen(gz_file.c_str(),"wb");
+    gzwrite(gz,big_cif.data(),big_cif.size());
+    gzclose(gz);
+    tester.test("Gzipped mmCIF file from disk",big==parse_mmcif_file(gz_file,2));
+    std::remove(gz_file.c_str());
+#endif
+
+    bool failed=false;
+    try{parse_mmcif_buffer("data_TEST\n_entry.id TEST\n");}
+    catch(const std::runtime_error&){failed=true;}
+    tester.test("mmCIF without atom_site throws",failed);
+
+    failed=false;
+    try{parse_mmcif_buffer(mmcif_example.substr(0,mmcif_example.find("ATOM 2 ")-
+                                                  10)+"\n");}
+    catch(const std::runtime_error&){failed=true;}
+    tester.test("Short mmCIF row throws",failed);
+
+    return tester.results();
+}
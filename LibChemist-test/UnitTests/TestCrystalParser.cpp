@@ -0,0 +1,186 @@
+#include "LibChemist/CrystalParser.hpp"
+#include "TestHelpers.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace LibChemist;
+
+//A made-up monoclinic crystal, with atoms on general and special positions
+std::string cif_example=
+"# A comment\n"
+"data_made_up\n"
+"_audit_creation_method 'by hand'\n"
+"_publ_section_abstract\n"
+";\n"
+"Text fields can hold anything, even _tags and loop_\n"
+";\n"
+"_cell_length_a    10.000(2)\n"
+"_cell_length_b    8.0\n"
+"_cell_length_c    6.00\n"
+"_cell_angle_alpha 90\n"
+"_cell_angle_beta  100.0(1)\n"
+"_cell_angle_gamma 90\n"
+"_symmetry_space_group_name_H-M 'P 1 21/c 1'\n"
+"loop_\n"
+"_symmetry_equiv_pos_site_id\n"
+"_symmetry_equiv_pos_as_xyz\n"
+"1 x,y,z\n"
+"2 '-x, y+1/2, -z+1/2'\n"
+"3 '-x,-y,-z'\n"
+"4 'x, -y+1/2, z+1/2'  # another comment\n"
+"loop_\n"
+"_atom_site_label\n"
+"_atom_site_type_symbol\n"
+"_atom_site_fract_x\n"
+"_atom_site_fract_y\n"
+"_atom_site_fract_z\n"
+"_atom_site_occupancy\n"
+"C1 C 0.1000(3) 0.2 0.3 1\n"
+"Fe1 Fe3+ 0 0 0 1\n"
+"O1 ? 0.5 0.5 0.5 1\n"
+"data_second_block\n"
+"_cell_length_a 1.0\n";
+
+bool close(const std::array<double,3>& a, const std::array<double,3>& b)
+{
+    for(size_t i=0;i<3;++i)
+        if(std::fabs(a[i]-b[i])>1E-10)return false;
+    return true;
+}
+
+bool throws(const std::string& cif)
+{
+    try{parse_cif_buffer(cif);}
+    catch(const std::runtime_error&){return true;}
+    return false;
+}
+
+int main()
+{
+    Tester tester("Testing CIF crystal reader");
+    const double a2b=1.0/0.52917721067;
+
+    const SymmetryOperator op=parse_symmetry_operator("x-y, -X+1/2 , 0.25+z");
+    tester.test("Symmetry operator",
+                op.rotation[0]==std::array<double,3>({1,-1,0}) &&
+                op.rotation[1]==std::array<double,3>({-1,0,0}) &&
+                op.rotation[2]==std::array<double,3>({0,0,1}) &&
+                op.shift==std::array<double,3>({0,0.5,0.25}));
+    bool all_threw=true;
+    for(const char* bad: {"x,y","x,y,z,x","x,,z","x,y,w","x,y,1/0","x,y,+"})
+    {
+        bool threw=false;
+        try{parse_symmetry_operator(bad);}
+        catch(const std::runtime_error&){threw=true;}
+        all_threw=all_threw && threw;
+    }
+    tester.test("Malformed symmetry operators throw",all_threw);
+
+    const Crystal crystal=parse_cif_buffer(cif_example);
+    const UnitCell& cell=crystal.cell;
+    tester.test("Unit cell",cell.lengths[0]==10.0*a2b &&
+                cell.lengths[2]==6.0*a2b && cell.angles[1]==100.0 &&
+                cell.space_group=="P 1 21/c 1");
+    const auto M=cell.fractional_to_cartesian();
+    auto cart=[&](double x, double y, double z){
+        std::array<double,3> r;
+        for(size_t i=0;i<3;++i)r[i]=M[i][0]*x+M[i][1]*y+M[i][2]*z;
+        return r;
+    };
+    tester.test("Fractional to Cartesian",
+                close(cart(0,0,1),{6.0*a2b*std::cos(100.0*M_PI/180.0),0.0,
+                                   6.0*a2b*std::sin(100.0*M_PI/180.0)}) &&
+                close(cart(1,1,0),{10.0*a2b,8.0*a2b,0.0}));
+
+    //4 copies of C, 2 of each of the atoms on inversion centers
+    const SetOfAtoms& atoms=crystal.atoms;
+    tester.test("Special positions merged",crystal.nasymmetric==3 &&
+                atoms.size()==8);
+    const std::vector<std::array<double,3>> corr_r({
+        cart(0.1,0.2,0.3),cart(0,0,0),cart(0.5,0.5,0.5),
+        cart(0.9,0.7,0.2),cart(0,0.5,0.5),cart(0.5,0,0),
+        cart(0.9,0.8,0.7),cart(0.1,0.3,0.8)});
+    const std::vector<double> corr_Z({6,26,8,6,26,8,6,6});
+    bool same=true;
+    for(size_t i=0;i<atoms.size();++i)
+        same=same && atoms[i].Z==corr_Z[i] && close(atoms[i].coord,corr_r[i]);
+    tester.test("Expanded cell",same);
+
+    //Rounded special positions, and P 1 without operators
+    const std::string rounded=
+        "data_x\n_cell_length_a 10\n_cell_length_b 10\n_cell_length_c 10\n"
+        "_cell_angle_alpha 90\n_cell_angle_beta 90\n_cell_angle_gamma 120\n"
+        "loop_\n_space_group_symop_operation_xyz\nx,y,z\n-y,x-y,z\n"
+        "-x+y,-x,z\nloop_\n_atom_site_label\n_atom_site_fract_x\n"
+        "_atom_site_fract_y\n_atom_site_fract_z\nCl1 0.33333 0.66667 0.99999\n"
+        "C1 0.1 0.2 0.0\n";
+    const Crystal hexagonal=parse_cif_buffer(rounded);
+    tester.test("Rounded special position",hexagonal.atoms.size()==4 &&
+                hexagonal.atoms[0].Z==17.0 && hexagonal.atoms[1].Z==6.0 &&
+                std::fabs(hexagonal.atoms[0].coord[2]-9.9999*a2b)<1E-10);
+    tester.test("Tight tolerance keeps copies",
+                parse_cif_buffer(rounded,1E-6).atoms.size()==6);
+
+    //Atoms near a face stay put, and only same-element atoms across a face
+    //are copies, even if they are near different faces
+    const std::string faces=
+        "data_x\n_cell_length_a 10\n_cell_length_b 10\n_cell_length_c 10\n"
+        "_cell_angle_alpha 90\n_cell_angle_beta 90\n_cell_angle_gamma 90\n"
+        "loop_\n_atom_site_label\n_atom_site_fract_x\n_atom_site_fract_y\n"
+        "_atom_site_fract_z\nC1 0.5 0.5 0.998\nO1 0.001 0.999 0.5\n"
+        "O2 0.999 0.001 0.5\nN1 0.999 0.5 0.2\nC2 0.001 0.5 0.2\n";
+    const SetOfAtoms near_faces=parse_cif_buffer(faces).atoms;
+    tester.test("Atom near a face is not moved",
+                near_faces.size()==4 &&
+                close(near_faces[0].coord,{5.0*a2b,5.0*a2b,9.98*a2b}));
+    tester.test("Copies across a face merged",
+                near_faces[1].Z==8.0 && near_faces[2].Z==7.0 &&
+                near_faces[3].Z==6.0 &&
+                close(near_faces[1].coord,{0.01*a2b,9.99*a2b,5.0*a2b}));
+
+    std::string p1(rounded);
+    p1.erase(p1.find("loop_\n_space"),p1.find("loop_\n_atom")-
+                                      p1.find("loop_\n_space"));
+    tester.test("P 1 without operators",
+                parse_cif_buffer(p1).atoms.size()==2 &&
+                throws(p1+"_symmetry_space_group_name_H-M 'P -1'\n"));
+    std::string no_cell(rounded);
+    no_cell.erase(no_cell.find("_cell_length_b"),17);
+    tester.test("Missing cell throws",throws(no_cell));
+    tester.test("Ragged loop throws",throws(rounded+"C2 0.1\n"));
+
+    //A big asymmetric unit, which O(N^2) merging would make slow
+    std::stringstream big;
+    big<<"data_big\n_cell_length_a 200\n_cell_length_b 200\n"
+       <<"_cell_length_c 200\n_cell_angle_alpha 90\n_cell_angle_beta 90\n"
+       <<"_cell_angle_gamma 90\nloop_\n_symmetry_equiv_pos_as_xyz\n"
+       <<"x,y,z\n-x,-y,-z\nx+1/2,y+1/2,z+1/2\n-x+1/2,-y+1/2,-z+1/2\n"
+       <<"loop_\n_atom_site_type_symbol\n_atom_site_fract_x\n"
+       <<"_atom_site_fract_y\n_atom_site_fract_z\n";
+    for(size_t i=0;i<5000;++i)
+        big<<"C "<<0.001+i%17*0.029<<" "<<0.002+i%19*0.026<<" "
+           <<0.003+i/323*0.03<<"\n";
+    Timer timer;
+    const Crystal big_crystal=parse_cif_buffer(big.str());
+    std::cout<<"Expanded 20000 atoms in (s): "<<timer.get_time()<<std::endl;
+    tester.test("Big cell",big_crystal.atoms.size()==20000);
+
+    const std::string path("TestCrystalParser.cif");
+    std::ofstream(path)<<cif_example;
+    tester.test("From file",parse_cif_file(path).atoms==atoms);
+    std::remove(path.c_str());
+#ifdef ENABLE_ZLIB
+    const std::string gz_path=path+".gz";
+    gzFile gz=gzopen(gz_path.c_str(),"wb");
+    gzwrite(gz,cif_example.data(),cif_example.size());
+    gzclose(gz);
+    tester.test("From gzipped file",parse_cif_file(gz_path).atoms==atoms);
+    std::remove(gz_path.c_str());
+#endif
+    return tester.results();
+}
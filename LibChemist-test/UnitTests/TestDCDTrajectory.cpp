@@ -0,0 +1,153 @@
+#include "LibChemist/DCDTrajectory.hpp"
+#include "TestHelpers.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace LibChemist;
+
+//Writes the words of a DCD file in either byte order
+struct DCDWriter {
+    std::ofstream os;
+    bool swap;
+
+    DCDWriter(const std::string& path, bool swap_):
+        os(path,std::ios::binary),swap(swap_)
+    {}
+
+    void bytes(const void* data, size_t n)
+    {
+        const char* p=static_cast<const char*>(data);
+        if(!swap)
+        {
+            os.write(p,n);
+            return;
+        }
+        for(size_t i=n;i>0;--i)os.put(p[i-1]);
+    }
+    void word(std::uint32_t x){bytes(&x,4);}
+    void real(float x){bytes(&x,4);}
+    void real8(double x){bytes(&x,8);}
+};
+
+//Writes a CHARMM-style trajectory, frames[i][j] being atom j of frame i
+void write_dcd(const std::string& path,
+               const std::vector<std::vector<std::array<float,3>>>& frames,
+               bool cell, bool swap, std::uint32_t nset)
+{
+    const std::uint32_t natoms=frames[0].size();
+    DCDWriter w(path,swap);
+    w.word(84);
+    w.os.write("CORD",4);
+    for(std::uint32_t j=0;j<20;++j)
+    {
+        if(j==9)w.real(0.5f);
+        else w.word(j==0 ? nset : j==10 ? cell : j==19 ? 24 : 0);
+    }
+    w.word(84);
+    w.word(4+80);
+    w.word(1);
+    w.os<<std::string(80,'t');
+    w.word(4+80);
+    w.word(4);
+    w.word(natoms);
+    w.word(4);
+    for(size_t i=0;i<frames.size();++i)
+    {
+        if(cell)
+        {
+            w.word(48);
+            for(size_t j=0;j<6;++j)w.real8(10.0*i+j);
+            w.word(48);
+        }
+        for(size_t k=0;k<3;++k)
+        {
+            w.word(4*natoms);
+            for(const auto& xyz: frames[i])w.real(xyz[k]);
+            w.word(4*natoms);
+        }
+    }
+}
+
+int main()
+{
+    Tester tester("Testing DCD trajectory reader");
+    const double a2b=1.0/0.52917721067;
+
+    std::vector<std::vector<std::array<float,3>>> frames(3);
+    for(size_t i=0;i<frames.size();++i)
+        for(size_t j=0;j<4;++j)
+            frames[i].push_back({0.5f*i,1.25f*j,-0.125f*(i+j)});
+    SetOfAtoms templ;
+    for(size_t j=0;j<4;++j)
+        templ.push_back(create_atom({0.0,0.0,0.0},j%2 ? 1 : 8));
+    templ.charge=-1.0;
+
+    const std::string path("TestDCDTrajectory.dcd");
+    //Native and swapped byte orders, with and without unit cells
+    for(bool swap: {false,true})
+        for(bool cell: {false,true})
+        {
+            const std::string name=std::string(swap ? "swapped" : "native")+
+                                   (cell ? ", unit cell" : "");
+            write_dcd(path,frames,cell,swap,0);
+            DCDTrajectory traj(path);
+            tester.test("Header, "+name,traj.size()==3 && traj.natoms()==4 &&
+                        traj.timestep()==0.5 && traj.has_unit_cell()==cell &&
+                        traj.native_byte_order()==!swap);
+            SetOfAtoms frame(templ);
+            bool same=true;
+            for(size_t i=0;i<3;++i)
+            {
+                traj.patch(i,frame);
+                for(size_t j=0;j<4;++j)
+                    for(size_t k=0;k<3;++k)
+                        same=same && frame[j].coord[k]==frames[i][j][k]*a2b;
+            }
+            tester.test("Patched coordinates, "+name,same &&
+                        frame[0].Z==8.0 && frame.charge==-1.0 &&
+                        traj.frame(2,templ)==frame);
+            if(cell)
+                tester.test("Unit cell, "+name,traj.unit_cell(2)==
+                            std::array<double,6>({20,21,22,23,24,25}));
+            if(swap)continue;
+            const DCDFrame view=traj.frame_view(2);
+            tester.test("Frame views, "+name,view.x.size()==4 &&
+                        view.x[3]==frames[2][3][0] &&
+                        view.y[3]==frames[2][3][1] &&
+                        view.z.to_vector()==std::vector<float>(
+                            {-0.25f,-0.375f,-0.5f,-0.625f}));
+        }
+
+    //A frame that is still being written doesn't count, whatever NSET says
+    write_dcd(path,frames,true,false,1000);
+    {
+        std::ofstream(path,std::ios::app|std::ios::binary)<<"partial";
+    }
+    DCDTrajectory partial(path);
+    bool threw=false;
+    try{partial.patch(3,templ);}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Partial frame ignored",partial.size()==3 && threw);
+
+    threw=false;
+    SetOfAtoms too_small;
+    try{partial.patch(0,too_small);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Wrong number of atoms throws",threw);
+
+    write_dcd(path,frames,false,true,3);
+    threw=false;
+    try{DCDTrajectory(path).frame_view(0);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Swapped views throw",threw);
+
+    std::ofstream(path)<<std::string(200,'x');
+    threw=false;
+    try{DCDTrajectory traj(path);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Not a DCD file throws",threw);
+    std::remove(path.c_str());
+    return tester.results();
+}
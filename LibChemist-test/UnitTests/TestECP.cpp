@@ -0,0 +1,128 @@
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/SetOfAtoms.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace LibChemist;
+
+//A basis set with ECPs on Na and Pt (numbers are made up), and none on H
+std::string g94_ecp=
+        "****\n"
+        "H     0\n"
+        "S   1   1.00\n"
+        "      0.1220000              1.0000000\n"
+        "****\n"
+        "PT     0\n"
+        "S   2   1.00\n"
+        "      2.5470000             -0.5620000\n"
+        "      1.0000000              1.2000000\n"
+        "****\n"
+        "\n"
+        "NA     0\n"
+        "NA-ECP     1     10\n"
+        "p potential\n"
+        "  1\n"
+        "2      1.0000000              0.0000000\n"
+        "s-p potential\n"
+        "  2\n"
+        "0      2.5000000              3.0000000\n"
+        "2      0.9000000             -1.5000000\n"
+        "PT     0\n"
+        "PT-ECP     2     60\n"
+        "d potential\n"
+        "  2\n"
+        "1    100.0000000            -10.0000000\n"
+        "2     20.0000000             -5.0000000\n"
+        "s-d potential\n"
+        "  1\n"
+        "2      5.0000000             50.0000000\n"
+        "p-d potential\n"
+        "  3\n"
+        "0     30.0000000              3.0000000\n"
+        "1      3.0000000             30.0000000\n"
+        "2      0.3000000              0.3000000\n"
+        "\n";
+
+int main()
+{
+    Tester tester("Testing effective core potentials");
+
+    ECP corr_na;
+    corr_na.ncore=10;
+    corr_na.lmax=1;
+    corr_na.offsets={0,2,3};
+    corr_na.powers={0,2,2};
+    corr_na.alphas={2.5,0.9,1.0};
+    corr_na.coefs={3.0,-1.5,0.0};
+    ECP corr_pt;
+    corr_pt.ncore=60;
+    corr_pt.lmax=2;
+    corr_pt.offsets={0,1,4,6};
+    corr_pt.powers={2,0,1,2,1,2};
+    corr_pt.alphas={5.0,30.0,3.0,0.3,100.0,20.0};
+    corr_pt.coefs={50.0,3.0,30.0,0.3,-10.0,-5.0};
+
+    std::stringstream ss(g94_ecp);
+    const auto ecps=parse_ecp_file(ss,G94());
+    tester.test("Parsed ECPs",ecps.size()==2 && ecps.at(11)==corr_na &&
+                ecps.at(78)==corr_pt);
+    tester.test("Channels",corr_pt.nterms()==6 && corr_pt.nterms(0)==1 &&
+                corr_pt.nterms(1)==3 && corr_pt.nterms(2)==2 &&
+                !corr_pt.empty() && ECP().empty());
+    tester.test("ECP from buffer",parse_ecp_buffer(g94_ecp,G94())==ecps);
+
+    //The basis set part is unaffected by the ECPs
+    std::stringstream ss2(g94_ecp);
+    const auto shells=parse_basis_set_file(ss2,G94());
+    tester.test("Shells next to ECPs",shells.size()==2 &&
+                shells.at(1).size()==1 && shells.at(78).size()==1 &&
+                shells.at(78)[0].nprim==2);
+
+    const std::string g94_file("TestECP.g94");
+    std::ofstream(g94_file)<<g94_ecp;
+    tester.test("ECP from file",
+                parse_ecp_file(g94_file,G94())==ecps &&
+                parse_ecp_file(g94_file,G94(),ReadMode::pipelined)==ecps);
+    std::remove(g94_file.c_str());
+
+    //Core electrons come off the electron count, once
+    SetOfAtoms atoms;
+    atoms.insert(create_atom({0.0,0.0,0.0},78));
+    atoms.insert(create_atom({0.0,0.0,3.0},1));
+    atoms.insert(create_atom({0.0,3.0,0.0},11));
+    SetOfAtoms with_ecp=apply_ecp(ecps,atoms);
+    tester.test("Applied ECPs",with_ecp[0].nelectrons==18.0 &&
+                with_ecp[0].ecp==corr_pt && with_ecp[1].nelectrons==1.0 &&
+                with_ecp[1].ecp.empty() && with_ecp[2].nelectrons==1.0 &&
+                with_ecp[2].ecp==corr_na && atoms[0].nelectrons==78.0);
+    with_ecp=apply_ecp(ecps,with_ecp);
+    tester.test("Reapplied ECPs",with_ecp[0].nelectrons==18.0 &&
+                with_ecp[2].nelectrons==1.0);
+    SetOfAtoms cation;
+    cation.insert(create_atom({0.0,0.0,0.0},11));
+    cation[0].nelectrons=9;
+    bool threw=false;
+    try{apply_ecp(ecps,cation);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("ECP larger than the atom throws",threw);
+
+    //Malformed ECPs
+    const std::string na_ecp=g94_ecp.substr(g94_ecp.find("NA     0"),
+                                            g94_ecp.find("PT     0\nPT-")-
+                                            g94_ecp.find("NA     0"));
+    auto throws=[](const std::string& buffer){
+        try{parse_ecp_buffer(buffer,G94());}
+        catch(const std::runtime_error&){return true;}
+        return false;
+    };
+    std::string missing_term(na_ecp);
+    missing_term.erase(missing_term.find("2      0.9"));
+    std::string missing_channel(na_ecp);
+    missing_channel.erase(missing_channel.find("s-p"));
+    tester.test("Malformed ECPs throw",throws(missing_term) &&
+                throws(missing_channel) &&
+                throws(na_ecp+"d-p potential\n  1\n2 1.0 1.0\n") &&
+                !throws(na_ecp));
+    return tester.results();
+}
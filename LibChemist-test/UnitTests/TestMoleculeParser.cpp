@@ -0,0 +1,195 @@
+#include "LibChemist/MoleculeParser.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace LibChemist;
+
+//Two records: water, then the hydroxide anion with a radical on a made-up H
+std::string sdf_example=
+"water\n"
+"  made up\n"
+"\n"
+"  3  2  0  0  0  0  0  0  0  0999 V2000\n"
+"    0.0000    0.0000    0.1173 O   0  0  0  0  0  0  0  0  0  0  0  0\n"
+"    0.0000    0.7572   -0.4692 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+"    0.0000   -0.7572   -0.4692 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+"  1  2  1  0\n"
+"  1  3  1  0\n"
+"M  END\n"
+"> <ID>\n"
+"1\n"
+"\n"
+"$$$$\n"
+"hydroxide\r\n"
+"\r\n"
+"\r\n"
+"  3  1  0  0  0  0  0  0  0  0999 V2000\r\n"
+"    0.0000    0.0000    0.0000 O   0  5\r\n"
+"    0.0000    0.0000    0.9700 H   0  0\r\n"
+"   10.0000    0.0000    0.0000 H   0  0\r\n"
+"  1  2  1  0\r\n"
+"M  CHG  1   1  -1\r\n"
+"M  RAD  1   3   2\r\n"
+"M  END\r\n"
+"$$$$\r\n";
+
+//The same molecules, but MOL2 has no radicals
+std::string mol2_example=
+"# Comments before the first record\n"
+"@<TRIPOS>MOLECULE\n"
+"water\n"
+" 3 2 0 0 0\n"
+"SMALL\n"
+"GASTEIGER\n"
+"\n"
+"@<TRIPOS>ATOM\n"
+"      1 O1          0.0000    0.0000    0.1173 O.3     1  WAT  -0.8\n"
+"      2 H1          0.0000    0.7572   -0.4692 H       1  WAT   0.4\n"
+"      3 H2          0.0000   -0.7572   -0.4692 H       1  WAT   0.4\n"
+"@<TRIPOS>BOND\n"
+"     1     1     2    1\n"
+"     2     1     3    1\n"
+"@<TRIPOS>MOLECULE\n"
+"hydroxide\n"
+" 3 1\n"
+"SMALL\n"
+"GASTEIGER\n"
+"@<TRIPOS>ATOM\n"
+"      7 O1  0.0 0.0 0.0  O.3 1 OH -1.4\n"
+"      8 H1  0.0 0.0 0.97 H   1 OH  0.4\n"
+"      9 H2 10.0 0.0 0.0  H   1 OH  0.0\n"
+"@<TRIPOS>BOND\n"
+"     1     8     7    ar\n";
+
+//Reads all of a stream's molecules
+std::vector<Molecule> stream_all(MoleculeStream&& stream)
+{
+    std::vector<Molecule> rv;
+    Molecule mol;
+    while(stream.next(mol))rv.push_back(mol);
+    return rv;
+}
+
+bool throws(const std::string& record, MoleculeFormat format)
+{
+    try{parse_molecule_record(record,format);}
+    catch(const std::runtime_error&){return true;}
+    return false;
+}
+
+int main()
+{
+    Tester tester("Testing SDF and MOL2 readers");
+    const double a2b=1.0/0.52917721067;
+
+    std::array<Molecule,2> corr;
+    corr[0].name="water";
+    corr[0].atoms.push_back(create_atom({0.0,0.0,0.1173*a2b},8));
+    corr[0].atoms.push_back(create_atom({0.0,0.7572*a2b,-0.4692*a2b},1));
+    corr[0].atoms.push_back(create_atom({0.0,-0.7572*a2b,-0.4692*a2b},1));
+    corr[0].bonds.offsets={0,2,3,4};
+    corr[0].bonds.neighbors={1,2,0,0};
+    corr[0].bonds.orders={1,1,1,1};
+    corr[1].name="hydroxide";
+    corr[1].atoms.push_back(create_atom({0.0,0.0,0.0},8));
+    corr[1].atoms.push_back(create_atom({0.0,0.0,0.97*a2b},1));
+    corr[1].atoms.push_back(create_atom({10.0*a2b,0.0,0.0},1));
+    corr[1].atoms.charge=-1.0;
+    corr[1].bonds.offsets={0,1,2,2};
+    corr[1].bonds.neighbors={1,0};
+    corr[1].bonds.orders={1,1};
+
+    const auto records=split_molecule_records(sdf_example,
+                                              MoleculeFormat::sdf);
+    tester.test("Split SDF records",records.size()==2 &&
+                records[1].substr(0,9)=="hydroxide");
+    auto sdf=parse_molecule_buffer(sdf_example,MoleculeFormat::sdf);
+    tester.test("SDF, no radicals",sdf.size()==2 && sdf[0]==corr[0]);
+    tester.test("SDF, charge and radical",
+                sdf[1].atoms.multiplicity==2.0 && sdf[1].atoms.charge==-1.0);
+    sdf[1].atoms.multiplicity=1.0;
+    tester.test("SDF, atoms and bonds",sdf[1]==corr[1]);
+    tester.test("Bond table accessors",corr[0].bonds.nbonds()==2 &&
+                corr[0].bonds.neighbors_of(0).to_vector()==
+                std::vector<std::uint32_t>({1,2}) &&
+                corr[0].bonds.orders_of(2).size()==1 &&
+                corr[1].bonds.neighbors_of(2).empty());
+
+    //Without "M  CHG" the atom block's charge codes are used
+    std::string no_chg(records[1]);
+    no_chg.erase(no_chg.find("M  CHG"),no_chg.find("M  RAD")-
+                                       no_chg.find("M  CHG"));
+    tester.test("SDF, atom block charges",
+                parse_molecule_record(no_chg,MoleculeFormat::sdf).atoms.charge
+                ==-1.0);
+
+    auto mol2=parse_molecule_buffer(mol2_example,MoleculeFormat::mol2);
+    tester.test("MOL2",mol2.size()==2 && mol2[0]==corr[0] &&
+                mol2[1].bonds.orders[0]==4);
+    mol2[1].bonds.orders={1,1};
+    tester.test("MOL2, ids not from 1",mol2[1]==corr[1]);
+
+    //Stream, file and parallel reads agree
+    std::string big_sdf, big_mol2;
+    for(size_t i=0;i<500;++i)
+    {
+        big_sdf+=sdf_example;
+        big_mol2+=mol2_example;
+    }
+    const auto serial=parse_molecule_buffer(big_sdf,MoleculeFormat::sdf,1);
+    tester.test("SDF, parallel",serial.size()==1000 &&
+                parse_molecule_buffer(big_sdf,MoleculeFormat::sdf,4)==serial);
+    std::stringstream ss(big_sdf);
+    tester.test("SDF, stream",
+                stream_all(MoleculeStream(ss,MoleculeFormat::sdf))==serial);
+    const auto serial_mol2=parse_molecule_buffer(big_mol2,
+                                                 MoleculeFormat::mol2,1);
+    std::stringstream ss2(big_mol2);
+    tester.test("MOL2, stream and parallel",serial_mol2.size()==1000 &&
+                parse_molecule_buffer(big_mol2,MoleculeFormat::mol2,4)==
+                serial_mol2 &&
+                stream_all(MoleculeStream(ss2,MoleculeFormat::mol2))==
+                serial_mol2);
+
+    const std::string path("TestMoleculeParser.sdf");
+    std::ofstream(path)<<big_sdf<<"last\n\n\n  0  0\n";
+    auto from_file=stream_all(MoleculeStream(path,MoleculeFormat::sdf));
+    tester.test("SDF, last record without $$$$",from_file.size()==1001 &&
+                from_file.back().name=="last" &&
+                from_file.back().atoms.size()==0 &&
+                parse_molecule_file(path,MoleculeFormat::sdf)==from_file);
+#ifdef ENABLE_ZLIB
+    {
+        gzFile gz=gzopen(path.c_str(),"wb");
+        gzwrite(gz,big_sdf.data(),big_sdf.size());
+        gzclose(gz);
+    }
+    tester.test("SDF, gzip",
+                parse_molecule_file(path,MoleculeFormat::sdf)==serial &&
+                stream_all(MoleculeStream(path,MoleculeFormat::sdf))==serial);
+#endif
+    std::remove(path.c_str());
+
+    tester.test("V3000 throws",throws("v3\n\n\n  0  0  0     0  0"
+                                      "            999 V3000\n",
+                                      MoleculeFormat::sdf));
+    tester.test("Truncated SDF throws",
+                throws(std::string(records[0].substr(0,200)),
+                       MoleculeFormat::sdf));
+    std::string bad_bond(records[0]);
+    bad_bond.replace(bad_bond.find("  1  3  1"),9,"  1  4  1");
+    tester.test("Bond to missing atom throws",
+                throws(bad_bond,MoleculeFormat::sdf));
+    tester.test("Truncated MOL2 throws",
+                throws(mol2_example.substr(0,300),MoleculeFormat::mol2));
+    bool threw=false;
+    try{parse_molecule_record("x\n\n\n  1  0\n 0.0 0.0 0.0 Xx\n",
+                              MoleculeFormat::sdf);}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Unknown element throws",threw);
+    return tester.results();
+}
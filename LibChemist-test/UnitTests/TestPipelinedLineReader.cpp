@@ -0,0 +1,94 @@
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/PipelinedLineReader.hpp"
+#include "TestHelpers.hpp"
+#include <stdexcept>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace LibChemist::detail_;
+
+//Reads every line of reader
+std::vector<std::string> read_all(PipelinedLineReader& reader)
+{
+    std::vector<std::string> rv;
+    std::string_view line;
+    while(reader.next(line))rv.emplace_back(line);
+    return rv;
+}
+
+#ifdef ENABLE_ZLIB
+//Compresses text into a gzip member
+std::string gzip(const std::string& text)
+{
+    z_stream zs{};
+    deflateInit2(&zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,15+16,8,
+                 Z_DEFAULT_STRATEGY);
+    std::string rv(deflateBound(&zs,text.size())+32,'\0');
+    zs.next_in=reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    zs.avail_in=text.size();
+    zs.next_out=reinterpret_cast<Bytef*>(rv.data());
+    zs.avail_out=rv.size();
+    deflate(&zs,Z_FINISH);
+    rv.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rv;
+}
+#endif
+
+int main()
+{
+    Tester tester("Testing the pipelined line reader");
+    const std::string text="first\n\nthird line, longer than a chunk\nx\nlast";
+    const std::vector<std::string> corr({"first","","third line, longer "
+                                         "than a chunk","x","last"});
+
+    //Chunks of 7 bytes so lines start, end, and span chunk boundaries
+    PipelinedLineReader small(memory_source(text),7,2);
+    tester.test("Lines across chunks",read_all(small)==corr);
+    const std::string text_nl=text+"\n";
+    PipelinedLineReader big(memory_source(text_nl));
+    tester.test("Trailing newline",read_all(big)==corr);
+    PipelinedLineReader empty(memory_source(""));
+    tester.test("No lines",read_all(empty).empty());
+
+    //The lines read before the source fails are still handed out
+    size_t ncalls=0;
+    ByteSource failing=[&](char* buffer, size_t n){
+        if(ncalls++)throw std::runtime_error("Read failed");
+        n=std::min<size_t>(n,6);
+        std::copy(text.begin(),text.begin()+n,buffer);
+        return n;
+    };
+    PipelinedLineReader reader(failing,16,1);
+    std::string_view line;
+    bool threw=false;
+    const bool got_first=reader.next(line) && line=="first";
+    try{reader.next(line);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Source errors are rethrown",got_first && threw);
+
+    //Destroying a reader that is not done stops the producer
+    const std::string blank_lines(1<<20,'\n');
+    {
+        PipelinedLineReader abandoned(memory_source(blank_lines),64,1);
+        abandoned.next(line);
+    }
+    tester.test("Abandoned reader",true);
+
+    std::string buffer;
+    tester.test("Uncompressed contents are not copied",
+                decompressed_contents(text,buffer).data()==text.data());
+#ifdef ENABLE_ZLIB
+    //Compresses far better than 4 to 1, so the buffer has to grow, and has
+    //no trailing newline, which must not be added
+    std::string repeated;
+    for(size_t i=0;i<20000;++i)repeated+=text+"\n";
+    repeated+="last";
+    tester.test("Decompressed contents",
+                decompressed_contents(gzip(repeated),buffer)==repeated &&
+                decompressed_contents(gzip(text)+gzip(text),buffer)==
+                text+text);
+#endif
+    return tester.results();
+}
@@ -92,5 +92,12 @@ int main()
 
 
 
+    SetOfAtoms Cleared(UF6);
+    Cleared.clear();
+    tester.test("Clear",Cleared.size()==0 && !Cleared.count(corr_UF6[0]));
+    for(const auto& ai: corr_UF6)
+        Cleared.push_back(ai);
+    tester.test("Push back",Cleared==UF6);
+
     return tester.results();
 }
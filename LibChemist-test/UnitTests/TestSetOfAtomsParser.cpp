@@ -1,5 +1,11 @@
 #include "LibChemist/SetOfAtomsParser.hpp"
 #include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+#include <type_traits>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace LibChemist;
 
@@ -23,5 +29,121 @@ int main()
     std::stringstream ss(xyz_example);
     SetOfAtoms mol=parse_SetOfAtoms_file(ss,XYZParser());
     tester.test("Parsed xyz file",corr==mol);
+
+    const std::string xyz_file("TestSetOfAtomsParser.xyz");
+    std::ofstream(xyz_file)<<xyz_example;
+    tester.test("Parsed xyz file from disk",
+                corr==parse_SetOfAtoms_file(xyz_file,XYZParser()));
+    tester.test("Parsed xyz file from disk, pipelined",
+                corr==parse_SetOfAtoms_file(xyz_file,XYZParser(),
+                                            ReadMode::pipelined));
+    std::remove(xyz_file.c_str());
+
+#ifdef ENABLE_ZLIB
+    const std::string gz_file=xyz_file+".gz";
+    gzFile gz=gzopen(gz_file.c_str(),"wb");
+    gzwrite(gz,xyz_example.data(),xyz_example.size());
+    gzclose(gz);
+    tester.test("Parsed gzipped xyz file from disk",
+                corr==parse_SetOfAtoms_file(gz_file,XYZParser()) &&
+                corr==parse_SetOfAtoms_file(gz_file,XYZParser(),
+                                            ReadMode::pipelined));
+    std::remove(gz_file.c_str());
+#endif
+
+    //The map-based interface is an adapter over the callbacks
+    using data_type=SetOfAtomsFileParser::data_type;
+    using action_type=SetOfAtomsFileParser::action_type;
+    XYZParser xyz;
+    auto data=xyz.parse(" HE 1.1 -0.1 0.0");
+    tester.test("XYZ map interface, atom",
+                xyz.worth_parsing(" HE 1.1 -0.1 0.0")==action_type::new_atom &&
+                data.at(data_type::AtNum)[0]==2 &&
+                data.at(data_type::x)[0]==1.1 &&
+                data.at(data_type::y)[0]==-0.1 &&
+                data.at(data_type::z)[0]==0.0);
+    data=xyz.parse(" -6.7 3");
+    tester.test("XYZ map interface, system",
+                xyz.worth_parsing(" -6.7 3")==action_type::overall_system &&
+                data.at(data_type::charge)[0]==-6.7 &&
+                data.at(data_type::multiplicity)[0]==3.0);
+    tester.test("XYZ map interface, junk",
+                xyz.worth_parsing("2")==action_type::none &&
+                xyz.worth_parsing("Water molecule")==action_type::none);
+
+    //A parser written against the map-based interface still works
+    struct MapXYZ: public MapSetOfAtomsFileParser {
+        XYZParser impl;
+        action_type worth_parsing(const std::string& line)const override
+        {
+            return impl.worth_parsing(line);
+        }
+        std::map<data_type,std::vector<double>>
+        parse(const std::string& line)const override
+        {
+            return impl.SetOfAtomsFileParser::parse(line);
+        }
+    };
+    std::stringstream ss2(xyz_example);
+    tester.test("Map-based parser",
+                corr==parse_SetOfAtoms_file(ss2,MapXYZ()));
+
+    //Atomic numbers straight from the file, which may be nonsense
+    struct ZParser: public SetOfAtomsFileParser {
+        void parse_line(std::string_view line,
+                        SetOfAtomsFileHandler& handler)const override
+        {
+            handler.on_new_atom();
+            handler.on_atomic_number(std::stod(std::string(line)));
+            for(size_t i=0;i<3;++i)handler.on_coordinate(i,0.0);
+        }
+    };
+    auto bad_Z=[](const std::string& Z){
+        std::stringstream ss(Z);
+        try{parse_SetOfAtoms_file(ss,ZParser());}
+        catch(const std::out_of_range&){return true;}
+        return false;
+    };
+    std::stringstream dummy("9999");
+    tester.test("Unknown atomic numbers throw",
+                bad_Z("-3") && bad_Z("200") && bad_Z("1e15") &&
+                parse_SetOfAtoms_file(dummy,ZParser())[0].Z==9999.0);
+
+    //A parser has to implement one of the two interfaces to be usable
+    struct NoXYZ: public SetOfAtomsFileParser {};
+    struct NoMapXYZ: public MapSetOfAtomsFileParser {};
+    static_assert(std::is_abstract_v<NoXYZ> && std::is_abstract_v<NoMapXYZ> &&
+                  !std::is_abstract_v<MapXYZ>);
+
+    //Batch interface, with a missing file and an unknown element in the middle
+    std::vector<std::string> paths;
+    for(size_t i=0;i<20;++i)
+    {
+        paths.push_back("TestSetOfAtomsParser"+std::to_string(i)+".xyz");
+        std::ofstream os(paths.back());
+        if(i==7)os<<"Xx 0.0 0.0 0.0\n";
+        else os<<xyz_example<<"He "<<i<<" 0.0 0.0\n";
+    }
+    std::remove(paths[3].c_str());
+    std::vector<std::exception_ptr> errors;
+    const auto batch=parse_SetOfAtoms_files(paths,XYZParser(),errors,4);
+    bool batch_ok=batch.size()==paths.size() && errors.size()==paths.size();
+    for(size_t i=0;i<paths.size() && batch_ok;++i)
+    {
+        if(i==3 || i==7)
+        {
+            batch_ok=errors[i] && !batch[i].size();
+            continue;
+        }
+        SetOfAtoms corr_i(corr);
+        corr_i.insert(create_atom({1.0*i,0.0,0.0},2));
+        batch_ok=!errors[i] && batch[i]==corr_i;
+    }
+    tester.test("Batch parsing, in order with per-file errors",batch_ok);
+    bool threw=false;
+    try{parse_SetOfAtoms_files(paths,XYZParser(),1);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Batch parsing throws the first error",threw);
+    for(const auto& path: paths)std::remove(path.c_str());
     return tester.results();
 }
@@ -0,0 +1,93 @@
+#include "LibChemist/SetOfAtomsParser.hpp"
+#include "LibChemist/SetOfAtomsWriter.hpp"
+#include "LibChemist/XYZTrajectory.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace LibChemist;
+
+//Reads the file at path back into a string
+std::string slurp(const std::string& path)
+{
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+}
+
+int main()
+{
+    Tester tester("Testing set of atoms writers");
+
+    //Numbers that don't print exactly in a fixed number of digits
+    SetOfAtoms mol;
+    mol.insert(create_atom({0.1,1.0/3.0,-1E-300},8));
+    mol.insert(create_atom({1000.0,-2.5,6.02214076E23},1));
+    mol.insert(create_atom({0.0,-0.0,1.4142135623730951},26));
+    mol.charge=-1.0;
+    mol.multiplicity=2.0;
+
+    std::string buffer;
+    append_xyz(mol,buffer);
+    tester.test("Formatted xyz",
+                buffer=="3\n-1 2\nO 0.1 0.3333333333333333 -1e-300\n"
+                        "H 1000 -2.5 6.02214076e+23\n"
+                        "Fe 0 -0 1.4142135623730951\n");
+
+    const std::string path("TestSetOfAtomsWriter.xyz");
+    write_xyz_file(path,mol);
+    tester.test("Exact round trip",
+                parse_SetOfAtoms_file(path,XYZParser())==mol);
+
+    //Frames go to the file in buffer-sized writes, the tail on flush
+    std::vector<SetOfAtoms> frames;
+    {
+        XYZWriter writer(path,false,64);
+        for(size_t i=0;i<10;++i)
+        {
+            SetOfAtoms frame(mol);
+            for(Atom& ai: frame)ai.coord[0]+=0.1*i;
+            frames.push_back(frame);
+            writer.write(frame);
+        }
+        tester.test("Counted frames",writer.nframes()==10);
+        writer.flush();
+        tester.test("Flushed frames",slurp(path).size()>64);
+    }
+    {
+        //The destructor flushes whatever is left
+        XYZWriter writer(path,true);
+        writer.write(frames[0]);
+    }
+    frames.push_back(frames[0]);
+    std::ifstream traj_file(path);
+    XYZTrajectory traj(traj_file);
+    bool same=true;
+    size_t nread=0;
+    for(const SetOfAtoms& frame: traj)
+        same=same && nread<frames.size() && frame==frames[nread++];
+    tester.test("Trajectory round trip",same && nread==frames.size());
+
+    //Atoms without a symbol can't be written, nor can half a frame
+    SetOfAtoms ghost(mol);
+    Atom bad=create_atom({0.0,0.0,0.0},1);
+    bad.Z=200.0;
+    ghost.insert(bad);
+    bool threw=false;
+    {
+        XYZWriter writer(path);
+        try{writer.write(ghost);}
+        catch(const std::out_of_range&){threw=true;}
+        writer.write(mol);
+        tester.test("Failed frame not counted",writer.nframes()==1);
+    }
+    tester.test("Unknown element throws",threw);
+    tester.test("Failed frame not written",slurp(path)==buffer);
+
+    threw=false;
+    try{XYZWriter("no/such/directory/file.xyz");}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Unwritable path throws",threw);
+    std::remove(path.c_str());
+    return tester.results();
+}
@@ -0,0 +1,220 @@
+#include "LibChemist/Snapshot.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace LibChemist;
+
+//Flips one byte in the middle of the file at path
+void corrupt(const std::string& path)
+{
+    std::fstream file(path,std::ios::binary|std::ios::in|std::ios::out);
+    file.seekg(0,std::ios::end);
+    const std::streamoff middle=file.tellg()/2;
+    char c;
+    file.seekg(middle);
+    file.get(c);
+    file.seekp(middle);
+    file.put(static_cast<char>(c^0x10));
+}
+
+int main()
+{
+    Tester tester("Testing binary snapshots");
+
+    const std::string path("TestSnapshot.bin");
+    const std::vector<double> doubles({1.5,-2.5,3.25});
+    const std::vector<int> ints({1,-1});
+    const std::string chars("abcdefghijk");
+    SnapshotWriter writer("TEST");
+    writer.add("doubles",doubles);
+    writer.add("ints",ints);
+    writer.add("chars",chars.data(),chars.size());
+    writer.add("empty",std::vector<double>());
+    writer.write(path);
+    {
+        const Snapshot snap(path);
+        tester.test("Kind",snap.kind()=="TEST");
+        tester.test("Count",snap.count("doubles") && !snap.count("missing"));
+        const auto doubles_view=snap.array<double>("doubles");
+        tester.test("Doubles",doubles_view==doubles);
+        tester.test("Aligned",reinterpret_cast<std::uintptr_t>(
+                                  doubles_view.data())%64==0);
+        tester.test("Ints",snap.array<int>("ints")==ints);
+        const auto chars_view=snap.array<char>("chars");
+        tester.test("Chars",std::string(chars_view.begin(),chars_view.end())==
+                            chars);
+        tester.test("Empty",snap.array<double>("empty").empty());
+        bool threw=false;
+        try{snap.array<int>("doubles");}
+        catch(const std::runtime_error&){threw=true;}
+        tester.test("Wrong type throws",threw);
+        threw=false;
+        try{snap.array<int>("missing");}
+        catch(const std::out_of_range&){threw=true;}
+        tester.test("Missing array throws",threw);
+    }
+
+    //An H2 molecule with two basis sets, one of them only on the first atom
+    BasisShell s(ShellType::SphericalGaussian,0,1,{3.4,0.6},{0.15,0.53});
+    BasisShell sp(ShellType::CartesianGaussian,-1,2,{0.2},{0.5,0.7});
+    SetOfAtoms h2;
+    h2.charge=1.0;
+    h2.multiplicity=2.0;
+    h2.insert(create_atom({0.0,0.0,0.0},1));
+    h2.insert(create_atom({0.0,0.0,1.4},1));
+    h2[0].add_shell("sto-3g",s);
+    h2[0].add_shell("sto-3g",sp);
+    h2[1].add_shell("sto-3g",s);
+    h2[0].add_shell("ghost",sp);
+
+    const BasisSet bs=get_general_basis("sto-3g",h2);
+    save_snapshot(path,bs);
+    tester.test("BasisSet round trip",load_basis_set_snapshot(path)==bs);
+    {
+        const Snapshot snap(path,false);
+        const BasisSetView view=basis_set_view(snap);
+        tester.test("BasisSet view",view.nshells()==3 && view.ls==bs.ls() &&
+                                    view.alphas==bs.alphas() &&
+                                    view.centers==bs.centers());
+        bool threw=false;
+        try{set_of_atoms_view(snap);}
+        catch(const std::runtime_error&){threw=true;}
+        tester.test("Wrong kind throws",threw);
+    }
+
+    save_snapshot(path,h2);
+    const SetOfAtoms h2_copy=load_set_of_atoms_snapshot(path);
+    tester.test("SetOfAtoms round trip",h2_copy==h2);
+    tester.test("Basis sets round trip",
+                get_general_basis("sto-3g",h2_copy)==bs &&
+                get_general_basis("ghost",h2_copy)==
+                get_general_basis("ghost",h2) &&
+                h2_copy[1].nshells("ghost")==0);
+    {
+        const Snapshot snap(path);
+        const SetOfAtomsView view=set_of_atoms_view(snap);
+        tester.test("SetOfAtoms view",view.size()==2 && view.charge==1.0 &&
+                                      view.coords[5]==1.4 &&
+                                      view.basis_names==
+                                      std::vector<std::string>({"ghost",
+                                                                "sto-3g"}));
+        tester.test("Shells per atom",
+                    view.shells_per_atom[0]==std::vector<size_t>({1,0}) &&
+                    view.shells_per_atom[1]==std::vector<size_t>({2,1}));
+    }
+
+    //An ECP on the second atom only, which apply_ecp must not reapply
+    ECP ecp;
+    ecp.ncore=1;
+    ecp.lmax=1;
+    ecp.offsets={0,1,3};
+    ecp.powers={2,1,2};
+    ecp.alphas={5.0,1.5,0.25};
+    ecp.coefs={-0.5,2.0,0.75};
+    const SetOfAtoms h2_ecp=apply_ecp({{1,ecp}},h2);
+    SetOfAtoms one_ecp=h2;
+    one_ecp[1]=h2_ecp[1];
+    save_snapshot(path,one_ecp);
+    const SetOfAtoms ecp_copy=load_set_of_atoms_snapshot(path);
+    tester.test("ECPs round trip",ecp_copy==one_ecp &&
+                ecp_copy[1].ecp==ecp && ecp_copy[0].ecp.empty());
+    tester.test("ECPs compared",ecp_copy!=h2 && !(h2_ecp[1]==h2[1]));
+    tester.test("Reloaded ECP is not applied twice",
+                apply_ecp({{1,ecp}},ecp_copy)==h2_ecp);
+    {
+        const Snapshot snap(path);
+        const SetOfAtomsView view=set_of_atoms_view(snap);
+        tester.test("ECP view",view.ecp_ncore==std::vector<size_t>({0,1}) &&
+                               view.ecp_nterms==std::vector<size_t>({0,3}) &&
+                               view.ecp_alphas==ecp.alphas);
+    }
+
+    corrupt(path);
+    bool threw=false;
+    try{Snapshot snap(path);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Corrupt snapshot throws",threw);
+    std::filesystem::resize_file(path,100);
+    threw=false;
+    try{Snapshot snap(path,false);}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Truncated snapshot throws",threw);
+    std::remove(path.c_str());
+
+
+    //Counts too large to fit in the file, even once they overflow
+    auto patch=[&](std::streamoff where, std::uint64_t value){
+        std::fstream file(path,std::ios::binary|std::ios::in|std::ios::out);
+        file.seekp(where);
+        file.write(reinterpret_cast<const char*>(&value),sizeof(value));
+    };
+    auto view_throws=[&](bool verify){
+        try{set_of_atoms_view(Snapshot(path,verify));}
+        catch(const std::runtime_error&){return true;}
+        return false;
+    };
+    save_snapshot(path,h2);
+    patch(32,std::uint64_t(1)<<58);
+    tester.test("Overflowing number of arrays throws",view_throws(true));
+    save_snapshot(path,h2);
+    patch(64+56,std::uint64_t(1)<<61);
+    tester.test("Overflowing array length throws",view_throws(false));
+
+    //Arrays whose lengths disagree
+    auto atoms_throw=[&](const SnapshotWriter& w){
+        w.write(path);
+        return view_throws(true);
+    };
+    const std::vector<double> two({1.0,1.0}), six(6,0.0), one({1.0});
+    const std::vector<std::uint64_t> isotopes(2,1);
+    auto atoms_writer=[&](const std::vector<double>& system,
+                          const std::vector<double>& mass){
+        SnapshotWriter w("ATOMS");
+        w.add("system",system);
+        w.add("coords",six);
+        for(const char* name: {"Z","charge","multiplicity","nelectrons",
+                               "isotope_mass","cov_radius","vdw_radius"})
+            w.add(name,two);
+        w.add("mass",mass);
+        w.add("isotope",isotopes);
+        return w;
+    };
+    tester.test("Consistent arrays",!atoms_throw(atoms_writer(two,two)));
+    tester.test("Short system throws",atoms_throw(atoms_writer(one,two)));
+    tester.test("Short per-atom array throws",
+                atoms_throw(atoms_writer(two,one)));
+    SnapshotWriter ecps=atoms_writer(two,two);
+    const std::vector<std::uint64_t> counts({1,2}), noffsets({0,0});
+    const std::vector<int> lmax(2,0), powers(3,2);
+    const std::vector<std::uint64_t> no_offsets;
+    const std::vector<double> three(3,1.0);
+    ecps.add("ecp.ncore",counts);
+    ecps.add("ecp.lmax",lmax);
+    ecps.add("ecp.noffsets",noffsets);
+    ecps.add("ecp.nterms",counts);
+    ecps.add("ecp.offsets",no_offsets);
+    ecps.add("ecp.powers",powers);
+    ecps.add("ecp.alphas",three);
+    ecps.add("ecp.coefs",two);
+    tester.test("ECP terms not adding up throws",atoms_throw(ecps));
+    SnapshotWriter shells("BASISSET");
+    const std::vector<std::uint64_t> nprims({2,std::uint64_t(1)<<63});
+    shells.add("centers",six);
+    shells.add("ngens",isotopes);
+    shells.add("nprims",nprims);
+    shells.add("coefs",two);
+    shells.add("alphas",two);
+    const std::vector<ShellType> types(2,ShellType::SphericalGaussian);
+    shells.add("types",types);
+    shells.add("ls",lmax);
+    shells.write(path);
+    threw=false;
+    try{basis_set_view(Snapshot(path));}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Primitives not adding up throws",threw);
+    std::remove(path.c_str());
+
+    return tester.results();
+}
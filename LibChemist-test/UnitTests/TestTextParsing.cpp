@@ -0,0 +1,111 @@
+#include "LibChemist/detail_/TextParsing.hpp"
+#include "TestHelpers.hpp"
+#include <cmath>
+#include <sstream>
+
+using namespace LibChemist::detail_;
+
+//The byte at a time tokenizer the vectorized one has to agree with
+std::vector<std::string_view> reference_tokens(std::string_view line)
+{
+    std::vector<std::string_view> rv;
+    size_t pos=0;
+    while(true)
+    {
+        while(pos<line.size() && is_space(line[pos]))++pos;
+        const size_t begin=pos;
+        while(pos<line.size() && !is_space(line[pos]))++pos;
+        if(begin==pos)return rv;
+        rv.push_back(line.substr(begin,pos-begin));
+    }
+}
+
+//True if for_each_stream_line splits text the same way std::getline does
+bool stream_lines_match(const std::string& text)
+{
+    std::vector<std::string> lines, corr;
+    std::stringstream ss(text), ss2(text);
+    for_each_stream_line(ss,[&](std::string_view l){lines.emplace_back(l);});
+    for(std::string l;std::getline(ss2,l);)corr.push_back(l);
+    return lines==corr;
+}
+
+int main()
+{
+    Tester tester("Testing the text parsing helpers");
+
+    //Runs of every kind of whitespace, and non-ASCII bytes, of lengths that
+    //straddle the 16 and 32 byte blocks
+    std::string line;
+    const std::string blanks(" \t\r\v\f");
+    for(size_t i=0;i<200;++i)
+    {
+        line.append(i%37+1,blanks[i%blanks.size()]);
+        line.append(i%41+1,i%7 ? static_cast<char>('a'+i%26) : '\xC3');
+    }
+    std::vector<std::string_view> tokens;
+    size_t pos=0;
+    for(auto token=next_token(line,pos);!token.empty();
+        token=next_token(line,pos))
+        tokens.push_back(token);
+    tester.test("Tokens match byte at a time scan",
+                tokens==reference_tokens(line) && tokens.size()==200);
+    pos=line.size()+5;
+    tester.test("No tokens past the end",next_token(line,pos).empty());
+
+    double value=0.0;
+    bool is_int=false;
+    tester.test("Integer",to_double("+42",value,is_int) && value==42.0 &&
+                is_int);
+    tester.test("Fortran exponent",to_double("-1.25D-02",value,is_int) &&
+                value==-0.0125 && !is_int);
+    tester.test("Leading decimal point",to_double(".5e1",value) && value==5.0);
+    tester.test("Out of range",to_double("1e400",value) && std::isinf(value));
+    tester.test("Negative overflow",to_double("-1.5D+999",value) &&
+                std::isinf(value) && value<0.0);
+    tester.test("Underflow",to_double("1e-400",value) && value==0.0 &&
+                to_double("-0.0001e-99999999999",value) && value==0.0 &&
+                std::signbit(value));
+    tester.test("Magnitude from the mantissa",
+                to_double("100000000000000000000e300",value) &&
+                std::isinf(value) &&
+                to_double("0.00000000000000000001e-310",value) &&
+                value==0.0);
+    tester.test("Decimal magnitude",decimal_magnitude("123.4")==2 &&
+                decimal_magnitude("0.05e0")==-2 &&
+                decimal_magnitude("-.5")==-1 &&
+                decimal_magnitude("00.5D+3")==2);
+    value=3.0;
+    tester.test("Not numbers",!to_double("1e",value) && !to_double("e1",value)
+                && !to_double("1.0x",value) && !to_double("He",value) &&
+                value==3.0);
+
+    //Lines longer than a block, lines crossing blocks, no final newline
+    std::string text;
+    for(size_t i=0;i<5000;++i)
+        text+=std::string(i%97,'x')+std::to_string(i)+(i==1000 ?
+              std::string(70000,'y') : std::string())+"\n";
+    text+="last";
+    tester.test("Stream lines match getline",stream_lines_match(text));
+
+    //A carried line meeting a block whose only newline ends it
+    tester.test("Carry ends at the block's only newline",
+                stream_lines_match(std::string(65530,'x')+
+                                   "\nabcdefghij\nlast"));
+    tester.test("Two lines longer than a block",
+                stream_lines_match(std::string(70000,'x')+"\n"+
+                                   std::string(70000,'y')));
+
+    //Blank lines next to the end of a block, and at the end of the input
+    tester.test("Blank line before the last newline",
+                stream_lines_match("a\nb\n\nc"));
+    tester.test("Blank line ending a block",
+                stream_lines_match(std::string(65534,'x')+"\n\nc\n"));
+    tester.test("Blank line starting a block",
+                stream_lines_match(std::string(65535,'x')+"\n\nc"));
+    tester.test("Blank lines ending the input",
+                stream_lines_match("a\n\n") && stream_lines_match("a\n\n\n") &&
+                stream_lines_match("\n"));
+
+    return tester.results();
+}
@@ -0,0 +1,180 @@
+#include "LibChemist/XYZTrajectory.hpp"
+#include "TestHelpers.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace LibChemist;
+
+//A fake trajectory, with and without charge/multiplicity comments.  The last
+//frame repeats an atom, which the reader keeps as the frame has three atoms.
+std::string traj_example=
+"2\n"
+" -1 2\n"
+"He 0.1 0.1 0.0\n"
+"H  1.1 0.1 0.0\n"
+"\n"
+"2\n"
+"Frame 2\n"
+"he 0.2 0.1 0.0\n"
+"H  1.2 0.1 0.0\n"
+"3\n"
+"Frame 3\n"
+"He 0.3 0.1 0.0\n"
+"H  1.3 0.1 0.0\n"
+"H  1.3 0.1 0.0\n";
+
+SetOfAtoms make_frame(double x, size_t natoms)
+{
+    SetOfAtoms rv;
+    rv.push_back(create_atom({x,0.1,0.0},2));
+    for(size_t i=1;i<natoms;++i)
+        rv.push_back(create_atom({x+1.0,0.1,0.0},1));
+    return rv;
+}
+
+int main()
+{
+    Tester tester("Testing xyz trajectory reader");
+
+    std::array<SetOfAtoms,3> corr({make_frame(0.1,2),make_frame(0.2,2),
+                                   make_frame(0.3,3)});
+    corr[0].charge=-1.0;
+    corr[0].multiplicity=2.0;
+
+    std::stringstream ss(traj_example);
+    XYZTrajectory traj(ss);
+    SetOfAtoms frame;
+    bool same=true;
+    for(size_t i=0;i<3;++i)
+        same=same && traj.next(frame) && frame==corr[i];
+    tester.test("Read frames via next",same);
+    tester.test("No more frames",!traj.next(frame) && traj.nframes()==3);
+
+    std::stringstream ss2(traj_example);
+    size_t i=0;
+    same=true;
+    for(const SetOfAtoms& f: XYZTrajectory(ss2))
+        same=same && i<3 && f==corr[i++];
+    tester.test("Read frames via iterators",same && i==3);
+
+    std::stringstream ss3("3\ncomment\nHe 0.0 0.0 0.0\n");
+    XYZTrajectory truncated(ss3);
+    bool threw=false;
+    try{truncated.next();}
+    catch(const std::runtime_error&){threw=true;}
+    tester.test("Truncated frame throws",threw);
+
+    std::stringstream ss4("");
+    XYZTrajectory empty(ss4);
+    tester.test("Empty trajectory",empty.begin()==empty.end());
+
+    //Random access through the frame index
+    const std::string path("TestXYZTrajectory.xyz");
+    std::ofstream(path)<<traj_example;
+    std::remove(xyz_index_path(path).c_str());
+    const std::vector<size_t> corr_offsets({0,39,79,134});
+    tester.test("Index trajectory",index_xyz_trajectory(path)==corr_offsets);
+    std::vector<size_t> offsets;
+    tester.test("No sidecar yet",!load_xyz_index(path,offsets));
+
+    IndexedXYZTrajectory indexed(path);
+    tester.test("Indexed size",indexed.size()==3 &&
+                indexed.offsets()==corr_offsets);
+    tester.test("Sidecar written",load_xyz_index(path,offsets) &&
+                offsets==corr_offsets);
+    tester.test("Random access",indexed.frame(2)==corr[2] &&
+                indexed.frame(0)==corr[0]);
+    auto frames=indexed.read_frames({2,1,2},2);
+    tester.test("Parallel frames",frames.size()==3 && frames[0]==corr[2] &&
+                frames[1]==corr[1] && frames[2]==corr[2]);
+    threw=false;
+    try{indexed.frame(3);}
+    catch(const std::out_of_range&){threw=true;}
+    tester.test("Out of range frame throws",threw);
+
+    IndexedXYZTrajectory reopened(path);
+    tester.test("Reopen from sidecar",reopened.frame(1)==corr[1]);
+
+    //Corrupt sidecars are ignored, and the index rebuilt
+    save_xyz_index(path,{0,79,39,134});
+    tester.test("Sidecar offsets out of order",!load_xyz_index(path,offsets) &&
+                IndexedXYZTrajectory(path).offsets()==corr_offsets);
+    save_xyz_index(path,{0,39,79,1000});
+    tester.test("Sidecar offsets past the end",!load_xyz_index(path,offsets) &&
+                IndexedXYZTrajectory(path).offsets()==corr_offsets);
+    {
+        //The frame count is the last field of the 40-byte header
+        std::fstream sidecar(xyz_index_path(path),std::ios::binary|
+                             std::ios::in|std::ios::out);
+        const std::uint64_t nframes=~std::uint64_t(0);
+        sidecar.seekp(32);
+        sidecar.write(reinterpret_cast<const char*>(&nframes),sizeof(nframes));
+    }
+    tester.test("Sidecar frame count too large",
+                !load_xyz_index(path,offsets) &&
+                IndexedXYZTrajectory(path).offsets()==corr_offsets);
+
+    //Sidecar is ignored once the trajectory changes, even if not its size
+    //The blank line between the first two frames moves to the end
+    std::string same_size(traj_example);
+    same_size.erase(same_size.find("\n\n2"),1);
+    same_size+="\n";
+    std::ofstream(path)<<same_size;
+    std::filesystem::last_write_time(path,
+        std::filesystem::last_write_time(path)+std::chrono::seconds(1));
+    tester.test("Rewritten sidecar",!load_xyz_index(path,offsets) &&
+                IndexedXYZTrajectory(path).offsets()==
+                std::vector<size_t>({0,38,78,133}));
+    std::ofstream(path,std::ios::app)<<"1\n\nH 0.0 0.0 0.0\n";
+    tester.test("Stale sidecar",!load_xyz_index(path,offsets) &&
+                IndexedXYZTrajectory(path).size()==4);
+    std::remove(path.c_str());
+    std::remove(xyz_index_path(path).c_str());
+
+    //Following a trajectory as it is written, with frames flushed in pieces
+    std::ofstream writer(path);
+    XYZTrajectoryFollower follower(path,std::chrono::milliseconds(1));
+    const std::chrono::milliseconds no_wait(0);
+    tester.test("Follow, nothing written yet",!follower.next(frame,no_wait));
+    const size_t split=traj_example.find("H  1.2");
+    writer<<traj_example.substr(0,split+3)<<std::flush;
+    same=follower.try_next(frame) && frame==corr[0];
+    tester.test("Follow, first frame",same && !follower.try_next(frame) &&
+                follower.nframes()==1);
+    //The rest of the second frame, minus the newline ending it
+    const size_t frame3=traj_example.find("3\nFrame 3");
+    writer<<traj_example.substr(split+3,frame3-split-4)<<std::flush;
+    tester.test("Follow, unterminated last line",!follower.try_next(frame));
+    std::thread md([&](){
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        writer<<traj_example.substr(frame3-1)<<std::flush;
+    });
+    same=follower.next(frame,std::chrono::seconds(10)) && frame==corr[1] &&
+         follower.next(std::chrono::seconds(10)) && follower.frame()==corr[2];
+    md.join();
+    tester.test("Follow, waits for frames",same && follower.nframes()==3 &&
+                follower.bytes_read()==traj_example.size());
+    tester.test("Follow, times out",
+                !follower.next(frame,std::chrono::milliseconds(5)));
+    writer.close();
+    std::remove(path.c_str());
+
+    //Following a trajectory that is already large only reads what it needs
+    const size_t nrepeats=1000;
+    std::string large;
+    for(size_t i=0;i<nrepeats;++i)large+=traj_example;
+    std::ofstream(path)<<large;
+    XYZTrajectoryFollower existing(path);
+    same=existing.try_next(frame) && frame==corr[0];
+    tester.test("Follow, reads one block at a time",
+                same && existing.bytes_read()<=(1<<16));
+    while(existing.try_next(frame));
+    tester.test("Follow, reads all existing frames",
+                existing.nframes()==3*nrepeats &&
+                existing.bytes_read()==large.size() && frame==corr[2]);
+    std::remove(path.c_str());
+
+    return tester.results();
+}
@@ -0,0 +1,69 @@
+#include "LibChemist/AsyncLoader.hpp"
+#include "LibChemist/detail_/ThreadPool.hpp"
+#include <atomic>
+
+namespace LibChemist {
+namespace detail_ {
+
+//The state shared by the two halves of a job
+struct LoadJob {
+    std::promise<SetOfAtoms> promise;
+    std::string basis_name;
+    SetOfAtoms atoms;
+    std::map<size_t,std::vector<BasisShell>> basis;
+    std::exception_ptr atoms_error, basis_error;
+    std::atomic<int> remaining{2};
+
+    //Called by each half when it is done, the last one finishes the job
+    void finish_half()noexcept
+    {
+        if(--remaining)return;
+        try
+        {
+            if(atoms_error)std::rethrow_exception(atoms_error);
+            if(basis_error)std::rethrow_exception(basis_error);
+            promise.set_value(apply_basis_set(basis_name,basis,atoms));
+        }
+        catch(...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }
+};
+
+}//End namespace detail_
+
+AsyncLoader::AsyncLoader(size_t nthreads):
+    pool_(std::make_unique<detail_::ThreadPool>(nthreads))
+{}
+
+AsyncLoader::~AsyncLoader()noexcept=default;
+
+size_t AsyncLoader::nthreads()const noexcept
+{
+    return pool_->size();
+}
+
+std::future<SetOfAtoms>
+AsyncLoader::load(const std::string& molecule_path,
+                  const std::string& basis_path, const std::string& basis_name,
+                  std::shared_ptr<const SetOfAtomsFileParser> molecule_parser,
+                  std::shared_ptr<const BasisSetFileParser> basis_parser)
+{
+    auto job=std::make_shared<detail_::LoadJob>();
+    job->basis_name=basis_name;
+    std::future<SetOfAtoms> rv=job->promise.get_future();
+    pool_->submit([job,molecule_path,molecule_parser](){
+        try{job->atoms=parse_SetOfAtoms_file(molecule_path,*molecule_parser);}
+        catch(...){job->atoms_error=std::current_exception();}
+        job->finish_half();
+    });
+    pool_->submit([job,basis_path,basis_parser](){
+        try{job->basis=parse_basis_set_file(basis_path,*basis_parser);}
+        catch(...){job->basis_error=std::current_exception();}
+        job->finish_half();
+    });
+    return rv;
+}
+
+}//End namespace LibChemist
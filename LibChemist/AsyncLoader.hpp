@@ -0,0 +1,83 @@
+#pragma once
+#include <future>
+#include <memory>
+#include <string>
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/SetOfAtomsParser.hpp"
+
+namespace LibChemist {
+namespace detail_ {
+class ThreadPool;
+}
+
+/** \brief Loads molecules and their basis sets in the background.
+ *
+ *  Loading a job the usual way takes three steps one after the other:
+ *  parse_SetOfAtoms_file, parse_basis_set_file, and apply_basis_set.  Here
+ *  both files of a job are parsed at the same time, by a pool of threads, and
+ *  the basis set is applied by whichever parse finishes last.  Jobs are
+ *  started in the order they are queued, so while the caller works on the
+ *  first job the files of the later ones are already being read.
+ *
+ *  \code
+    AsyncLoader loader;
+    std::vector<std::future<SetOfAtoms>> jobs;
+    for(const auto& path: paths)
+        jobs.push_back(loader.load(path,"cc-pvdz.gbs","cc-pVDZ"));
+    for(auto& job: jobs)
+        run(job.get());
+    \endcode
+ */
+class AsyncLoader {
+public:
+    /** \brief Starts the threads doing the loading.
+     *
+     *  \param[in] nthreads The number of threads, 0 means one per hardware
+     *                      thread.  Two are enough to overlap the files of
+     *                      a job, more overlap several jobs.
+     *  \throws std::system_error if a thread can not be started.
+     */
+    explicit AsyncLoader(size_t nthreads=0);
+
+    /** \brief Finishes the jobs that have been queued, then stops the threads.
+     *
+     *  The futures returned by load are all ready after this.
+     */
+    ~AsyncLoader()noexcept;
+
+    AsyncLoader(const AsyncLoader&)=delete;
+    AsyncLoader& operator=(const AsyncLoader&)=delete;
+
+    /** \brief Queues a molecule and a basis set to be loaded.
+     *
+     *  The files are read as by the overloads of parse_SetOfAtoms_file and
+     *  parse_basis_set_file taking a path, i.e. they may be gzip-compressed.
+     *
+     *  \param[in] molecule_path The path to the molecule's file.
+     *  \param[in] basis_path The path to the basis set file.
+     *  \param[in] basis_name The name to apply the basis set under.
+     *  \param[in] molecule_parser The parser for \p molecule_path.  It is kept
+     *                             alive until the job is done.
+     *  \param[in] basis_parser The parser for \p basis_path.  It is kept
+     *                          alive until the job is done.
+     *  \returns The molecule with the basis set applied to it.  If either file
+     *           can not be read or parsed, getting the result throws what the
+     *           parse threw, the molecule's exception if both failed.
+     *  \throws std::bad_alloc if memory allocation fails.
+     */
+    std::future<SetOfAtoms>
+    load(const std::string& molecule_path, const std::string& basis_path,
+         const std::string& basis_name,
+         std::shared_ptr<const SetOfAtomsFileParser> molecule_parser=
+             std::make_shared<XYZParser>(),
+         std::shared_ptr<const BasisSetFileParser> basis_parser=
+             std::make_shared<G94>());
+
+    ///Returns the number of threads doing the loading
+    size_t nthreads()const noexcept;
+
+private:
+    std::unique_ptr<detail_::ThreadPool> pool_;
+};
+
+}//End namespace LibChemist
@@ -21,10 +21,10 @@ Atom::Atom(const CoordType& xyz, double Z_, size_t isotope_,
 bool Atom::operator==(const Atom& rhs)const noexcept
 {
     return std::tie(Z,isotope,mass,isotope_mass,charge,multiplicity,
-                    nelectrons,cov_radius,vdw_radius,coord)==
+                    nelectrons,cov_radius,vdw_radius,coord,ecp)==
            std::tie(rhs.Z,rhs.isotope,rhs.mass,rhs.isotope_mass,rhs.charge,
                     rhs.multiplicity,rhs.nelectrons,rhs.cov_radius,
-                    rhs.vdw_radius,rhs.coord);
+                    rhs.vdw_radius,rhs.coord,rhs.ecp);
 }
 
 
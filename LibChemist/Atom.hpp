@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include "LibChemist/BasisShell.hpp"
 #include "LibChemist/BasisSet.hpp"
+#include "LibChemist/ECP.hpp"
 
 namespace LibChemist {
 
@@ -46,6 +47,7 @@ public:
     double cov_radius;     //!< The covalent radius
     double vdw_radius;     //!< The van der waals radius
     std::array<double,3> coord; //!< The location of the atom in space
+    ECP ecp;               //!< The effective core potential, empty if none
 
     /*! \brief Constructor
          *
@@ -153,6 +155,32 @@ public:
         return rv;
     }
 
+    /** \brief Returns the names of the basis sets with shells on this atom.
+     *
+     * \returns The names, in no particular order.
+     * \throws std::bad_alloc if there is insufficient memory.
+     */
+    std::vector<std::string> basis_set_names()const
+    {
+        std::vector<std::string> rv;
+        rv.reserve(basis_sets.size());
+        for(const auto& bs: basis_sets)
+            rv.push_back(bs.first);
+        return rv;
+    }
+
+    /** \brief Returns the number of shells this atom has in a basis set.
+     *
+     * \param[in] bs_name The name of the basis set.
+     * \returns The number of shells, 0 if \p bs_name does not exist.
+     * \throws No throw guarantee.
+     */
+    size_t nshells(const std::string& bs_name)const noexcept
+    {
+        auto it=basis_sets.find(bs_name);
+        return it==basis_sets.end() ? 0 : it->second.size();
+    }
+
     /** \brief Assigns a deep copy of another Atom instance to this instance
      *
      *  \param[in] rhs The Atom instance to deep copy.
@@ -1,18 +1,79 @@
 #include "LibChemist/BasisSet.hpp"
 #include "LibChemist/Utilities.hpp"
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <tuple>
 
 namespace LibChemist {
 
 bool BasisSet::operator==(const BasisSet& rhs)const noexcept
 {
-    return std::tie(centers,ngens,nprims,coefs,alphas,types,ls)==
-           std::tie(rhs.centers,rhs.ngens,rhs.nprims,rhs.coefs,rhs.alphas,
-                    rhs.types,rhs.ls);
+    return std::tie(centers_,ngens_,nprims_,coefs_,alphas_,types_,ls_)==
+           std::tie(rhs.centers_,rhs.ngens_,rhs.nprims_,rhs.coefs_,rhs.alphas_,
+                    rhs.types_,rhs.ls_);
 }
 
 
+namespace detail_ {
+
+//The highest angular momentum in a shell with angular momentum l
+size_t shell_max_am(int l)noexcept
+{
+    //If l is negative, -1 times its value is the max angular momentum it holds
+    return l<0 ? -1*l : l;
+}
+
+//Hashes the x, y, and z coordinates starting at center
+size_t center_hash(const double* center)noexcept
+{
+    std::uint64_t rv=0;
+    for(size_t i=0;i<3;++i)
+    {
+        //-0.0 and 0.0 are the same center so they have to hash the same
+        const double x=(center[i]==0.0 ? 0.0 : center[i]);
+        std::uint64_t bits;
+        std::memcpy(&bits,&x,sizeof(bits));
+        rv=(rv^bits)*0x9E3779B97F4A7C15ull;
+        rv^=rv>>32;
+    }
+    return rv;
+}
+
+//True if the centers starting at lhs and rhs are the same
+bool same_center(const double* lhs, const double* rhs)noexcept
+{
+    return lhs[0]==rhs[0] && lhs[1]==rhs[1] && lhs[2]==rhs[2];
+}
+
+}//End namespace detail_
+
+BasisSet::BasisSet(std::vector<double> centers, std::vector<size_t> ngens,
+                   std::vector<size_t> nprims, std::vector<double> coefs,
+                   std::vector<double> alphas, std::vector<ShellType> types,
+                   std::vector<int> ls):
+    centers_(std::move(centers)),ngens_(std::move(ngens)),
+    nprims_(std::move(nprims)),coefs_(std::move(coefs)),
+    alphas_(std::move(alphas)),types_(std::move(types)),ls_(std::move(ls))
+{
+    const size_t n=ls_.size();
+    if(centers_.size()!=3*n || ngens_.size()!=n || nprims_.size()!=n ||
+       types_.size()!=n)
+        throw std::invalid_argument("BasisSet arrays have different numbers "
+                                    "of shells");
+    size_t nalphas=0, ncoefs=0;
+    for(size_t i=0;i<n;++i)
+    {
+        nalphas+=nprims_[i];
+        ncoefs+=nprims_[i]*ngens_[i];
+    }
+    if(alphas_.size()!=nalphas || coefs_.size()!=ncoefs)
+        throw std::invalid_argument("BasisSet arrays do not hold the "
+                                    "primitives of their shells");
+    update_offsets();
+}
+
 void BasisSet::add_shell(const double* center,
                          const BasisShell& shell)
 {
@@ -20,43 +81,113 @@ void BasisSet::add_shell(const double* center,
     const size_t ngen=shell.ngen;
 
     for(size_t i=0;i<3;++i)
-        centers.push_back(center[i]);
+        centers_.push_back(center[i]);
 
     for(size_t i=0;i<nprim;++i)
-        alphas.push_back(shell.alpha(i));
+        alphas_.push_back(shell.alpha(i));
 
     for(size_t i=0;i<ngen;++i)
     {
         for(size_t j=0;j<nprim;++j)
-            coefs.push_back(shell.coef(j,i));
+            coefs_.push_back(shell.coef(j,i));
     }
 
-    ls.push_back(shell.l);
-    nprims.push_back(nprim);
-    ngens.push_back(ngen);
-    types.push_back(shell.type);
+    ls_.push_back(shell.l);
+    nprims_.push_back(nprim);
+    ngens_.push_back(ngen);
+    types_.push_back(shell.type);
+    update_offsets();
+}
+
+void BasisSet::add_shell(const ShellView& shell)
+{
+    centers_.insert(centers_.end(),shell.center,shell.center+3);
+    alphas_.insert(alphas_.end(),shell.alphas.begin(),shell.alphas.end());
+    coefs_.insert(coefs_.end(),shell.coefs.begin(),shell.coefs.end());
+    ls_.push_back(shell.l);
+    nprims_.push_back(shell.nprim);
+    ngens_.push_back(shell.ngen);
+    types_.push_back(shell.type);
+    update_offsets();
 }
 
-size_t BasisSet::max_am()const noexcept
+void BasisSet::update_offsets()
 {
-    //Need min in case it's negative
-    int min=*std::min_element(ls.begin(),ls.end());
-    int max=*std::max_element(ls.begin(),ls.end());
-    //If min is negative, -1 times its value is the max angular momentum it holds
-    return (min<0?std::max(-1*min,max):max);
+    const size_t n=nshells();
+    prim_ends_.reserve(n);
+    coef_ends_.reserve(n);
+    function_ends_.reserve(n);
+    center_indices_.reserve(n);
+    for(size_t i=prim_ends_.size();i<n;++i)
+    {
+        size_t nfunctions=0;
+        for(size_t j=0;j<ngens_[i];++j)
+        {
+            const size_t l=am_2int(ls_[i],j);
+            const bool is_cart=types_[i]==ShellType::CartesianGaussian;
+            nfunctions+=(is_cart?multinomial_coefficient(3ul,l):2*l+1);
+        }
+        const bool start=(i==0);
+        prim_ends_.push_back((start ? 0 : prim_ends_[i-1])+nprims_[i]);
+        coef_ends_.push_back((start ? 0 : coef_ends_[i-1])+
+                             nprims_[i]*ngens_[i]);
+        function_ends_.push_back((start ? 0 : function_ends_[i-1])+
+                                 nfunctions);
+        center_indices_.push_back(center_id(i));
+        max_am_=std::max(max_am_,detail_::shell_max_am(ls_[i]));
+    }
 }
 
-size_t BasisSet::size()const
+size_t BasisSet::center_id(size_t i)
 {
-    size_t total=0;
-    for(size_t i=0;i<ngens.size();++i)
-        for(size_t j=0;j<ngens[i];++j)
+    const double* const center=centers_.data()+3*i;
+    //Shells on the same center are usually next to one another
+    if(i && detail_::same_center(center,center-3))
+        return center_indices_[i-1];
+    if(2*(center_firsts_.size()+1)>center_slots_.size())
+    {
+        std::vector<size_t> slots(std::max<size_t>(16,2*center_slots_.size()));
+        const size_t mask=slots.size()-1;
+        for(size_t id=0;id<center_firsts_.size();++id)
+        {
+            const double* const first=centers_.data()+3*center_firsts_[id];
+            size_t slot=detail_::center_hash(first)&mask;
+            while(slots[slot])slot=(slot+1)&mask;
+            slots[slot]=id+1;
+        }
+        center_slots_.swap(slots);
+    }
+    const size_t mask=center_slots_.size()-1;
+    for(size_t slot=detail_::center_hash(center)&mask;;slot=(slot+1)&mask)
+    {
+        const size_t id=center_slots_[slot];
+        if(!id)
         {
-            const bool is_cart=types[i]==ShellType::CartesianGaussian;
-            const size_t l=am_2int(ls[i],j);
-            total+=(is_cart?multinomial_coefficient(3ul,l):2*l+1);
+            center_firsts_.push_back(i);
+            center_slots_[slot]=center_firsts_.size();
+            return center_firsts_.size()-1;
         }
-    return total;
+        if(detail_::same_center(center,centers_.data()+3*center_firsts_[id-1]))
+            return id-1;
+    }
+}
+
+void BasisSet::swap(BasisSet& other)noexcept
+{
+    centers_.swap(other.centers_);
+    ngens_.swap(other.ngens_);
+    nprims_.swap(other.nprims_);
+    coefs_.swap(other.coefs_);
+    alphas_.swap(other.alphas_);
+    types_.swap(other.types_);
+    ls_.swap(other.ls_);
+    prim_ends_.swap(other.prim_ends_);
+    coef_ends_.swap(other.coef_ends_);
+    function_ends_.swap(other.function_ends_);
+    center_indices_.swap(other.center_indices_);
+    center_firsts_.swap(other.center_firsts_);
+    center_slots_.swap(other.center_slots_);
+    std::swap(max_am_,other.max_am_);
 }
 
 namespace detail_{
@@ -71,32 +202,18 @@ namespace detail_{
 BasisSet ungeneralize_basis_set(const BasisSet &bs)
 {
     BasisSet rv;
-    size_t offset=0;
-    const size_t nshells=bs.ngens.size();
-    for(size_t shell=0; shell<nshells; ++shell)
+    for(const ShellView& shell: bs.shells())
     {
-        //coef runs from 0 to ngen*nprims
-        for(size_t cont=0,coef=0;cont<bs.ngens[shell];++cont)
+        //Each general contraction becomes a shell on the same center, with
+        //the same exponents, and that contraction's coefficients
+        for(size_t cont=0;cont<shell.ngen;++cont)
         {
-            rv.ngens.push_back(1);
-            //For each general contraction need to duplicate the center,
-            for(size_t i=0;i<3;i++)
-                rv.centers.push_back(bs.centers[3*shell+i]);
-            //...the number of primitives,
-            rv.nprims.push_back(bs.nprims[shell]);
-            //...the type
-            rv.types.push_back(bs.types[shell]);
-            //...the angular momentum
-            rv.ls.push_back(am_2int(bs.ls[shell],cont));
-            for(size_t prim=0;prim<bs.nprims[shell];++prim,++coef)
-            {
-                //...and the exponents
-                rv.alphas.push_back(bs.alphas[offset+prim]);
-
-                rv.coefs.push_back(bs.coefs[offset+coef]);
-            }
+            ShellView contraction=shell;
+            contraction.ngen=1;
+            contraction.l=am_2int(shell.l,cont);
+            contraction.coefs=shell.contraction(cont);
+            rv.add_shell(contraction);
         }
-        offset+=bs.nprims[shell];
     }
     return rv;
 }
@@ -104,13 +221,16 @@ BasisSet ungeneralize_basis_set(const BasisSet &bs)
 BasisSet& basis_set_concatenate(BasisSet& lhs, const BasisSet& rhs)
 {
     using detail_::vector_cat;
-    vector_cat(lhs.centers,rhs.centers);
-    vector_cat(lhs.coefs,rhs.coefs);
-    vector_cat(lhs.alphas,rhs.alphas);
-    vector_cat(lhs.nprims,rhs.nprims);
-    vector_cat(lhs.ngens,rhs.ngens);
-    vector_cat(lhs.types,rhs.types);
-    vector_cat(lhs.ls,rhs.ls);
+    //vector::insert can not take a range of the vector being inserted into
+    if(&lhs==&rhs)return basis_set_concatenate(lhs,BasisSet(rhs));
+    vector_cat(lhs.centers_,rhs.centers_);
+    vector_cat(lhs.coefs_,rhs.coefs_);
+    vector_cat(lhs.alphas_,rhs.alphas_);
+    vector_cat(lhs.nprims_,rhs.nprims_);
+    vector_cat(lhs.ngens_,rhs.ngens_);
+    vector_cat(lhs.types_,rhs.types_);
+    vector_cat(lhs.ls_,rhs.ls_);
+    lhs.update_offsets();
     return lhs;
 }
 
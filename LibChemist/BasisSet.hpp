@@ -1,96 +1,58 @@
 #pragma once
+#include <iterator>
+#include <vector>
 #include "LibChemist/BasisShell.hpp"
+#include "LibChemist/ShellView.hpp"
 
 namespace LibChemist {
 
 /** \brief A class for consolidating all of the basis set information about a
  *  SetOfAtoms instance.
  *
- *  \note In designing this class I am somewhat torn between making the member
- *  data private and having it be public.  Filling it in and accessing it is a
- *  somewhat non-trivial operation suggesting it should be private whereas the
- *  number of accessors required to expose the data causes me to lean towards
- *  public.  For the moment I went with public exposure as most people will not
- *  be directly building a BasisSet, but rather getting it from a SetOfAtoms; in
- *  this case they will be more interested in accessing the data.
+ *  The shells are stored as a set of flat arrays, which can be read through
+ *  the accessors of the same name, e.g. alphas() returns the exponents of all
+ *  the shells one after the other.  The arrays are only changed through
+ *  add_shell, the constructor taking them, and basis_set_concatenate, which
+ *  lets the instance keep running totals of the primitives, coefficients, and
+ *  basis functions of the shells, the index of each shell's center, and the
+ *  maximum angular momentum up to date as shells are added.  Hence size,
+ *  max_am, and the per-shell offsets are all O(1).
  *
+ *  Shells are read out with shell, or by iterating over shells, both of which
+ *  hand out ShellView instances pointing into the arrays:
  *
+ *  \code
+    for(const ShellView& shell: bs.shells())
+        for(size_t i=0;i<shell.nprim;++i)
+            use(shell.center,shell.alpha(i),shell.coef(i,0));
+    \endcode
  */
 struct BasisSet {
-    /** \brief Where the shells are centered.
-     *
-     *  This is an nshells by 3 array in row-major form.  Thus element i of this
-     *  array is actually shell (i-i%3)/3 component i%3, components running x,
-     *  y, and then z.
-     */
-    std::vector<double> centers;
-
-    /** \brief The number of general contractions in each shell.
-     *
-     *   This array is such that ngens[i] is the number of general contractions
-     *   in shell i, i in the range [0,nshells).
-     */
-    std::vector<size_t> ngens;
-
-    /** \brief The number of primitives in each shell.
-     *
-     *  This array is such that nprims[i] is the number of primitives in shell
-     *  i, i in the range [0,nshells).
-     */
-    std::vector<size_t> nprims;
-
-    /** \brief The actual expansion coefficients
-     *
-     *  This is a jagged rank 3 array where the first dimension is over shells,
-     *  the second is over the number of general contractions in that shell,
-     *  and the third is over the number of primitives in that shell.  There is
-     *  no simple mapping between the index of this array and the owner of the
-     *  coefficient.  The best we can say is that coefs[offset+j*nprims[i]+k] is
-     *  the k-th expansion coefficient in the j-th general contraction of the
-     *  i-th shell and offset is the total number of coefficients for all shells
-     *  with index lower than i.
-     */
-    std::vector<double> coefs;
-
-    /** \brief The primitives' exponents.
-     *
-     *  This is an nshells by nprimitives array where alphas[offset+i] is the
-     *  i-th primitive in the current shell, call it j, and offset is the total
-     *  number of primitives in all shells with index lower than j.
-     */
-    std::vector<double> alphas;
-
-    /** \brief The type of the shell (Cartesian, spherical, or Slater)
-     *
-     * This is an nshells element array where types[i] is the type of shell i,
-     * such that i is in the range [0,nshells).
-     *
-     */
-    std::vector<ShellType> types;
-
-    /** \brief The angular momentum of a shell.
-     *
-     * To my knowledge general contractions work such that they are of a range
-     * of angular momenta, like an sp shell, or are such that all of the
-     * contractions have the same coefficients.  This array is thus an nshells
-     * long array where ls[i] is the angular momentum of shell i, i in the range
-     * [0,nshells).  For contractions containing a single angular momentum the
-     * stored value is simply that angular momentum, in a.u., whereas for
-     * general contractions with multiple angular momentum the value is the
-     * negative of the highest angular momentum in the contraction, e.g. -1 is
-     * an sp shell.
-     */
-    std::vector<int> ls;///< The angular momentum of each shell.
+    class ShellRange;
 
     /** \brief Makes an empty BasisSet instance.
      *
      *  The resulting basis set is empty.  Shells can be added via the
-     *  add_shell member function or manually.
+     *  add_shell member function.
      *
      *  \throws No throw guarantee.
      */
     BasisSet()noexcept=default;
 
+    /** \brief Makes a BasisSet out of its arrays.
+     *
+     *  The arrays have the meanings given in the documentation of their
+     *  accessors.
+     *
+     *  \throws std::invalid_argument if the lengths of the arrays do not agree
+     *          with one another.
+     *  \throws std::bad_alloc if memory allocation fails.
+     */
+    BasisSet(std::vector<double> centers, std::vector<size_t> ngens,
+             std::vector<size_t> nprims, std::vector<double> coefs,
+             std::vector<double> alphas, std::vector<ShellType> types,
+             std::vector<int> ls);
+
     /** \brief Frees up the memory associated with the current instance.
      *
      *
@@ -110,9 +72,12 @@ struct BasisSet {
      *
      *  \param[in] other The instance to take over.
      *  \throws No throw guarantee.
-     *  \note After this call \p other will be in a valid, but undefined state.
+     *  \note After this call \p other will be empty.
      */
-    BasisSet(BasisSet&& /*other*/)noexcept=default;
+    BasisSet(BasisSet&& other)noexcept
+    {
+        swap(other);
+    }
 
     /** \brief Assigns a deep copy of another BasisSet instance to this.
      *
@@ -128,9 +93,13 @@ struct BasisSet {
      *  \param[in] other The instance to take over.
      *  \returns The current instance after taking other's memory
      *  \throws No throw guarantee.
-     *  \note After this call \p other will be in a valid, but undefined state.
+     *  \note After this call \p other will be empty.
      */
-    BasisSet& operator=(BasisSet&& /*other*/)noexcept=default;
+    BasisSet& operator=(BasisSet&& other)noexcept
+    {
+        BasisSet(std::move(other)).swap(*this);
+        return *this;
+    }
     
     /** \brief Adds a shell to the current basis set.
      *
@@ -145,6 +114,79 @@ struct BasisSet {
      */
     void add_shell(const double* center, const BasisShell& shell);
 
+    /** \brief Adds a copy of the shell \p shell views.
+     *
+     *  \param[in] shell The shell to copy, which may not point into this
+     *                   instance.
+     *  \throws As for the other overload.
+     */
+    void add_shell(const ShellView& shell);
+
+    /** \brief Where the shells are centered.
+     *
+     *  This is an nshells by 3 array in row-major form.  Thus element i of this
+     *  array is actually shell (i-i%3)/3 component i%3, components running x,
+     *  y, and then z.
+     */
+    const std::vector<double>& centers()const noexcept{return centers_;}
+
+    /** \brief The number of general contractions in each shell.
+     *
+     *   This array is such that ngens()[i] is the number of general
+     *   contractions in shell i, i in the range [0,nshells).
+     */
+    const std::vector<size_t>& ngens()const noexcept{return ngens_;}
+
+    /** \brief The number of primitives in each shell.
+     *
+     *  This array is such that nprims()[i] is the number of primitives in shell
+     *  i, i in the range [0,nshells).
+     */
+    const std::vector<size_t>& nprims()const noexcept{return nprims_;}
+
+    /** \brief The actual expansion coefficients
+     *
+     *  This is a jagged rank 3 array where the first dimension is over shells,
+     *  the second is over the number of general contractions in that shell,
+     *  and the third is over the number of primitives in that shell.  There is
+     *  no simple mapping between the index of this array and the owner of the
+     *  coefficient.  The best we can say is that
+     *  coefs()[offset+j*nprims()[i]+k] is the k-th expansion coefficient in
+     *  the j-th general contraction of the i-th shell and offset is
+     *  coefficient_offset(i).
+     */
+    const std::vector<double>& coefs()const noexcept{return coefs_;}
+
+    /** \brief The primitives' exponents.
+     *
+     *  This is an nshells by nprimitives array where alphas()[offset+i] is the
+     *  i-th primitive in the current shell, call it j, and offset is
+     *  primitive_offset(j).
+     */
+    const std::vector<double>& alphas()const noexcept{return alphas_;}
+
+    /** \brief The type of the shell (Cartesian, spherical, or Slater)
+     *
+     * This is an nshells element array where types()[i] is the type of shell
+     * i, such that i is in the range [0,nshells).
+     *
+     */
+    const std::vector<ShellType>& types()const noexcept{return types_;}
+
+    /** \brief The angular momentum of a shell.
+     *
+     * To my knowledge general contractions work such that they are of a range
+     * of angular momenta, like an sp shell, or are such that all of the
+     * contractions have the same coefficients.  This array is thus an nshells
+     * long array where ls()[i] is the angular momentum of shell i, i in the
+     * range [0,nshells).  For contractions containing a single angular
+     * momentum the stored value is simply that angular momentum, in a.u.,
+     * whereas for general contractions with multiple angular momentum the
+     * value is the negative of the highest angular momentum in the
+     * contraction, e.g. -1 is an sp shell.
+     */
+    const std::vector<int>& ls()const noexcept{return ls_;}
+
     /** \brief Returns the maximum angular momentum in the basis set.
      *
      * \note For general contractions like "sp", "spd", etc. The highest
@@ -154,7 +196,7 @@ struct BasisSet {
      * \returns The maximum angular momentum in any shell.
      * \throws No throw guarantee.
      */
-    size_t max_am()const noexcept;
+    size_t max_am()const noexcept{return max_am_;}
 
     /** \brief Returns the total number of basis functions in this basis set.
      *
@@ -162,16 +204,84 @@ struct BasisSet {
      * That is to say a general contraction "sp" has 4 functions not 1.
      *
      * \returns The number of basis functions in the basis set.
-     * \throws Throws std::bad_alloc if a temporary string representation of the
-     *         angular momentum can not be allocated.
+     * \throws No throw guarantee.
+     */
+    size_t size()const noexcept{return function_offset(nshells());}
+
+    ///Returns the number of shells in the basis set
+    size_t nshells()const noexcept{return ls_.size();}
+
+    /** \brief Returns where shell \p i's exponents start in alphas.
+     *
+     *  \param[in] i The shell, in the range [0,nshells].  nshells gives the
+     *               total number of primitives.
+     *  \throws No throw guarantee.
+     */
+    size_t primitive_offset(size_t i)const noexcept
+    {
+        return i ? prim_ends_[i-1] : 0;
+    }
+
+    /** \brief Returns where shell \p i's coefficients start in coefs.
+     *
+     *  \param[in] i The shell, in the range [0,nshells].  nshells gives the
+     *               total number of coefficients.
+     *  \throws No throw guarantee.
+     */
+    size_t coefficient_offset(size_t i)const noexcept
+    {
+        return i ? coef_ends_[i-1] : 0;
+    }
+
+    /** \brief Returns the index of shell \p i's first basis function.
+     *
+     *  \param[in] i The shell, in the range [0,nshells].  nshells gives the
+     *               total number of basis functions.
+     *  \throws No throw guarantee.
      */
-    size_t size()const;
+    size_t function_offset(size_t i)const noexcept
+    {
+        return i ? function_ends_[i-1] : 0;
+    }
+
+    /** \brief Returns the index of the center shell \p i sits on.
+     *
+     *  Centers are numbered in the order they first appear, every shell on a
+     *  center shares the index of the first shell on it, whether or not the
+     *  shells are next to each other.  Centers are the same if their
+     *  coordinates are exactly equal.
+     *
+     *  \param[in] i The shell, in the range [0,nshells).
+     *  \throws No throw guarantee.
+     */
+    size_t center_index(size_t i)const noexcept{return center_indices_[i];}
+
+    /** \brief Returns the number of distinct centers, as numbered by
+     *         center_index.
+     *
+     *  \throws No throw guarantee.
+     */
+    size_t ncenters()const noexcept{return center_firsts_.size();}
+
+    /** \brief Returns a view of shell \p i.
+     *
+     *  \param[in] i The shell, in the range [0,nshells).
+     *  \returns A view into this instance's arrays, valid until they change.
+     *  \throws No throw guarantee.
+     */
+    ShellView shell(size_t i)const noexcept
+    {
+        return make_view(i,primitive_offset(i),coefficient_offset(i));
+    }
+
+    ///Returns the shells, in order, as a range of ShellView instances
+    ShellRange shells()const noexcept;
 
     /** \brief Returns true if this instance is exactly equal to \p rhs.
      *
      *  \param[in] rhs The instance to compare to.
-     *  \returns True if all members of this are exactly equal to the
-     *  corresponding members of \p rhs.
+     *  \returns True if all arrays of this are exactly equal to the
+     *  corresponding arrays of \p rhs.
      * \throws No throw guarantee.
      */
     bool operator==(const BasisSet& other)const noexcept;
@@ -179,16 +289,268 @@ struct BasisSet {
     /** \brief Returns true if any member of this instance differs from \p rhs.
      *
      *  \param[in] rhs The instance to compare to.
-     *  \returns True if any member of this instance is not exactly equal to the
-     *  corresponding member of \p rhs.
+     *  \returns True if any array of this instance is not exactly equal to the
+     *  corresponding array of \p rhs.
      * \throws No throw guarantee.
      */
     bool operator!=(const BasisSet& rhs)const noexcept
     {
         return !((*this)==rhs);
     }
+
+private:
+    friend BasisSet& basis_set_concatenate(BasisSet&, const BasisSet&);
+
+    ///The view of shell i, whose exponents and coefficients start at prim and
+    ///coef
+    ShellView make_view(size_t i, size_t prim, size_t coef)const noexcept
+    {
+        ShellView rv;
+        rv.center=centers_.data()+3*i;
+        rv.type=types_[i];
+        rv.l=ls_[i];
+        rv.ngen=ngens_[i];
+        rv.nprim=nprims_[i];
+        rv.alphas=Span<const double>(alphas_.data()+prim,rv.nprim);
+        rv.coefs=Span<const double>(coefs_.data()+coef,rv.nprim*rv.ngen);
+        return rv;
+    }
+
+    ///Extends the running totals to cover every shell in the arrays
+    void update_offsets();
+
+    ///Returns the index of shell i's center, numbering it if it is new
+    size_t center_id(size_t i);
+
+    void swap(BasisSet& other)noexcept;
+
+    ///The arrays, as described by their accessors
+    std::vector<double> centers_;
+    std::vector<size_t> ngens_;
+    std::vector<size_t> nprims_;
+    std::vector<double> coefs_;
+    std::vector<double> alphas_;
+    std::vector<ShellType> types_;
+    std::vector<int> ls_;
+
+    ///Running totals including each shell, i.e. shell i starts at entry i-1
+    std::vector<size_t> prim_ends_, coef_ends_, function_ends_;
+
+    ///The index of each shell's center
+    std::vector<size_t> center_indices_;
+
+    ///The first shell on each center, by center index
+    std::vector<size_t> center_firsts_;
+
+    /** An open-addressing hash table of the centers, each slot holding one
+     *  plus the index of a center, or zero if it is empty.  It is kept at
+     *  most half full.
+     */
+    std::vector<size_t> center_slots_;
+
+    ///The maximum angular momentum of the shells
+    size_t max_am_=0;
+};
+
+/** \brief The shells of a BasisSet, as returned by BasisSet::shells.
+ *
+ *  This is a separate range, rather than BasisSet itself, because size of a
+ *  BasisSet is its number of basis functions whereas size of this range is
+ *  its number of shells.  The range refers to the BasisSet and is only valid
+ *  as long as it is.
+ */
+class BasisSet::ShellRange {
+public:
+    class iterator;
+    using const_iterator=iterator;
+
+    ///Returns an iterator to the first shell
+    iterator begin()const noexcept;
+
+    ///Returns an iterator just past the last shell
+    iterator end()const noexcept;
+
+    ///Returns the number of shells
+    size_t size()const noexcept
+    {
+        return bs_->nshells();
+    }
+
+    ///Returns true if there are no shells
+    bool empty()const noexcept
+    {
+        return !size();
+    }
+
+private:
+    friend struct BasisSet;
+
+    explicit ShellRange(const BasisSet* bs)noexcept:
+        bs_(bs)
+    {}
+
+    ///The basis set whose shells these are
+    const BasisSet* bs_;
+};
+
+/** \brief A random access iterator over the shells of a BasisSet.
+ *
+ *  Dereferencing the iterator makes a ShellView from the BasisSet's offsets,
+ *  which is O(1) and copies nothing.  Since the views are made on the fly the
+ *  iterator returns them by value rather than by reference, which makes it
+ *  only an input iterator as far as C++17 is concerned, hence
+ *  iterator_category; all of the random access operations are nonetheless
+ *  O(1), as C++20's iterator_concept says.
+ */
+class BasisSet::ShellRange::iterator {
+public:
+    using iterator_category=std::input_iterator_tag;
+    using iterator_concept=std::random_access_iterator_tag;
+    using value_type=ShellView;
+    using difference_type=std::ptrdiff_t;
+    using reference=ShellView;
+
+    ///What operator-> returns, as there is no ShellView to point to
+    struct pointer {
+        ShellView view;
+        const ShellView* operator->()const noexcept{return &view;}
+    };
+
+    ///Makes an iterator that belongs to no BasisSet
+    iterator()noexcept=default;
+
+    reference operator*()const noexcept
+    {
+        return bs_->shell(i_);
+    }
+
+    pointer operator->()const noexcept
+    {
+        return pointer{**this};
+    }
+
+    reference operator[](difference_type n)const noexcept
+    {
+        return bs_->shell(i_+n);
+    }
+
+    iterator& operator++()noexcept
+    {
+        ++i_;
+        return *this;
+    }
+
+    iterator operator++(int)noexcept
+    {
+        auto rv=*this;
+        ++(*this);
+        return rv;
+    }
+
+    iterator& operator--()noexcept
+    {
+        --i_;
+        return *this;
+    }
+
+    iterator operator--(int)noexcept
+    {
+        auto rv=*this;
+        --(*this);
+        return rv;
+    }
+
+    iterator& operator+=(difference_type n)noexcept
+    {
+        i_+=n;
+        return *this;
+    }
+
+    iterator& operator-=(difference_type n)noexcept
+    {
+        i_-=n;
+        return *this;
+    }
+
+    iterator operator+(difference_type n)const noexcept
+    {
+        return iterator(*this)+=n;
+    }
+
+    friend iterator operator+(difference_type n, const iterator& it)noexcept
+    {
+        return it+n;
+    }
+
+    iterator operator-(difference_type n)const noexcept
+    {
+        return iterator(*this)-=n;
+    }
+
+    difference_type operator-(const iterator& rhs)const noexcept
+    {
+        return difference_type(i_)-difference_type(rhs.i_);
+    }
+
+    bool operator==(const iterator& rhs)const noexcept
+    {
+        return bs_==rhs.bs_ && i_==rhs.i_;
+    }
+
+    bool operator!=(const iterator& rhs)const noexcept
+    {
+        return !((*this)==rhs);
+    }
+
+    bool operator<(const iterator& rhs)const noexcept
+    {
+        return i_<rhs.i_;
+    }
+
+    bool operator>(const iterator& rhs)const noexcept
+    {
+        return rhs<(*this);
+    }
+
+    bool operator<=(const iterator& rhs)const noexcept
+    {
+        return !(rhs<(*this));
+    }
+
+    bool operator>=(const iterator& rhs)const noexcept
+    {
+        return !((*this)<rhs);
+    }
+
+private:
+    friend class ShellRange;
+
+    iterator(const BasisSet* bs, size_t i)noexcept:
+        bs_(bs),i_(i)
+    {}
+
+    ///The basis set we iterate over, and the shell we are at
+    const BasisSet* bs_=nullptr;
+    size_t i_=0;
 };
 
+inline BasisSet::ShellRange BasisSet::shells()const noexcept
+{
+    return ShellRange(this);
+}
+
+inline BasisSet::ShellRange::iterator BasisSet::ShellRange::begin()const
+    noexcept
+{
+    return iterator(bs_,0);
+}
+
+inline BasisSet::ShellRange::iterator BasisSet::ShellRange::end()const
+    noexcept
+{
+    return iterator(bs_,bs_->nshells());
+}
+
 /** \relates BasisSet
  *
  * \brief Un-generalizes a BasisSet
@@ -0,0 +1,347 @@
+#include "LibChemist/BasisSetDatabase.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace LibChemist {
+namespace detail_ {
+
+//Layout of the database's header
+struct BasisDBHeader {
+    char magic[8];
+    std::uint64_t byte_order;
+    std::uint64_t version;
+    std::uint64_t nbases;
+    std::uint64_t nelements;
+    std::uint64_t nshells;
+    std::uint64_t nalphas;
+    std::uint64_t ncoefs;
+    std::uint64_t names_size;
+};
+
+constexpr char basis_db_magic[8]={'L','C','B','A','S','I','S','\0'};
+constexpr std::uint64_t basis_db_byte_order=0x0102030405060708;
+constexpr std::uint64_t basis_db_version=1;
+
+//The number of 64-bit words in each record of the tables
+constexpr size_t basis_record=4;
+constexpr size_t element_record=3;
+constexpr size_t shell_record=6;
+
+//Appends the raw bytes of data to buffer
+template<typename T>
+void append(std::string& buffer, const T* data, size_t n)
+{
+    buffer.append(reinterpret_cast<const char*>(data),n*sizeof(T));
+}
+
+}//End namespace detail_
+
+using detail_::basis_record;
+using detail_::element_record;
+using detail_::shell_record;
+
+BasisSetDatabase::BasisSetDatabase(const std::string& path):
+    file_(path)
+{
+    const std::string_view buffer=file_.data();
+    detail_::BasisDBHeader header;
+    if(buffer.size()<sizeof(header))
+        throw std::runtime_error("Not a basis set database: "+path);
+    std::memcpy(&header,buffer.data(),sizeof(header));
+    if(std::memcmp(header.magic,detail_::basis_db_magic,sizeof(header.magic)))
+        throw std::runtime_error("Not a basis set database: "+path);
+    if(header.byte_order!=detail_::basis_db_byte_order)
+        throw std::runtime_error("Basis set database has the wrong byte "
+                                 "order: "+path);
+    if(header.version!=detail_::basis_db_version)
+        throw std::runtime_error("Basis set database has format version "+
+                                 std::to_string(header.version)+", expected "+
+                                 std::to_string(detail_::basis_db_version)+
+                                 ": "+path);
+    //Sizes are checked by division, as a corrupt count could overflow
+    size_t remaining=buffer.size()-sizeof(header);
+    auto take=[&](std::uint64_t n, size_t record){
+        if(n>remaining/(8*record))
+            throw std::runtime_error("Basis set database is truncated: "+path);
+        remaining-=n*8*record;
+    };
+    take(header.nbases,basis_record);
+    take(header.nelements,element_record);
+    take(header.nshells,shell_record);
+    take(header.nalphas,1);
+    take(header.ncoefs,1);
+    if(header.names_size>remaining)
+        throw std::runtime_error("Basis set database is truncated: "+path);
+
+    //The mapping is page aligned and every table is a multiple of 8 bytes
+    const char* ptr=buffer.data()+sizeof(header);
+    nbases_=header.nbases;
+    bases_=reinterpret_cast<const std::uint64_t*>(ptr);
+    elements_=bases_+header.nbases*basis_record;
+    shells_=elements_+header.nelements*element_record;
+    alphas_=reinterpret_cast<const double*>(shells_+
+                                            header.nshells*shell_record);
+    coefs_=alphas_+header.nalphas;
+    names_=reinterpret_cast<const char*>(coefs_+header.ncoefs);
+
+    //Every offset in the tables has to point into the table it refers to
+    auto in_range=[](std::uint64_t first, std::uint64_t n, std::uint64_t size){
+        return first<=size && n<=size-first;
+    };
+    auto check=[&](bool ok){
+        if(!ok)throw std::runtime_error("Basis set database is corrupt: "+path);
+    };
+    for(size_t i=0;i<header.nbases;++i)
+    {
+        const std::uint64_t* record=bases_+i*basis_record;
+        check(in_range(record[0],record[1],header.names_size) &&
+              in_range(record[2],record[3],header.nelements));
+    }
+    for(size_t i=0;i<header.nelements;++i)
+    {
+        const std::uint64_t* element=elements_+i*element_record;
+        check(in_range(element[1],element[2],header.nshells));
+    }
+    for(size_t i=0;i<header.nshells;++i)
+    {
+        const std::uint64_t* shell=shells_+i*shell_record;
+        const std::uint64_t ngen=shell[2], nprim=shell[3];
+        check(shell[0]<=static_cast<std::uint64_t>(ShellType::Slater) &&
+              in_range(shell[4],nprim,header.nalphas) &&
+              (!nprim || ngen<=header.ncoefs/nprim) &&
+              in_range(shell[5],ngen*nprim,header.ncoefs));
+    }
+}
+
+std::vector<std::string> BasisSetDatabase::names()const
+{
+    std::vector<std::string> rv;
+    rv.reserve(size());
+    for(size_t i=0;i<size();++i)
+        rv.emplace_back(names_+bases_[i*basis_record],
+                        bases_[i*basis_record+1]);
+    return rv;
+}
+
+size_t BasisSetDatabase::find(const std::string& name)const noexcept
+{
+    size_t lo=0, hi=size();
+    while(lo<hi)
+    {
+        const size_t mid=lo+(hi-lo)/2;
+        const std::uint64_t* record=bases_+mid*basis_record;
+        const std::string_view mid_name(names_+record[0],record[1]);
+        const int cmp=mid_name.compare(name);
+        if(cmp==0)return mid;
+        if(cmp<0)lo=mid+1;
+        else hi=mid;
+    }
+    return size();
+}
+
+bool BasisSetDatabase::find(size_t ibasis, size_t Z,
+                            size_t& ielement)const noexcept
+{
+    const std::uint64_t* record=bases_+ibasis*basis_record;
+    size_t lo=record[2], hi=record[2]+record[3];
+    while(lo<hi)
+    {
+        const size_t mid=lo+(hi-lo)/2;
+        const std::uint64_t Zmid=elements_[mid*element_record];
+        if(Zmid==Z)
+        {
+            ielement=mid;
+            return true;
+        }
+        if(Zmid<Z)lo=mid+1;
+        else hi=mid;
+    }
+    return false;
+}
+
+size_t BasisSetDatabase::at(const std::string& name)const
+{
+    const size_t ibasis=find(name);
+    if(ibasis==size())
+        throw std::out_of_range("No basis set called "+name+" in database");
+    return ibasis;
+}
+
+bool BasisSetDatabase::count(const std::string& name)const noexcept
+{
+    return find(name)!=size();
+}
+
+bool BasisSetDatabase::count(const std::string& name, size_t Z)const noexcept
+{
+    const size_t ibasis=find(name);
+    size_t ielement;
+    return ibasis!=size() && find(ibasis,Z,ielement);
+}
+
+std::vector<size_t> BasisSetDatabase::elements(const std::string& name)const
+{
+    const std::uint64_t* record=bases_+at(name)*basis_record;
+    std::vector<size_t> rv;
+    rv.reserve(record[3]);
+    for(size_t i=record[2];i<record[2]+record[3];++i)
+        rv.push_back(elements_[i*element_record]);
+    return rv;
+}
+
+std::vector<BasisShellView>
+BasisSetDatabase::views(const std::string& name, size_t Z)const
+{
+    size_t ielement;
+    if(!find(at(name),Z,ielement))
+        throw std::out_of_range("Basis set "+name+" has no shells for Z="+
+                                std::to_string(Z));
+    const std::uint64_t* element=elements_+ielement*element_record;
+    std::vector<BasisShellView> rv;
+    rv.reserve(element[2]);
+    for(size_t i=element[1];i<element[1]+element[2];++i)
+    {
+        const std::uint64_t* shell=shells_+i*shell_record;
+        //l is negative for shells like SP, so it is stored two's complement
+        const int l=static_cast<std::int64_t>(shell[1]);
+        rv.push_back(BasisShellView{static_cast<ShellType>(shell[0]),l,
+                                    shell[2],shell[3],alphas_+shell[4],
+                                    coefs_+shell[5]});
+    }
+    return rv;
+}
+
+std::vector<BasisShell>
+BasisSetDatabase::shells(const std::string& name, size_t Z)const
+{
+    std::vector<BasisShell> rv;
+    for(const BasisShellView& view: views(name,Z))
+        rv.push_back(view.to_shell());
+    return rv;
+}
+
+std::map<size_t,std::vector<BasisShell>>
+BasisSetDatabase::basis_set(const std::string& name,
+                            const SetOfAtoms& atoms)const
+{
+    const size_t ibasis=at(name);
+    std::map<size_t,std::vector<BasisShell>> rv;
+    for(const Atom& ai: atoms)
+    {
+        const size_t Z=ai.Z;
+        size_t ielement;
+        if(!rv.count(Z) && find(ibasis,Z,ielement))
+            rv.emplace(Z,shells(name,Z));
+    }
+    return rv;
+}
+
+void write_basis_set_database(
+        const std::string& path,
+        const std::map<std::string,
+                       std::map<size_t,std::vector<BasisShell>>>& basis_sets)
+{
+    std::vector<std::uint64_t> bases, elements, shells;
+    std::vector<double> alphas, coefs;
+    std::string names;
+    //std::map iterates in sorted order, which is what the lookups rely on
+    for(const auto& [name,bs]: basis_sets)
+    {
+        bases.insert(bases.end(),{names.size(),name.size(),
+                                  elements.size()/element_record,bs.size()});
+        names+=name;
+        for(const auto& [Z,Z_shells]: bs)
+        {
+            elements.insert(elements.end(),{Z,shells.size()/shell_record,
+                                            Z_shells.size()});
+            for(const BasisShell& shell: Z_shells)
+            {
+                shells.insert(shells.end(),
+                              {static_cast<std::uint64_t>(shell.type),
+                               static_cast<std::uint64_t>(shell.l),shell.ngen,
+                               shell.nprim,alphas.size(),coefs.size()});
+                for(size_t i=0;i<shell.nprim;++i)
+                    alphas.push_back(shell.alpha(i));
+                for(size_t j=0;j<shell.ngen;++j)
+                    for(size_t i=0;i<shell.nprim;++i)
+                        coefs.push_back(shell.coef(i,j));
+            }
+        }
+    }
+
+    detail_::BasisDBHeader header;
+    std::memcpy(header.magic,detail_::basis_db_magic,sizeof(header.magic));
+    header.byte_order=detail_::basis_db_byte_order;
+    header.version=detail_::basis_db_version;
+    header.nbases=basis_sets.size();
+    header.nelements=elements.size()/element_record;
+    header.nshells=shells.size()/shell_record;
+    header.nalphas=alphas.size();
+    header.ncoefs=coefs.size();
+    header.names_size=names.size();
+
+    std::string buffer;
+    detail_::append(buffer,&header,1);
+    detail_::append(buffer,bases.data(),bases.size());
+    detail_::append(buffer,elements.data(),elements.size());
+    detail_::append(buffer,shells.data(),shells.size());
+    detail_::append(buffer,alphas.data(),alphas.size());
+    detail_::append(buffer,coefs.data(),coefs.size());
+    buffer+=names;
+
+    std::ofstream os(path,std::ios::binary|std::ios::trunc);
+    os.write(buffer.data(),buffer.size());
+    if(!os)
+        throw std::runtime_error("Could not write basis set database: "+path);
+}
+
+void compile_basis_set_database(const std::string& dir,
+                                const std::string& path,
+                                const BasisSetFileParser& parser,
+                                const std::string& extension,
+                                size_t nthreads)
+{
+    namespace fs=std::filesystem;
+    std::vector<fs::path> files;
+    try
+    {
+        for(const auto& entry: fs::directory_iterator(dir))
+            if(entry.is_regular_file() &&
+               (extension.empty() || entry.path().extension()==extension))
+                files.push_back(entry.path());
+    }
+    catch(const fs::filesystem_error& e)
+    {
+        throw std::runtime_error("Could not read basis set directory: "+dir+
+                                 " ("+e.what()+")");
+    }
+
+    std::vector<std::map<size_t,std::vector<BasisShell>>> parsed(files.size());
+    detail_::parallel_for(files.size(),nthreads,[&](size_t i, size_t){
+        parsed[i]=parse_basis_set_file(files[i].string(),parser);
+    });
+
+    std::map<std::string,std::map<size_t,std::vector<BasisShell>>> basis_sets;
+    for(size_t i=0;i<files.size();++i)
+    {
+        const std::string name=extension.empty() ?
+                               files[i].filename().string() :
+                               files[i].stem().string();
+        if(!basis_sets.emplace(name,std::move(parsed[i])).second)
+            throw std::runtime_error("More than one basis set file in "+dir+
+                                     " is called "+name);
+    }
+    write_basis_set_database(path,basis_sets);
+}
+
+SetOfAtoms apply_basis_set(const std::string& name, const BasisSetDatabase& db,
+                           const SetOfAtoms& atoms)
+{
+    return apply_basis_set(name,db.basis_set(name,atoms),atoms);
+}
+
+}//End namespace
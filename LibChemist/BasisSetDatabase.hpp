@@ -0,0 +1,248 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/SetOfAtoms.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+
+/** \file This file contains the machinery for a binary basis set database.
+ *
+ * Parsing a basis set file is far more expensive than reading the numbers it
+ * contains.  A basis set database is a single binary file holding any number
+ * of basis sets (e.g. one per file of a directory of G94 files).  It is
+ * written once by compile_basis_set_database and then memory mapped by
+ * BasisSetDatabase, so loading a basis set costs little more than touching the
+ * pages holding it.
+ *
+ * All integers in the database are 64-bit and in native byte order; a byte
+ * order tag in the header guards against reading a database written on a
+ * machine of the other endianness.  The layout is:
+ *
+ * \verbatim
+   header:   magic "LCBASIS\0", byte order tag, format version, and the number
+             of basis sets, elements, shells, exponents, coefficients and
+             bytes of names
+   bases:    per basis set: offset and length of its name, first element and
+             number of elements (sorted by name)
+   elements: per element: Z, first shell and number of shells (sorted by Z
+             within each basis set)
+   shells:   per shell: type, l (two's complement), ngen, nprim, offset of
+             the first exponent and offset of the first coefficient
+   alphas:   all exponents
+   coefs:    all coefficients, ngen by nprim row-major for each shell
+   names:    the names of the basis sets, back-to-back
+   \endverbatim
+ */
+
+namespace LibChemist {
+
+/** \brief A BasisShell whose exponents and coefficients live in a
+ *         BasisSetDatabase.
+ *
+ *  The exponents and coefficients are not copied, so a view is only valid for
+ *  as long as the database it came from.  The accessors mirror those of
+ *  BasisShell.
+ */
+struct BasisShellView {
+    ///The type of the shell
+    ShellType type;
+
+    ///The angular momentum of the shell
+    int l;
+
+    ///The number of general contractions in this shell
+    size_t ngen;
+
+    ///The number of primitives in this shell
+    size_t nprim;
+
+    ///A nprim long array of primitive exponents
+    const double* alphas;
+
+    ///A ngen by nprim array of expansion coefficients stored row-major
+    const double* coefs;
+
+    ///Returns the i-th exponent
+    double alpha(size_t i)const noexcept
+    {
+        return alphas[i];
+    }
+
+    ///Returns the i-th coefficient of the j-th contraction
+    double coef(size_t i, size_t j)const noexcept
+    {
+        return coefs[j*nprim+i];
+    }
+
+    /** \brief Makes a BasisShell holding a copy of the viewed data.
+     *
+     *  \throws std::bad_alloc if memory allocation fails.
+     */
+    BasisShell to_shell()const
+    {
+        return BasisShell(type,l,ngen,std::vector<double>(alphas,alphas+nprim),
+                          std::vector<double>(coefs,coefs+ngen*nprim));
+    }
+};
+
+/** \brief Read-only access to a memory-mapped basis set database.
+ *
+ *  The database is validated upon construction: every table has to fit in
+ *  the file, and every offset and length in the tables has to stay within
+ *  the table it refers to.  After that lookups are binary searches over the
+ *  mapped tables.  Since nothing is modified after
+ *  construction, an instance may be used concurrently from several threads.
+ */
+class BasisSetDatabase {
+public:
+    /** \brief Maps the database at \p path.
+     *
+     *  \param[in] path The path to the database.
+     *  \throws std::runtime_error if the file can not be mapped, is not a
+     *          basis set database, was written with a different byte order or
+     *          format version, is truncated, or is corrupt.
+     */
+    explicit BasisSetDatabase(const std::string& path);
+
+    ///Returns the number of basis sets in the database
+    size_t size()const noexcept
+    {
+        return nbases_;
+    }
+
+    /** \brief Returns the names of the basis sets in the database, sorted.
+     *
+     *  \throws std::bad_alloc if memory allocation fails.
+     */
+    std::vector<std::string> names()const;
+
+    /** \brief Returns true if the database has a basis set called \p name.
+     *
+     *  \throws No throw guarantee.
+     */
+    bool count(const std::string& name)const noexcept;
+
+    /** \brief Returns true if basis set \p name has shells for atomic number
+     *         \p Z.
+     *
+     *  \throws No throw guarantee.
+     */
+    bool count(const std::string& name, size_t Z)const noexcept;
+
+    /** \brief Returns the atomic numbers basis set \p name has shells for.
+     *
+     *  \throws std::out_of_range if there is no basis set called \p name.
+     */
+    std::vector<size_t> elements(const std::string& name)const;
+
+    /** \brief Returns views of the shells basis set \p name has for atomic
+     *         number \p Z.
+     *
+     *  \param[in] name The basis set of interest.
+     *  \param[in] Z The atomic number of interest.
+     *  \returns The shells, in the order they appeared in the basis set file.
+     *           They are only valid for the lifetime of this instance.
+     *  \throws std::out_of_range if there is no basis set called \p name or it
+     *          has no shells for \p Z.
+     */
+    std::vector<BasisShellView> views(const std::string& name, size_t Z)const;
+
+    /** \brief Same as views, but copies the shells into BasisShell instances.
+     *
+     *  \throws See views.
+     */
+    std::vector<BasisShell> shells(const std::string& name, size_t Z)const;
+
+    /** \brief Returns the shells of basis set \p name for every element in
+     *         \p atoms.
+     *
+     *  Elements of \p atoms that the basis set does not cover are skipped, as
+     *  is done by apply_basis_set.
+     *
+     *  \returns A map from atomic number to shells, in the same form
+     *           parse_basis_set_file returns.
+     *  \throws std::out_of_range if there is no basis set called \p name.
+     */
+    std::map<size_t,std::vector<BasisShell>>
+    basis_set(const std::string& name, const SetOfAtoms& atoms)const;
+
+private:
+    ///The mapped database
+    detail_::MappedFile file_;
+
+    ///The tables of the database, see the file's documentation for layout
+    ///@{
+    size_t nbases_=0;
+    const std::uint64_t* bases_=nullptr;
+    const std::uint64_t* elements_=nullptr;
+    const std::uint64_t* shells_=nullptr;
+    const double* alphas_=nullptr;
+    const double* coefs_=nullptr;
+    const char* names_=nullptr;
+    ///@}
+
+    ///Returns the index of basis set \p name, or size() if there is none
+    size_t find(const std::string& name)const noexcept;
+
+    ///Finds element \p Z of basis set \p ibasis, returns false if there is none
+    bool find(size_t ibasis, size_t Z, size_t& ielement)const noexcept;
+
+    ///Returns the index of basis set \p name, throwing if there is none
+    size_t at(const std::string& name)const;
+};
+
+/** \brief Writes a database holding the given basis sets.
+ *
+ *  \param[in] path Where to write the database.
+ *  \param[in] basis_sets A map from basis set name to the basis set, each in
+ *                        the form parse_basis_set_file returns.
+ *  \throws std::runtime_error if the database can not be written.
+ */
+void write_basis_set_database(
+        const std::string& path,
+        const std::map<std::string,
+                       std::map<size_t,std::vector<BasisShell>>>& basis_sets);
+
+/** \brief Compiles a directory of basis set files into a database.
+ *
+ *  Each regular file in \p dir whose extension is \p extension is parsed with
+ *  \p parser, and stored under its file name minus \p extension (e.g.
+ *  "dir/cc-pvdz.gbs" becomes "cc-pvdz" for an extension of ".gbs").  The files
+ *  are parsed concurrently.
+ *
+ *  \param[in] dir The directory containing the basis set files.  It is not
+ *                 searched recursively.
+ *  \param[in] path Where to write the database.
+ *  \param[in] parser The parser for the files.  It will be called
+ *                    concurrently from several threads.
+ *  \param[in] extension Only files with this extension (including the dot)
+ *                       are compiled.  An empty string means every file.
+ *  \param[in] nthreads The number of threads to use, 0 means one per hardware
+ *                      thread.
+ *  \throws std::runtime_error if \p dir can not be read, a file can not be
+ *          mapped, two files would get the same name, or the database can
+ *          not be written.
+ */
+void compile_basis_set_database(const std::string& dir,
+                                const std::string& path,
+                                const BasisSetFileParser& parser,
+                                const std::string& extension="",
+                                size_t nthreads=0);
+
+/** \relates BasisSetDatabase
+ *
+ * \brief Applies a basis set from a database to each atom in a SetOfAtoms.
+ *
+ * \param[in] name The basis set to apply, it is also used as the key under
+ *                 which the basis set is applied.
+ * \param[in] db The database to take the shells from.
+ * \param[in] atoms The instance to apply the basis set to.
+ * \returns A deep copy of \p atoms with the basis set applied to it.
+ * \throws std::out_of_range if there is no basis set called \p name.
+ */
+SetOfAtoms apply_basis_set(const std::string& name, const BasisSetDatabase& db,
+                           const SetOfAtoms& atoms);
+
+}//End namespace
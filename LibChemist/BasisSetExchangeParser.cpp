@@ -0,0 +1,191 @@
+#include "LibChemist/BasisSetExchangeParser.hpp"
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/JsonReader.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+#include <charconv>
+#include <stdexcept>
+
+namespace LibChemist {
+
+using basis_type=std::map<size_t,std::vector<BasisShell>>;
+
+namespace detail_ {
+
+using token_type=JsonReader::token_type;
+
+[[noreturn]] void malformed_bse(const std::string& what)
+{
+    throw std::runtime_error("Malformed Basis Set Exchange JSON: "+what);
+}
+
+void expect(JsonReader& reader, token_type type, const char* what)
+{
+    if(reader.next()!=type)malformed_bse(std::string("expected ")+what);
+}
+
+//Reads the numbers (stored as numbers or strings) of an already opened array
+void read_numbers(JsonReader& reader, std::vector<double>& values)
+{
+    for(token_type t;(t=reader.next())!=token_type::end_array;)
+    {
+        double value;
+        if((t!=token_type::number && t!=token_type::string) ||
+           !to_double(reader.value(),value))
+            malformed_bse("expected a number");
+        values.push_back(value);
+    }
+}
+
+ShellType bse_shell_type(std::string_view function_type)
+{
+    if(function_type=="gto" || function_type=="gto_spherical")
+        return ShellType::SphericalGaussian;
+    if(function_type=="gto_cartesian")
+        return ShellType::CartesianGaussian;
+    if(function_type=="sto")
+        return ShellType::Slater;
+    malformed_bse("unknown function type "+std::string(function_type));
+}
+
+//Reads a shell whose opening brace has just been read
+BasisShell read_bse_shell(JsonReader& reader)
+{
+    ShellType type=ShellType::SphericalGaussian;
+    std::vector<double> ams, alphas, coefs;
+    size_t ngen=0;
+    for(token_type t;(t=reader.next())!=token_type::end_object;)
+    {
+        const std::string_view key=reader.value();
+        if(key=="function_type")
+        {
+            expect(reader,token_type::string,"a function type");
+            type=bse_shell_type(reader.value());
+        }
+        else if(key=="angular_momentum")
+        {
+            expect(reader,token_type::begin_array,"angular momenta");
+            read_numbers(reader,ams);
+        }
+        else if(key=="exponents")
+        {
+            expect(reader,token_type::begin_array,"exponents");
+            read_numbers(reader,alphas);
+        }
+        else if(key=="coefficients")
+        {
+            //BasisShell stores the contractions one after the other, as here
+            expect(reader,token_type::begin_array,"coefficients");
+            for(token_type c;(c=reader.next())!=token_type::end_array;++ngen)
+            {
+                if(c!=token_type::begin_array)
+                    malformed_bse("expected a list of coefficients");
+                read_numbers(reader,coefs);
+            }
+        }
+        else
+            reader.skip(reader.next());
+    }
+
+    const size_t nprim=alphas.size();
+    if(!nprim || !ngen || coefs.size()!=nprim*ngen)
+        malformed_bse("shell has "+std::to_string(nprim)+" exponents and "+
+                      std::to_string(coefs.size())+" coefficients in "+
+                      std::to_string(ngen)+" contractions");
+    if(ams.empty())malformed_bse("shell has no angular momentum");
+    for(size_t i=0;i<ams.size();++i)
+        if(ams[i]<0 || ams[i]!=static_cast<int>(ams[i]) ||
+           (ams.size()>1 && ams[i]!=i))
+            malformed_bse("unsupported angular momenta for a shell");
+    if(ams.size()>1 && ams.size()!=ngen)
+        malformed_bse("fused shell needs one contraction per angular "
+                      "momentum");
+    const int l=(ams.size()>1 ? 1-static_cast<int>(ams.size()) :
+                                static_cast<int>(ams[0]));
+    return BasisShell(type,l,ngen,std::move(alphas),std::move(coefs));
+}
+
+//Reads the shells of an element whose opening brace has just been read
+void read_bse_element(JsonReader& reader, std::vector<BasisShell>& shells)
+{
+    for(token_type t;(t=reader.next())!=token_type::end_object;)
+    {
+        if(reader.value()!="electron_shells")
+        {
+            reader.skip(reader.next());
+            continue;
+        }
+        expect(reader,token_type::begin_array,"a list of shells");
+        for(token_type s;(s=reader.next())!=token_type::end_array;)
+        {
+            if(s!=token_type::begin_object)malformed_bse("expected a shell");
+            shells.push_back(read_bse_shell(reader));
+        }
+    }
+}
+
+basis_type read_bse(JsonReader& reader)
+{
+    basis_type rv;
+    expect(reader,token_type::begin_object,"an object");
+    for(token_type t;(t=reader.next())!=token_type::end_object;)
+    {
+        if(reader.value()!="elements")
+        {
+            reader.skip(reader.next());
+            continue;
+        }
+        expect(reader,token_type::begin_object,"a map of elements");
+        for(token_type e;(e=reader.next())!=token_type::end_object;)
+        {
+            const std::string_view key=reader.value();
+            size_t Z=0;
+            const auto result=std::from_chars(key.data(),key.data()+key.size(),
+                                              Z);
+            if(result.ec!=std::errc() || result.ptr!=key.data()+key.size())
+                malformed_bse("bad atomic number "+std::string(key));
+            expect(reader,token_type::begin_object,"an element");
+            std::vector<BasisShell> shells;
+            read_bse_element(reader,shells);
+            if(shells.empty())continue;
+            auto& element=rv[Z];
+            if(element.empty())
+                element=std::move(shells);
+            else
+                element.insert(element.end(),
+                               std::make_move_iterator(shells.begin()),
+                               std::make_move_iterator(shells.end()));
+        }
+    }
+    expect(reader,token_type::end,"the end of the document");
+    return rv;
+}
+
+}//End namespace detail_
+
+basis_type parse_bse_json(std::istream& is)
+{
+    detail_::JsonReader reader([&is](char* buffer, size_t n){
+        is.read(buffer,n);
+        if(is.bad())throw std::runtime_error("Could not read stream");
+        return static_cast<size_t>(is.gcount());
+    });
+    return detail_::read_bse(reader);
+}
+
+basis_type parse_bse_json_buffer(std::string_view buffer)
+{
+    detail_::JsonReader reader(buffer);
+    return detail_::read_bse(reader);
+}
+
+basis_type parse_bse_json_file(const std::string& path)
+{
+    const detail_::MappedFile file(path);
+    if(!detail_::is_gzip(file.data()))
+        return parse_bse_json_buffer(file.data());
+    detail_::JsonReader reader(
+                detail_::gzip_source(detail_::memory_source(file.data())));
+    return detail_::read_bse(reader);
+}
+
+}//End namespace
@@ -0,0 +1,84 @@
+#pragma once
+#include <istream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LibChemist/BasisShell.hpp"
+
+/** \file This file contains the reader for the JSON format of the Basis Set
+ *  Exchange (BSE).
+ *
+ * The documents look like:
+ *
+ * \verbatim
+   {
+     "name": "STO-3G",
+     ...
+     "elements": {
+       "1": {
+         "electron_shells": [
+           {
+             "function_type": "gto",
+             "angular_momentum": [0],
+             "exponents": ["3.42525091", "0.62391373", "0.16885540"],
+             "coefficients": [["0.15432897", "0.53532814", "0.44463454"]]
+           }
+         ],
+         ...
+       },
+       ...
+     }
+   }
+   \endverbatim
+ *
+ * The documents are read token by token and the shells are built as their
+ * tokens go by, i.e. the document is never held in memory as a whole.  Only
+ * the electron shells are read, everything else (references, ECPs,...) is
+ * skipped.
+ *
+ * A shell with a single angular momentum and several lists of coefficients is
+ * a general contraction.  A shell with angular momenta 0,1,...,n is the fused
+ * shell sp, spd,... with one list of coefficients per angular momentum; as
+ * for G94 it gets angular momentum -n.  Shells with function type "gto" or
+ * "gto_spherical" are SphericalGaussian, "gto_cartesian" are
+ * CartesianGaussian, and "sto" are Slater.
+ */
+
+namespace LibChemist {
+
+/** \brief Reads a BSE JSON document from \p is.
+ *
+ *  \param[in] is The stream holding the document.
+ *  \returns A map from atomic number to the shells for that atom, like
+ *           parse_basis_set_file.
+ *  \throws std::runtime_error if the document is not valid JSON or a shell is
+ *          malformed, e.g. has a number of coefficients that does not match
+ *          its number of exponents.
+ */
+std::map<size_t,std::vector<BasisShell>> parse_bse_json(std::istream& is);
+
+/** \brief Reads a BSE JSON document that has already been read into memory.
+ *
+ *  \param[in] buffer The document.
+ *  \returns A map from atomic number to the shells for that atom.
+ *  \throws std::runtime_error under the same conditions as the std::istream
+ *          overload.
+ */
+std::map<size_t,std::vector<BasisShell>>
+parse_bse_json_buffer(std::string_view buffer);
+
+/** \brief Reads the BSE JSON document at \p path.
+ *
+ *  The file is memory mapped and read in place.  gzip-compressed files are
+ *  decompressed a chunk at a time as the document is read.
+ *
+ *  \param[in] path The path to the document.
+ *  \returns A map from atomic number to the shells for that atom.
+ *  \throws std::runtime_error if the file can not be read or decompressed,
+ *          plus anything parse_bse_json throws.
+ */
+std::map<size_t,std::vector<BasisShell>>
+parse_bse_json_file(const std::string& path);
+
+}//End namespace
@@ -0,0 +1,76 @@
+#include "LibChemist/BasisSetLibrary.hpp"
+#include "LibChemist/detail_/GzipSource.hpp"
+#include <stdexcept>
+
+namespace LibChemist {
+
+BasisSetLibrary::BasisSetLibrary(const std::string& path,
+                                 const BasisSetFileParser& parser):
+    file_(path),parser_(&parser)
+{
+    const std::string_view buffer=file_.data();
+    if(detail_::is_gzip(buffer))
+        throw std::runtime_error("A BasisSetLibrary needs random access to "
+                                 "the file, it can not be gzip-compressed: "+
+                                 path);
+    size_t Z=0, start=0, offset=0;
+    while(offset<buffer.size())
+    {
+        size_t eol=buffer.find('\n',offset);
+        if(eol==std::string_view::npos)eol=buffer.size();
+        const size_t new_Z=parser.new_atom(buffer.substr(offset,eol-offset));
+        if(new_Z)
+        {
+            if(Z)blocks_[Z].emplace_back(start,offset);
+            Z=new_Z;
+            start=offset;
+        }
+        offset=eol+1;
+    }
+    if(Z)blocks_[Z].emplace_back(start,buffer.size());
+}
+
+std::vector<size_t> BasisSetLibrary::elements()const
+{
+    std::vector<size_t> rv;
+    for(const auto& block: blocks_)
+        rv.push_back(block.first);
+    return rv;
+}
+
+const std::vector<BasisShell>& BasisSetLibrary::shells(size_t Z)
+{
+    auto it=cache_.find(Z);
+    if(it!=cache_.end())return it->second;
+    std::vector<BasisShell> rv;
+    for(const auto& [begin,end]: blocks_.at(Z))
+    {
+        const auto block=file_.data().substr(begin,end-begin);
+        auto parsed=parse_basis_set_buffer(block,*parser_);
+        auto& block_shells=parsed[Z];
+        rv.insert(rv.end(),std::make_move_iterator(block_shells.begin()),
+                  std::make_move_iterator(block_shells.end()));
+    }
+    return cache_.emplace(Z,std::move(rv)).first->second;
+}
+
+std::map<size_t,std::vector<BasisShell>>
+BasisSetLibrary::basis_set(const SetOfAtoms& atoms)
+{
+    std::map<size_t,std::vector<BasisShell>> rv;
+    for(const Atom& ai: atoms)
+    {
+        const size_t Z=ai.Z;
+        if(!rv.count(Z) && count(Z))
+            rv.emplace(Z,shells(Z));
+    }
+    return rv;
+}
+
+SetOfAtoms apply_basis_set(const std::string& name, BasisSetLibrary& bs,
+                           const SetOfAtoms& atoms)
+{
+    return apply_basis_set(name,bs.basis_set(atoms),atoms);
+}
+
+}//End namespace
@@ -0,0 +1,105 @@
+#pragma once
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "LibChemist/BasisSetParser.hpp"
+#include "LibChemist/SetOfAtoms.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+
+namespace LibChemist {
+
+/** \brief A basis set file whose elements are parsed on demand.
+ *
+ *  Basis set libraries commonly cover most of the periodic table, whereas a
+ *  calculation only needs the elements present in the system.  Upon
+ *  construction this class maps the file and makes a single pass over it,
+ *  using the parser's new_atom function to record where each element's
+ *  block(s) of the file start and end.  The shells of an element are only
+ *  parsed the first time they are requested, after which they are cached.
+ *
+ *  \threading Retrieving shells modifies the cache, so concurrent calls to
+ *  shells or basis_set on the same instance may result in data races.
+ */
+class BasisSetLibrary {
+public:
+    /** \brief Indexes the basis set file at \p path.
+     *
+     *  \param[in] path The path to the basis set file.
+     *  \param[in] parser The parser for the file.  \p parser must outlive the
+     *                    current instance.
+     *  \throws std::runtime_error if the file can not be opened or mapped, or
+     *          is gzip-compressed.
+     */
+    BasisSetLibrary(const std::string& path, const BasisSetFileParser& parser);
+
+    ///The parser must outlive the instance, so temporaries are not allowed
+    BasisSetLibrary(const std::string&, const BasisSetFileParser&&)=delete;
+
+    /** \brief Returns true if the library has shells for atomic number \p Z.
+     *
+     * \throws No throw guarantee.
+     */
+    bool count(size_t Z)const noexcept
+    {
+        return blocks_.count(Z);
+    }
+
+    /** \brief Returns the atomic numbers the library has shells for.
+     *
+     * \throws std::bad_alloc if memory allocation fails.
+     */
+    std::vector<size_t> elements()const;
+
+    /** \brief Returns the shells for atomic number \p Z, parsing them if this
+     *         is the first time they have been requested.
+     *
+     *  \param[in] Z The atomic number of interest.
+     *  \returns The shells for \p Z, in the order they appear in the file.
+     *  \throws std::out_of_range if the library has no shells for \p Z.
+     */
+    const std::vector<BasisShell>& shells(size_t Z);
+
+    /** \brief Returns the shells for every element in \p atoms.
+     *
+     *  Elements of \p atoms that the library does not cover are skipped, as
+     *  is done by apply_basis_set.
+     *
+     *  \param[in] atoms The atoms whose elements we need.
+     *  \returns A map from atomic number to shells, in the same form
+     *           parse_basis_set_file returns.
+     */
+    std::map<size_t,std::vector<BasisShell>>
+    basis_set(const SetOfAtoms& atoms);
+
+private:
+    ///The mapped file
+    detail_::MappedFile file_;
+
+    ///The parser for the file
+    const BasisSetFileParser* parser_;
+
+    ///The [begin,end) byte ranges of each element's blocks
+    std::map<size_t,std::vector<std::pair<size_t,size_t>>> blocks_;
+
+    ///The elements we have already parsed
+    std::map<size_t,std::vector<BasisShell>> cache_;
+};
+
+/** \relates BasisSetLibrary
+ *
+ * \brief Applies the shells in a basis set library to each atom in a
+ *        SetOfAtoms.
+ *
+ * Only the elements present in \p atoms are parsed.
+ *
+ * \param[in] name The key under which to apply the basis set.
+ * \param[in] bs The library to take the shells from.
+ * \param[in] atoms The instance to apply the basis set to.
+ * \returns A deep copy of \p atoms with the basis set applied to it.
+ * \throws std::bad_alloc if memory allocation fails.  Strong throw guarantee.
+ */
+SetOfAtoms apply_basis_set(const std::string& name, BasisSetLibrary& bs,
+                           const SetOfAtoms& atoms);
+
+}//End namespace
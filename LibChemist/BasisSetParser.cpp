@@ -1,13 +1,19 @@
 #include "LibChemist/BasisSetParser.hpp"
-#include "LibChemist/lut/AtomicInfo.hpp"
 #include "LibChemist/ShellTypes.hpp"
-#include<regex>
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <array>
+#include <cctype>
+#include <stdexcept>
 
 namespace LibChemist {
 
 using data_type=BasisSetFileParser::data_type;
 using action_type=BasisSetFileParser::action_type;
 using return_type=std::map<size_t,std::vector<BasisShell>>;
+using ecp_return_type=std::map<size_t,ECP>;
 using parsed_type=std::map<data_type,std::vector<double>>;
 
 namespace detail_{
@@ -16,121 +22,565 @@ namespace detail_{
 struct shell{
     //TODO: get correct angular moemntum
     ShellType type=ShellType::SphericalGaussian;
-    int l;
-    size_t ngen;
+    int l=0;
+    size_t ngen=1;
     std::vector<double> alphas;
+    //Stored primitive-major, i.e. in the order they appear in the file
     std::vector<double> cs;
 };
 
-//factors out reading of the instance returned by a parser's parse function
-void parse(const parsed_type& data, shell& s)
-{
-    if(data.count(data_type::exponent))
-        s.alphas.push_back(data.at(data_type::exponent)[0]);
-    if(data.count(data_type::coefficient))
+//Handler used by parse_basis_set_file to assemble the shells
+struct ShellBuilder: public BasisSetFileHandler {
+    return_type rv;
+    size_t Z=0;
+    shell s;
+    //Scratch space for transposing the coefficients, reused between shells
+    std::vector<double> buffer;
+
+    //Adds the current shell to our return value
+    void commit_shell()
     {
-        for(auto x: data.at(data_type::coefficient))
-            s.cs.push_back(x);
+        if(s.alphas.size()!=0 && Z!=0)
+        {
+            //BasisShell wants the coefficients general contraction-major
+            const size_t nprim=s.alphas.size();
+            if(s.cs.size()!=nprim*s.ngen)
+                throw std::out_of_range("Shell has the wrong number of "
+                                        "coefficients");
+            buffer.resize(s.cs.size());
+            for(size_t i=0;i<nprim;++i)
+                for(size_t j=0;j<s.ngen;++j)
+                    buffer[j*nprim+i]=s.cs[i*s.ngen+j];
+            rv[Z].push_back(BasisShell(s.type,s.l,s.ngen,s.alphas,buffer));
+        }
+        s.alphas.clear();
+        s.cs.clear();
     }
-    if(data.count(data_type::angular_momentum))
+
+    void finish(){commit_shell();}
+
+    void on_atom(size_t Z_)override
+    {
+        commit_shell();
+        Z=Z_;
+    }
+
+    void on_shell(int l)override
+    {
+        commit_shell();
+        s.l=l;
+        s.ngen=(l<0?-1*l+1:1);
+    }
+
+    void on_primitive(double alpha, const double* coefs, size_t ncoefs)override
+    {
+        s.alphas.push_back(alpha);
+        s.cs.insert(s.cs.end(),coefs,coefs+ncoefs);
+    }
+};
+
+//Handler used by parse_ecp_file to assemble the ECPs
+struct ECPBuilder: public BasisSetFileHandler {
+    ecp_return_type rv;
+    size_t Z=0;
+    //Whether we are in an ECP, and the ECP's channels in file order
+    bool in_ecp=false;
+    ECP ecp;
+    std::vector<size_t> nterms;
+    std::vector<std::vector<int>> powers;
+    std::vector<std::vector<double>> alphas, coefs;
+
+    //Adds the current ECP to our return value, sorting the channels by l
+    void commit_ecp()
+    {
+        if(!in_ecp)return;
+        in_ecp=false;
+        const size_t nchannels=ecp.lmax+1;
+        const std::string where=" in the ECP for Z="+std::to_string(Z);
+        if(nterms.size()!=nchannels)
+            throw std::runtime_error("Wrong number of channels"+where);
+        ecp.offsets.assign(1,0);
+        for(size_t l=0;l<nchannels;++l)
+        {
+            //The local channel comes first in the file
+            const size_t i=(l+1)%nchannels;
+            if(alphas[i].size()!=nterms[i])
+                throw std::runtime_error("Wrong number of terms"+where);
+            ecp.powers.insert(ecp.powers.end(),powers[i].begin(),
+                              powers[i].end());
+            ecp.alphas.insert(ecp.alphas.end(),alphas[i].begin(),
+                              alphas[i].end());
+            ecp.coefs.insert(ecp.coefs.end(),coefs[i].begin(),coefs[i].end());
+            ecp.offsets.push_back(ecp.alphas.size());
+        }
+        rv[Z]=std::move(ecp);
+    }
+
+    void finish(){commit_ecp();}
+
+    void on_atom(size_t Z_)override
+    {
+        commit_ecp();
+        Z=Z_;
+    }
+
+    void on_shell(int)override{commit_ecp();}
+
+    void on_primitive(double, const double*, size_t)override{commit_ecp();}
+
+    void on_ecp(int lmax, size_t ncore)override
+    {
+        commit_ecp();
+        if(Z==0)return;
+        in_ecp=true;
+        ecp=ECP();
+        ecp.lmax=lmax;
+        ecp.ncore=ncore;
+        nterms.clear();
+        powers.assign(lmax+1,{});
+        alphas.assign(lmax+1,{});
+        coefs.assign(lmax+1,{});
+    }
+
+    void on_ecp_channel(size_t n)override
+    {
+        if(!in_ecp)return;
+        if(nterms.size()==alphas.size())
+            throw std::runtime_error("Too many channels in the ECP for Z="+
+                                     std::to_string(Z));
+        nterms.push_back(n);
+    }
+
+    void on_ecp_term(int n, double alpha, double coef)override
     {
-        s.l=data.at(data_type::angular_momentum)[0];
-        s.ngen=(s.l<0?-1*s.l+1:1);
+        if(!in_ecp)return;
+        if(nterms.empty())
+            throw std::runtime_error("ECP term outside of a channel for Z="+
+                                     std::to_string(Z));
+        const size_t i=nterms.size()-1;
+        powers[i].push_back(n);
+        alphas[i].push_back(alpha);
+        coefs[i].push_back(coef);
     }
+};
+
+//Runs a Builder over the lines of is and returns what it built
+template<typename Builder>
+auto build_from_stream(std::istream& is, const BasisSetFileParser& parser)
+{
+    Builder builder;
+    for_each_stream_line(is,[&](std::string_view line){
+        parser.parse_line(line,builder);
+    });
+    builder.finish();
+    return std::move(builder.rv);
+}
+
+//Runs a Builder over the lines of buffer and returns what it built
+template<typename Builder>
+auto build_from_buffer(std::string_view buffer,
+                       const BasisSetFileParser& parser)
+{
+    Builder builder;
+    for_each_line(buffer,[&](std::string_view line){
+        parser.parse_line(line,builder);
+    });
+    builder.finish();
+    return std::move(builder.rv);
 }
 
-//Code factorization for adding the shell to our return value
-void commit_shell(shell& s,size_t Z,return_type& rv)
+//Runs a Builder over the lines of the file at path and returns what it built
+template<typename Builder>
+auto build_from_file(const std::string& path, const BasisSetFileParser& parser,
+                     ReadMode mode)
 {
-    if(s.alphas.size()!=0 && Z!=0)
-        rv[Z].push_back(BasisShell(s.type,s.l,s.ngen,s.alphas,s.cs));
-    s=shell();
+    Builder builder;
+    auto parse_line=[&](std::string_view line){
+        parser.parse_line(line,builder);
+    };
+    if(mode==ReadMode::pipelined)
+        for_each_pipelined_line(path,parse_line);
+    else
+    {
+        const MappedFile file(path);
+        for_each_file_line(file.data(),parse_line);
+    }
+    builder.finish();
+    return std::move(builder.rv);
 }
 
+//Handler used to implement worth_parsing in terms of parse_line
+struct ActionProbe: public BasisSetFileHandler {
+    action_type action=action_type::none;
+    void set(action_type a)
+    {
+        if(action==action_type::none)action=a;
+    }
+    void on_atom(size_t)override{set(action_type::new_atom);}
+    void on_shell(int)override{set(action_type::new_shell);}
+    void on_primitive(double, const double*, size_t)override
+    {
+        set(action_type::same_shell);
+    }
+};
+
+//Handler used to implement parse in terms of parse_line
+struct MapBuilder: public BasisSetFileHandler {
+    parsed_type rv;
+    void on_atom(size_t Z)override
+    {
+        rv[data_type::Z].push_back(Z);
+    }
+    void on_shell(int l)override
+    {
+        rv[data_type::angular_momentum].push_back(l);
+    }
+    void on_primitive(double alpha, const double* coefs, size_t ncoefs)override
+    {
+        rv[data_type::exponent].push_back(alpha);
+        if(ncoefs)
+            rv[data_type::coefficient].assign(coefs,coefs+ncoefs);
+    }
+};
+
+//Handler used to implement new_atom in terms of parse_line
+struct AtomProbe: public BasisSetFileHandler {
+    size_t Z=0;
+    void on_atom(size_t Z_)override{if(!Z)Z=Z_;}
+    void on_shell(int)override{}
+    void on_primitive(double, const double*, size_t)override{}
+};
+
 }//End namespace detail_
 
+action_type BasisSetFileParser::worth_parsing(const std::string& line)const
+{
+    detail_::ActionProbe probe;
+    parse_line(line,probe);
+    return probe.action;
+}
+
+parsed_type BasisSetFileParser::parse(const std::string& line)const
+{
+    detail_::MapBuilder builder;
+    parse_line(line,builder);
+    return builder.rv;
+}
+
+void MapBasisSetFileParser::parse_line(std::string_view line,
+                                       BasisSetFileHandler& handler)const
+{
+    const std::string temp(line);
+    const action_type action=worth_parsing(temp);
+    if(action==action_type::none)return;
+    const auto data=parse(temp);
+    if(action==action_type::new_atom)
+        handler.on_atom(data.at(data_type::Z)[0]);
+    if(data.count(data_type::angular_momentum))
+        handler.on_shell(data.at(data_type::angular_momentum)[0]);
+    if(data.count(data_type::exponent))
+    {
+        const double alpha=data.at(data_type::exponent)[0];
+        if(data.count(data_type::coefficient))
+        {
+            const auto& cs=data.at(data_type::coefficient);
+            handler.on_primitive(alpha,cs.data(),cs.size());
+        }
+        else
+            handler.on_primitive(alpha,nullptr,0);
+    }
+}
+
+size_t BasisSetFileParser::new_atom(std::string_view line)const
+{
+    detail_::AtomProbe probe;
+    parse_line(line,probe);
+    return probe.Z;
+}
 
 return_type parse_basis_set_file(std::istream& is,
                                  const BasisSetFileParser& parser)
 {
-    return_type rv;
-    size_t Z=0;
-    detail_::shell s;
-    while(is)
+    return detail_::build_from_stream<detail_::ShellBuilder>(is,parser);
+}
+
+return_type parse_basis_set_buffer(std::string_view buffer,
+                                   const BasisSetFileParser& parser)
+{
+    return detail_::build_from_buffer<detail_::ShellBuilder>(buffer,parser);
+}
+
+return_type parse_basis_set_file(const std::string& path,
+                                 const BasisSetFileParser& parser,
+                                 ReadMode mode)
+{
+    return detail_::build_from_file<detail_::ShellBuilder>(path,parser,mode);
+}
+
+ecp_return_type parse_ecp_file(std::istream& is,
+                               const BasisSetFileParser& parser)
+{
+    return detail_::build_from_stream<detail_::ECPBuilder>(is,parser);
+}
+
+ecp_return_type parse_ecp_buffer(std::string_view buffer,
+                                 const BasisSetFileParser& parser)
+{
+    return detail_::build_from_buffer<detail_::ECPBuilder>(buffer,parser);
+}
+
+ecp_return_type parse_ecp_file(const std::string& path,
+                               const BasisSetFileParser& parser, ReadMode mode)
+{
+    return detail_::build_from_file<detail_::ECPBuilder>(path,parser,mode);
+}
+
+namespace detail_ {
+
+//Below this many bytes per thread it's not worth parsing in parallel
+constexpr size_t min_parallel_chunk=1<<16;
+
+/* Returns the offset of the first line at or after offset that starts a new
+ * atom (or the end of the buffer if there is none).  offset is assumed to be
+ * the start of a line.
+ */
+size_t next_atom_line(std::string_view buffer, size_t offset,
+                      const BasisSetFileParser& parser)
+{
+    while(offset<buffer.size())
     {
-        std::string line;
-        std::getline(is,line);
-        switch(parser.worth_parsing(line)){
-        case(action_type::none)://Junk line
+        size_t eol=buffer.find('\n',offset);
+        if(eol==std::string_view::npos)eol=buffer.size();
+        if(parser.new_atom(buffer.substr(offset,eol-offset)))return offset;
+        offset=eol+1;
+    }
+    return buffer.size();
+}
+
+//Splits buffer into at most nchunks pieces, each starting at a new atom
+std::vector<size_t> split_at_atoms(std::string_view buffer, size_t nchunks,
+                                   const BasisSetFileParser& parser)
+{
+    std::vector<size_t> bounds(1,0);
+    const size_t chunk_size=buffer.size()/nchunks;
+    for(size_t i=1;i<nchunks;++i)
+    {
+        //Start of the first full line past the nominal split point
+        size_t offset=buffer.find('\n',std::max(i*chunk_size,bounds.back()));
+        if(offset==std::string_view::npos)break;
+        offset=next_atom_line(buffer,offset+1,parser);
+        if(offset==buffer.size())break;
+        if(offset>bounds.back())bounds.push_back(offset);
+    }
+    bounds.push_back(buffer.size());
+    return bounds;
+}
+
+}//End namespace detail_
+
+return_type parse_basis_set_file(const std::string& path,
+                                 const BasisSetFileParser& parser,
+                                 size_t nthreads)
+{
+    const detail_::MappedFile file(path);
+    const std::string_view buffer=file.data();
+    nthreads=std::min(detail_::resolve_nthreads(nthreads),
+                      buffer.size()/detail_::min_parallel_chunk);
+    //Compressed files can't be split, but are decompressed concurrently
+    if(nthreads<2 || detail_::is_gzip(buffer))
+        return parse_basis_set_file(path,parser);
+
+    //Extra chunks so a thread that gets small elements can pick up more work
+    const auto bounds=detail_::split_at_atoms(buffer,4*nthreads,parser);
+    const size_t nchunks=bounds.size()-1;
+    std::vector<return_type> chunks(nchunks);
+    detail_::parallel_for(nchunks,nthreads,[&](size_t i, size_t){
+        const auto chunk=buffer.substr(bounds[i],bounds[i+1]-bounds[i]);
+        chunks[i]=parse_basis_set_buffer(chunk,parser);
+    });
+
+    //Merge, in file order, so shells end up in the same order as serially
+    return_type rv=std::move(chunks[0]);
+    for(size_t i=1;i<nchunks;++i)
+        for(auto& [Z,shells]: chunks[i])
         {
-            break;
+            auto& rv_shells=rv[Z];
+            rv_shells.insert(rv_shells.end(),
+                             std::make_move_iterator(shells.begin()),
+                             std::make_move_iterator(shells.end()));
         }
-        case(action_type::new_atom)://Implies new shell
+    return rv;
+}
+
+namespace detail_ {
+
+//The most numbers we expect on a line, one exponent and spdfgh coefficients
+constexpr size_t max_g94_values=7;
+
+//What a G94 line holds, the basis set lines are the same as for action_type
+enum class g94_line{none,new_atom,new_shell,same_shell,ecp,ecp_channel,
+                    ecp_term};
+
+//True if word spells an angular momentum, e.g. "S", "sp", or "F"
+bool is_am(std::string_view word)noexcept
+{
+    constexpr std::string_view singles("spdfghijklmnoqrtuvwxyz");
+    constexpr std::string_view combined("spdfgh");
+    if(word.empty() || word.size()>combined.size())return false;
+    for(size_t i=0;i<word.size();++i)
+    {
+        const char c=word[i]|0x20;
+        if(word.size()==1 ? singles.find(c)==std::string_view::npos :
+                            c!=combined[i])
+            return false;
+    }
+    return true;
+}
+
+/* The G94 state machine.  A single pass over the line both classifies it and
+ * extracts its contents.  The lines we care about are of the form:
+ *
+ * - new_atom:    "<symbol> 0"
+ * - new_shell:   "<angular momentum> <number of primitives> <scale factor>"
+ * - same_shell:  "<exponent> <coefficient> [<coefficient>...]"
+ * - ecp:         "<name> <lmax> <number of core electrons>"
+ * - ecp_channel: "<number of terms>"
+ * - ecp_term:    "<power> <exponent> <coefficient>"
+ *
+ * Everything else (comments, "****" separators, ECP channel titles,...) is
+ * junk.  For new_atom and new_shell lines the first token is returned in word,
+ * for the other lines the numbers are returned in values.
+ */
+g94_line scan_g94(std::string_view line, std::string_view& word,
+                  std::array<double,max_g94_values>& values, size_t& nvalues)
+{
+    size_t pos=0;
+    std::string_view token=next_token(line,pos);
+    if(token.empty())return g94_line::none;
+
+    double number;
+    bool is_int;
+    if(to_double(token,number,is_int))
+    {
+        nvalues=0;
+        values[nvalues++]=number;
+        bool all_int=is_int;
+        while(!(token=next_token(line,pos)).empty())
         {
-            detail_::commit_shell(s,Z,rv);
-            auto data=parser.parse(line);
-            Z=data.at(data_type::Z)[0];
-            detail_::parse(data,s);
-            break;
+            bool token_is_int;
+            if(!to_double(token,number,token_is_int))return g94_line::none;
+            if(nvalues==max_g94_values)
+                throw std::out_of_range("Too many coefficients on G94 line");
+            values[nvalues++]=number;
+            all_int=all_int && token_is_int;
         }
-        case(action_type::new_shell):{
-            detail_::commit_shell(s,Z,rv);
-            //Intentional fall-through
-        }
-        default:{
-            auto data=parser.parse(line);
-            detail_::parse(data,s);
-            break;
-        }
-        }//End switch
-    }//End while
-    detail_::commit_shell(s,Z,rv);
-    return rv;
+        //Exponents always carry a decimal point or an exponent, which tells
+        //the primitives apart from the ECP lines (which start with integers)
+        if(!is_int)return g94_line::same_shell;
+        if(nvalues==1 && number>=0)return g94_line::ecp_channel;
+        if(nvalues==3 && !all_int)return g94_line::ecp_term;
+        return g94_line::none;
+    }
+
+    if(!is_alpha(token[0]))return g94_line::none;
+    word=token;
+    std::array<std::string_view,2> tokens;
+    size_t ntokens=0;
+    for(;ntokens<2 && !(token=next_token(line,pos)).empty();++ntokens)
+        tokens[ntokens]=token;
+    if(!next_token(line,pos).empty())return g94_line::none;
+    if(ntokens==1 && tokens[0]=="0" && word.size()<=3 && is_alpha(word))
+        return g94_line::new_atom;
+    if(ntokens!=2 || !to_double(tokens[0],number,is_int) || !is_int)
+        return g94_line::none;
+    values[0]=number;
+    if(!to_double(tokens[1],number,is_int))return g94_line::none;
+    values[1]=number;
+    nvalues=2;
+    if(!is_am(word) && is_int && values[0]>=0 && values[1]>=0)
+        return g94_line::ecp;
+    return is_alpha(word) ? g94_line::new_shell : g94_line::none;
 }
 
-static const std::regex G94_new_atom("^\\s*\\D{1,2}\\s*0\\s*$");
-static const std::regex G94_new_shell("^\\s*[a-zA-Z]+\\s*\\d+\\s*1.00\\s*$");
-static const std::regex G94_same_shell("^\\s*(?:\\d+.\\d+\\s*)+$");
+}//End namespace detail_
 
 action_type G94::worth_parsing(const std::string& line)const
 {
-    if(std::regex_search(line,G94_new_atom))
+    std::string_view word;
+    std::array<double,detail_::max_g94_values> values;
+    size_t nvalues;
+    switch(detail_::scan_g94(line,word,values,nvalues))
+    {
+    case(detail_::g94_line::new_atom):
         return action_type::new_atom;
-    else if(std::regex_search(line,G94_new_shell))
+    case(detail_::g94_line::new_shell):
         return action_type::new_shell;
-    else if(std::regex_search(line,G94_same_shell))
+    case(detail_::g94_line::same_shell):
         return action_type::same_shell;
-    return action_type::none;
+    default:
+        return action_type::none;
+    }
 }
 
-parsed_type G94::parse(const std::string& line)const
+void G94::parse_line(std::string_view line, BasisSetFileHandler& handler)const
 {
-    parsed_type rv;
-    std::stringstream tokenizer(line);
-    if(std::regex_search(line,G94_new_atom))
+    std::string_view word;
+    std::array<double,detail_::max_g94_values> values;
+    size_t nvalues=0;
+    switch(detail_::scan_g94(line,word,values,nvalues))
     {
-        std::string symbol;
-        tokenizer>>symbol;
-        rv[data_type::Z].push_back(detail_::sym2Z_.at(symbol));
+    case(detail_::g94_line::new_atom):
+    {
+        handler.on_atom(detail_::symbol_to_Z(word));
+        break;
     }
-    else if(std::regex_search(line,G94_new_shell))
+    case(detail_::g94_line::new_shell):
     {
-        std::string am;
-        tokenizer>>am;
-        std::transform(am.begin(), am.end(), am.begin(), ::tolower);
-        rv[data_type::angular_momentum].push_back(am_str2int(am));
+        //Longest name is "spdfgh" so this stays in the small string buffer
+        std::string am(word);
+        for(char& c: am)c=std::tolower(c);
+        handler.on_shell(am_str2int(am));
+        break;
     }
-    else if(std::regex_search(line,G94_same_shell))
+    case(detail_::g94_line::same_shell):
     {
-        double a,c;
-        tokenizer>>a;
-        rv[data_type::exponent].push_back(a);
-        while(tokenizer>>c)
-        {
-            rv[data_type::coefficient].push_back(c);
-        }
+        handler.on_primitive(values[0],values.data()+1,nvalues-1);
+        break;
     }
-    return rv;
+    case(detail_::g94_line::ecp):
+    {
+        handler.on_ecp(values[0],values[1]);
+        break;
+    }
+    case(detail_::g94_line::ecp_channel):
+    {
+        handler.on_ecp_channel(values[0]);
+        break;
+    }
+    case(detail_::g94_line::ecp_term):
+    {
+        handler.on_ecp_term(values[0],values[1],values[2]);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+size_t G94::new_atom(std::string_view line)const
+{
+    //Only lines starting with a letter can be atom headers, which lets us skip
+    //the primitives (the bulk of the file) after looking at one character
+    size_t i=0;
+    while(i<line.size() && detail_::is_space(line[i]))++i;
+    if(i==line.size() || !detail_::is_alpha(line[i]))return 0;
+    std::string_view word;
+    std::array<double,detail_::max_g94_values> values;
+    size_t nvalues;
+    if(detail_::scan_g94(line,word,values,nvalues)!=
+       detail_::g94_line::new_atom)
+        return 0;
+    return detail_::symbol_to_Z(word);
 }
 
 }//End namespace
@@ -3,7 +3,10 @@
 #include <map>
 #include <vector>
 #include <istream>
+#include <string_view>
 #include "LibChemist/BasisShell.hpp"
+#include "LibChemist/ECP.hpp"
+#include "LibChemist/ReadMode.hpp"
 
 /** \file This file contains the machinery for parsing a basis set file.
  *
@@ -35,11 +38,75 @@
  *
  * For every parsable line you return an std::map<data_type,double> of the
  * data you obtained from the line.
+ *
+ * Building an std::map for every line is expensive so parsers instead
+ * implement the callback interface.  There, parse_line is given the line once
+ * and reports what it finds to a BasisSetFileHandler: on_atom when a new atom
+ * starts, on_shell when a new shell starts, and on_primitive for each
+ * primitive of the current shell.  Lines with nothing of interest simply fire
+ * no callbacks.  parse_line is the one function a parser has to implement;
+ * worth_parsing and parse are available on every parser, implemented in terms
+ * of it.  Parsers written against the map-based interface derive from
+ * MapBasisSetFileParser, which implements parse_line in terms of them.
+ *
+ * Effective core potentials are reported through their own callbacks, which
+ * do nothing by default.  They are only available through parse_line; the
+ * map-based interface treats ECP lines as not worth parsing.
  */
 
 
 namespace LibChemist {
 
+/** \brief The callbacks a BasisSetFileParser fires while parsing a line.
+ *
+ *  The data passed to the callbacks is only valid for the duration of the
+ *  call.
+ */
+struct BasisSetFileHandler
+{
+    virtual ~BasisSetFileHandler()=default;
+
+    ///A new atom with atomic number \p Z starts
+    virtual void on_atom(size_t Z)=0;
+
+    ///A new shell with angular momentum \p l (as from am_str2int) starts
+    virtual void on_shell(int l)=0;
+
+    /** \brief A primitive belonging to the current shell.
+     *
+     *  \param[in] alpha The exponent of the primitive.
+     *  \param[in] coefs The primitive's coefficient in each general contraction
+     *                   of the shell.
+     *  \param[in] ncoefs The number of elements in \p coefs.
+     */
+    virtual void on_primitive(double alpha, const double* coefs,
+                              size_t ncoefs)=0;
+
+    /** \brief An effective core potential for the current atom starts.
+     *
+     *  \param[in] lmax The angular momentum of the local channel.
+     *  \param[in] ncore The number of core electrons the ECP replaces.
+     */
+    virtual void on_ecp(int /*lmax*/, size_t /*ncore*/){}
+
+    /** \brief A new channel of the current ECP starts.
+     *
+     *  Channels come in the order of the file, for G94 that is the local
+     *  channel first and then the projected channels from l=0 up.
+     *
+     *  \param[in] nterms The number of terms the channel has.
+     */
+    virtual void on_ecp_channel(size_t /*nterms*/){}
+
+    /** \brief A term \f$c r^{n-2} e^{-\alpha r^2}\f$ of the current channel.
+     *
+     *  \param[in] n The power of r, plus 2.
+     *  \param[in] alpha The exponent of the term.
+     *  \param[in] coef The coefficient of the term.
+     */
+    virtual void on_ecp_term(int /*n*/, double /*alpha*/, double /*coef*/){}
+};
+
 /** \brief This class abstracts away the layout of the basis set file
  *
  *  This is the base class for all classes specifying the layout of a
@@ -50,19 +117,84 @@ struct BasisSetFileParser
     enum class action_type{none,new_atom,new_shell,same_shell};
     enum class data_type{exponent,coefficient,angular_momentum,Z};
 
-    virtual action_type worth_parsing(const std::string& line)const=0;
+    virtual ~BasisSetFileParser()=default;
+
+    /** \brief Classifies a line of the file.
+     *
+     *  The default implementation runs parse_line and inspects the first
+     *  callback it fires.
+     */
+    virtual action_type worth_parsing(const std::string& line)const;
+
+    /** \brief Returns the data contained in a line of the file.
+     *
+     *  The default implementation collects the callbacks fired by parse_line.
+     */
     virtual std::map<data_type,std::vector<double>>
-    parse(const std::string& line)const=0;
+    parse(const std::string& line)const;
+
+    /** \brief Parses a line of the file, reporting its contents to \p handler.
+     *
+     *  \param[in] line The line to parse, without the trailing newline.
+     *  \param[in] handler The object receiving the line's contents.
+     */
+    virtual void parse_line(std::string_view line,
+                            BasisSetFileHandler& handler)const=0;
+
+    /** \brief Returns the atomic number if \p line starts a new atom, and 0
+     *         otherwise.
+     *
+     *  This is used to find the atoms in a file without parsing all of it, so
+     *  parsers should override it with something cheaper than a full parse of
+     *  the line if they can.  The default implementation runs parse_line.
+     *
+     *  \param[in] line The line to inspect, without the trailing newline.
+     */
+    virtual size_t new_atom(std::string_view line)const;
+};
+
+/** \brief The base class of parsers written against the map-based interface.
+ *
+ *  Such parsers implement worth_parsing and parse, and this class implements
+ *  parse_line by calling them and translating their results into callbacks.
+ *  That copies every line into an std::string and builds an std::map for
+ *  every line worth parsing, so new parsers should implement parse_line
+ *  directly instead.
+ */
+struct MapBasisSetFileParser: public BasisSetFileParser
+{
+    action_type worth_parsing(const std::string& line)const override=0;
+    std::map<data_type,std::vector<double>>
+    parse(const std::string& line)const override=0;
+    void parse_line(std::string_view line,
+                    BasisSetFileHandler& handler)const override;
 };
 
 /** \brief This class implements a BasisSetFileParser for the Gaussian94 format.
  *
+ *  ECP blocks, which follow the basis set in a G94 file, look like:
+ *
+ *  \verbatim
+    PT     0
+    PT-ECP     3     60
+    f potential
+      1
+    2      1.0000000              0.0000000
+    s-f potential
+    ...
+    \endverbatim
+ *
+ *  i.e. the atom, a name that is not an angular momentum followed by
+ *  \f$l_{max}\f$ and the number of core electrons, and then \f$l_{max}+1\f$
+ *  channels.  Each channel is a title line, its number of terms and the terms
+ *  as "<power> <exponent> <coefficient>".
  */
 struct G94: public BasisSetFileParser
 {
     action_type worth_parsing(const std::string& line)const override;
-    std::map<data_type, std::vector<double> >
-    parse(const std::string& line)const override;
+    void parse_line(std::string_view line,
+                    BasisSetFileHandler& handler)const override;
+    size_t new_atom(std::string_view line)const override;
 };
 
 /** \brief The function to call to parse a BasisSetFile.
@@ -72,4 +204,97 @@ struct G94: public BasisSetFileParser
 std::map<size_t,std::vector<BasisShell>>
 parse_basis_set_file(std::istream& is, const BasisSetFileParser& parser);
 
+/** \brief Parses a basis set file that has already been read into memory.
+ *
+ *  \param[in] buffer The contents of the basis set file.
+ *  \param[in] parser The parser to be used to parse \p buffer.
+ *  \returns A map from atomic number to the shells for that atom.
+ */
+std::map<size_t,std::vector<BasisShell>>
+parse_basis_set_buffer(std::string_view buffer,
+                       const BasisSetFileParser& parser);
+
+/** \brief Parses the basis set file at a given path.
+ *
+ *  By default the file is memory mapped and the parser is handed views of the
+ *  lines in the mapping, i.e. the lines are never copied.  This is the
+ *  preferred way to parse a basis set file that lives on disk.  On slow
+ *  filesystems ReadMode::pipelined overlaps reading the file with parsing it.
+ *
+ *  gzip-compressed files are detected by their magic bytes and decompressed on
+ *  the fly, in bounded-size chunks, on a separate thread from the parsing.
+ *
+ *  \param[in] path The path to the basis set file.
+ *  \param[in] parser The parser to be used to parse the file.
+ *  \param[in] mode Whether to map the file or read it on a separate thread.
+ *  \returns A map from atomic number to the shells for that atom.
+ *  \throws std::runtime_error if the file can not be opened, mapped, or read,
+ *          or is gzip-compressed and can not be decompressed (including when
+ *          the library was built without ENABLE_ZLIB).
+ */
+std::map<size_t,std::vector<BasisShell>>
+parse_basis_set_file(const std::string& path, const BasisSetFileParser& parser,
+                     ReadMode mode=ReadMode::mapped);
+
+/** \brief Parses the basis set file at a given path using multiple threads.
+ *
+ *  The memory-mapped file is cut into chunks at lines for which \p parser
+ *  signals a new atom.  The chunks are parsed concurrently and the results are
+ *  merged in file order, so the result is the same as for the serial overload.
+ *  This pays off for large libraries; small files are parsed by a single
+ *  thread.  gzip-compressed files can not be split and are handled as by the
+ *  serial overload.
+ *
+ *  \param[in] path The path to the basis set file.
+ *  \param[in] parser The parser to be used to parse the file.  It will be
+ *                    called concurrently from several threads.
+ *  \param[in] nthreads The number of threads to use, 0 means one per hardware
+ *                      thread.
+ *  \returns A map from atomic number to the shells for that atom.
+ *  \throws std::runtime_error if the file can not be opened or mapped.
+ */
+std::map<size_t,std::vector<BasisShell>>
+parse_basis_set_file(const std::string& path, const BasisSetFileParser& parser,
+                     size_t nthreads);
+
+/** \brief Parses the effective core potentials out of a basis set file.
+ *
+ *  \param[in] is The stream to read the file from.
+ *  \param[in] parser The parser to be used to parse the file.
+ *  \returns A map from atomic number to the ECP for that atom.  Atoms without
+ *           an ECP do not appear.
+ *  \throws std::runtime_error if an ECP does not have the number of channels
+ *          or terms it declares.
+ */
+std::map<size_t,ECP>
+parse_ecp_file(std::istream& is, const BasisSetFileParser& parser);
+
+/** \brief Parses the effective core potentials out of a basis set file that
+ *         has already been read into memory.
+ *
+ *  \param[in] buffer The contents of the basis set file.
+ *  \param[in] parser The parser to be used to parse \p buffer.
+ *  \returns A map from atomic number to the ECP for that atom.
+ *  \throws std::runtime_error if an ECP does not have the number of channels
+ *          or terms it declares.
+ */
+std::map<size_t,ECP>
+parse_ecp_buffer(std::string_view buffer, const BasisSetFileParser& parser);
+
+/** \brief Parses the effective core potentials out of the basis set file at a
+ *         given path.
+ *
+ *  The file is read as by parse_basis_set_file.
+ *
+ *  \param[in] path The path to the basis set file.
+ *  \param[in] parser The parser to be used to parse the file.
+ *  \param[in] mode Whether to map the file or read it on a separate thread.
+ *  \returns A map from atomic number to the ECP for that atom.
+ *  \throws std::runtime_error if the file can not be read or an ECP does not
+ *          have the number of channels or terms it declares.
+ */
+std::map<size_t,ECP>
+parse_ecp_file(const std::string& path, const BasisSetFileParser& parser,
+               ReadMode mode=ReadMode::mapped);
+
 }//End namespace LibChemist
@@ -0,0 +1,84 @@
+#include "LibChemist/BasisSetWriter.hpp"
+#include "LibChemist/ShellTypes.hpp"
+#include "LibChemist/detail_/TextWriting.hpp"
+#include "LibChemist/lut/AtomicInfo.hpp"
+#include <cctype>
+#include <stdexcept>
+
+namespace LibChemist {
+namespace detail_ {
+
+//Appends the lines of one shell
+void append_g94_shell(const BasisShell& shell, std::string& buffer)
+{
+    //G94 infers the number of contractions from the angular momentum
+    const size_t ngen=(shell.l<0 ? 1-shell.l : 1);
+    if(shell.ngen!=ngen)
+        throw std::runtime_error("G94 can not represent a shell with "+
+                                 std::to_string(shell.ngen)+
+                                 " contractions and angular momentum "+
+                                 am_int2str(shell.l));
+    //G94 reads at most an exponent and six coefficients per line
+    if(ngen>6)
+        throw std::runtime_error("G94 can not represent a "+
+                                 am_int2str(shell.l)+" shell");
+    std::string am=am_int2str(shell.l);
+    for(char& c: am)c=std::toupper(c);
+    buffer.append(am);
+    buffer.push_back(' ');
+    append_integer(shell.nprim,buffer);
+    buffer.append(" 1.00\n");
+    for(size_t i=0;i<shell.nprim;++i)
+    {
+        //G94 tells exponents from integers by the decimal point
+        append_double(shell.alpha(i),buffer,true);
+        for(size_t j=0;j<shell.ngen;++j)
+        {
+            buffer.push_back(' ');
+            append_double(shell.coef(i,j),buffer,true);
+        }
+        buffer.push_back('\n');
+    }
+}
+
+//Appends the block of one element, including the closing separator
+void append_g94_element(size_t Z, const std::vector<BasisShell>& shells,
+                        std::string& buffer)
+{
+    buffer.append(Z2sym_.at(Z));
+    buffer.append(" 0\n");
+    for(const BasisShell& shell: shells)
+        append_g94_shell(shell,buffer);
+    buffer.append("****\n");
+}
+
+}//End namespace detail_
+
+void append_g94(const std::map<size_t,std::vector<BasisShell>>& basis,
+                std::string& buffer)
+{
+    buffer.append("****\n");
+    for(const auto& [Z,shells]: basis)
+        detail_::append_g94_element(Z,shells,buffer);
+}
+
+void write_g94_file(const std::string& path,
+                    const std::map<size_t,std::vector<BasisShell>>& basis)
+{
+    constexpr size_t buffer_size=1<<20;
+    std::string buffer;
+    detail_::FileWriter file(path);
+    buffer.append("****\n");
+    for(const auto& [Z,shells]: basis)
+    {
+        detail_::append_g94_element(Z,shells,buffer);
+        if(buffer.size()>=buffer_size)
+        {
+            file.write(buffer);
+            buffer.clear();
+        }
+    }
+    file.write(buffer);
+}
+
+}//End namespace
@@ -0,0 +1,54 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "LibChemist/BasisShell.hpp"
+
+/** \file This file contains the machinery for writing basis sets to files in
+ *  the Gaussian94 format read by G94.
+ *
+ * Each element gets a block of the form:
+ *
+ * \verbatim
+   <symbol>     0
+   <angular momentum> <number of primitives> 1.00
+   <exponent> <coefficient> [<coefficient>...]
+   ...
+   ****
+   \endverbatim
+ *
+ * Numbers are written in the shortest form that reads back to the same
+ * double, so parsing a written file with G94 gives back exactly the shells
+ * that were written.  The format has no notion of the shell type, which G94
+ * reads back as SphericalGaussian.
+ */
+
+namespace LibChemist {
+
+/** \brief Appends the shells of \p basis to \p buffer in the G94 format.
+ *
+ *  \param[in] basis A map from atomic number to the shells of that element,
+ *                   as returned by parse_basis_set_file.
+ *  \param[in,out] buffer The string to append to.
+ *  \throws std::out_of_range if an atomic number has no symbol or a shell's
+ *          angular momentum has no name.
+ *  \throws std::runtime_error if a shell can not be represented in the G94
+ *          format, i.e. it is a general contraction of a single angular
+ *          momentum, or a fused shell with more than six contractions.
+ *          Only the fused shells (sp, spd,...) can carry several
+ *          contractions.
+ */
+void append_g94(const std::map<size_t,std::vector<BasisShell>>& basis,
+                std::string& buffer);
+
+/** \brief Writes \p basis to the G94 file at \p path, overwriting it.
+ *
+ *  The file is formatted in memory and written with one call per megabyte.
+ *
+ *  \throws std::runtime_error if the file can not be written, plus anything
+ *          append_g94 throws.
+ */
+void write_g94_file(const std::string& path,
+                    const std::map<size_t,std::vector<BasisShell>>& basis);
+
+}//End namespace
@@ -0,0 +1,389 @@
+#include "LibChemist/BiomoleculeParser.hpp"
+#include "LibChemist/detail_/AtomPrototypes.hpp"
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <array>
+#include <stdexcept>
+#include <tuple>
+
+namespace LibChemist {
+namespace detail_ {
+
+//Below this many bytes per thread it's not worth parsing in parallel
+constexpr size_t min_biomolecule_chunk=1<<16;
+
+//The parts of an atom record we keep
+struct AtomRecord {
+    std::string_view element;
+    std::string_view name;
+    std::string_view res_name;
+    std::string_view chain;
+    std::string_view ins_code;
+    long res_seq=0;
+    std::array<double,3> xyz;
+};
+
+//Assembles the atoms of (part of) a file into a Biomolecule
+class BiomoleculeBuilder {
+public:
+    Biomolecule rv;
+
+    void add(const AtomRecord& r)
+    {
+        std::array<double,3> xyz;
+        for(size_t i=0;i<3;++i)
+            xyz[i]=r.xyz[i]*angstrom2bohr;
+        rv.atoms.push_back(prototypes_.make(xyz,symbol_to_Z(r.element)));
+        rv.atom_names.emplace_back(r.name);
+
+        bool new_residue=false;
+        if(!rv.nchains() || rv.chain_ids.back()!=r.chain)
+        {
+            rv.chain_ids.emplace_back(r.chain);
+            new_residue=true;
+        }
+        if(new_residue || rv.residue_names.back()!=r.res_name ||
+           rv.residue_numbers.back()!=r.res_seq || ins_codes_.back()!=r.ins_code)
+        {
+            rv.residue_names.emplace_back(r.res_name);
+            rv.residue_numbers.push_back(r.res_seq);
+            rv.residue_chain.push_back(rv.nchains()-1);
+            ins_codes_.emplace_back(r.ins_code);
+        }
+        rv.atom_residue.push_back(rv.nresidues()-1);
+    }
+
+    //Appends the atoms of other, which came right after ours in the file
+    void append(BiomoleculeBuilder& other)
+    {
+        Biomolecule& orv=other.rv;
+        if(!orv.atoms.size())return;
+        const bool same_chain=rv.nchains() &&
+                              rv.chain_ids.back()==orv.chain_ids.front();
+        const bool same_residue=same_chain &&
+            rv.residue_names.back()==orv.residue_names.front() &&
+            rv.residue_numbers.back()==orv.residue_numbers.front() &&
+            ins_codes_.back()==other.ins_codes_.front();
+        const size_t chain_offset=rv.nchains()-same_chain;
+        const size_t residue_offset=rv.nresidues()-same_residue;
+
+        for(size_t i=same_chain;i<orv.nchains();++i)
+            rv.chain_ids.push_back(std::move(orv.chain_ids[i]));
+        for(size_t i=same_residue;i<orv.nresidues();++i)
+        {
+            rv.residue_names.push_back(std::move(orv.residue_names[i]));
+            rv.residue_numbers.push_back(orv.residue_numbers[i]);
+            rv.residue_chain.push_back(orv.residue_chain[i]+chain_offset);
+            ins_codes_.push_back(std::move(other.ins_codes_[i]));
+        }
+        for(size_t i=0;i<orv.atoms.size();++i)
+        {
+            rv.atoms.push_back(std::move(orv.atoms[i]));
+            rv.atom_names.push_back(std::move(orv.atom_names[i]));
+            rv.atom_residue.push_back(orv.atom_residue[i]+residue_offset);
+        }
+    }
+
+    void reserve(size_t natoms)
+    {
+        rv.atoms.reserve(natoms);
+        rv.atom_names.reserve(natoms);
+        rv.atom_residue.reserve(natoms);
+    }
+
+private:
+    AtomPrototypes prototypes_;
+
+    ///The insertion code of each residue
+    std::vector<std::string> ins_codes_;
+};
+
+/* Splits buffer into chunks of whole lines, calls record(line,r) for every
+ * line of every chunk in parallel, and assembles the lines for which it
+ * returns true into a Biomolecule.
+ */
+template<typename record_fxn>
+Biomolecule parse_records(std::string_view buffer, size_t nthreads,
+                          record_fxn&& record)
+{
+    nthreads=std::max<size_t>(
+                 std::min(resolve_nthreads(nthreads),
+                          buffer.size()/min_biomolecule_chunk),1);
+    //Extra chunks so a thread that gets sparse chunks can pick up more work
+    const size_t nchunks=(nthreads>1 ? 4*nthreads : 1);
+    std::vector<size_t> bounds(1,0);
+    for(size_t i=1;i<nchunks;++i)
+    {
+        const size_t nl=buffer.find('\n',std::max(i*buffer.size()/nchunks,
+                                                  bounds.back()));
+        if(nl==std::string_view::npos)break;
+        if(nl+1>bounds.back())bounds.push_back(nl+1);
+    }
+    bounds.push_back(buffer.size());
+
+    std::vector<BiomoleculeBuilder> chunks(bounds.size()-1);
+    parallel_for(chunks.size(),nthreads,[&](size_t i, size_t){
+        AtomRecord r;
+        for_each_line(buffer.substr(bounds[i],bounds[i+1]-bounds[i]),
+                      [&](std::string_view line){
+            if(record(line,r))chunks[i].add(r);
+        });
+    });
+
+    if(chunks.size()==1)return std::move(chunks[0].rv);
+    size_t natoms=0;
+    for(const auto& chunk: chunks)natoms+=chunk.rv.atoms.size();
+    BiomoleculeBuilder rv;
+    rv.reserve(natoms);
+    for(auto& chunk: chunks)rv.append(chunk);
+    return std::move(rv.rv);
+}
+
+//Converts a coordinate, throwing if it is malformed
+double to_coordinate(std::string_view token, std::string_view line)
+{
+    double value;
+    if(!to_double(token,value))
+        throw std::runtime_error("Malformed coordinate in atom record: "+
+                                 std::string(line));
+    return value;
+}
+
+//Converts a residue number, missing numbers are 0
+long to_residue_number(std::string_view token, std::string_view line)
+{
+    double value=0.0;
+    bool is_int;
+    if(!token.empty() && (!to_double(token,value,is_int) || !is_int))
+        throw std::runtime_error("Malformed residue number in atom record: "+
+                                 std::string(line));
+    return static_cast<long>(value);
+}
+
+//Reads an ATOM or HETATM record, see the PDB format specification
+bool pdb_record(std::string_view line, AtomRecord& r)
+{
+    if(line.size()<54 || (line.compare(0,6,"ATOM  ") &&
+                          line.compare(0,6,"HETATM")))
+        return false;
+    const char alt_loc=line[16];
+    if(alt_loc!=' ' && alt_loc!='A')return false;
+    r.name=column(line,12,16);
+    r.res_name=column(line,17,20);
+    r.chain=column(line,21,22);
+    r.res_seq=to_residue_number(column(line,22,26),line);
+    r.ins_code=column(line,26,27);
+    for(size_t i=0;i<3;++i)
+        r.xyz[i]=to_coordinate(column(line,30+8*i,38+8*i),line);
+    r.element=column(line,76,78);
+    if(r.element.empty())
+    {
+        //The element is right justified in the first two columns of the name
+        std::string_view sym=line.substr(12,2);
+        while(!sym.empty() && !is_alpha(sym[0]))sym.remove_prefix(1);
+        while(!sym.empty() && !is_alpha(sym.back()))sym.remove_suffix(1);
+        r.element=sym;
+    }
+    return true;
+}
+
+//Splits a row of a CIF loop into tokens, handling quoted values
+void cif_tokens(std::string_view line, std::vector<std::string_view>& tokens)
+{
+    tokens.clear();
+    const size_t n=line.size();
+    size_t pos=0;
+    while(true)
+    {
+        while(pos<n && is_space(line[pos]))++pos;
+        if(pos==n)break;
+        const char quote=line[pos];
+        if(quote=='\'' || quote=='"')
+        {
+            //A quote only closes the value if followed by whitespace
+            size_t end=pos+1;
+            while(end<n && !(line[end]==quote &&
+                             (end+1==n || is_space(line[end+1]))))
+                ++end;
+            tokens.push_back(line.substr(pos+1,end-pos-1));
+            pos=end+1;
+        }
+        else
+        {
+            const size_t begin=pos;
+            while(pos<n && !is_space(line[pos]))++pos;
+            tokens.push_back(line.substr(begin,pos-begin));
+        }
+    }
+}
+
+//The columns of the atom_site loop we use, npos if not present
+struct AtomSiteColumns {
+    static constexpr size_t npos=std::string_view::npos;
+    size_t ncolumns=0;
+    size_t element=npos, name=npos, alt_loc=npos, res_name=npos, chain=npos,
+           res_seq=npos, ins_code=npos, model=npos;
+    std::array<size_t,3> xyz{npos,npos,npos};
+};
+
+//Returns the token in column i, with CIF's "." and "?" (no value) as empty
+std::string_view cif_value(const std::vector<std::string_view>& tokens,
+                           size_t i)
+{
+    if(i==AtomSiteColumns::npos)return std::string_view();
+    const std::string_view token=tokens[i];
+    return (token=="." || token=="?") ? std::string_view() : token;
+}
+
+/* Finds the atom_site loop.  Returns the loop's columns and sets data to the
+ * lines holding its rows.
+ */
+AtomSiteColumns find_atom_site(std::string_view buffer, std::string_view& data)
+{
+    const std::string_view prefix("_atom_site.");
+    size_t offset=(buffer.compare(0,prefix.size(),prefix)==0 ? 0 :
+                   buffer.find("\n_atom_site."));
+    if(offset==std::string_view::npos)
+        throw std::runtime_error("mmCIF file has no atom_site loop");
+    if(offset)++offset;
+
+    //Header lines, one per column
+    AtomSiteColumns cols;
+    auto set=[&](std::string_view field, std::string_view name, size_t& col){
+        if(field==name)col=cols.ncolumns;
+    };
+    //Used when the preferred column is absent
+    size_t label_chain=cols.npos, label_seq=cols.npos, auth_name=cols.npos;
+    while(offset<buffer.size() &&
+          buffer.compare(offset,prefix.size(),prefix)==0)
+    {
+        size_t eol=buffer.find('\n',offset);
+        if(eol==std::string_view::npos)eol=buffer.size();
+        size_t pos=0;
+        const std::string_view line=buffer.substr(offset,eol-offset);
+        const std::string_view field=next_token(line,pos).substr(prefix.size());
+        set(field,"type_symbol",cols.element);
+        set(field,"label_atom_id",cols.name);
+        set(field,"auth_atom_id",auth_name);
+        set(field,"label_alt_id",cols.alt_loc);
+        set(field,"label_comp_id",cols.res_name);
+        set(field,"auth_asym_id",cols.chain);
+        set(field,"label_asym_id",label_chain);
+        set(field,"auth_seq_id",cols.res_seq);
+        set(field,"label_seq_id",label_seq);
+        set(field,"pdbx_PDB_ins_code",cols.ins_code);
+        set(field,"pdbx_PDB_model_num",cols.model);
+        set(field,"Cartn_x",cols.xyz[0]);
+        set(field,"Cartn_y",cols.xyz[1]);
+        set(field,"Cartn_z",cols.xyz[2]);
+        ++cols.ncolumns;
+        offset=eol+1;
+    }
+    if(cols.name==cols.npos)cols.name=auth_name;
+    if(cols.chain==cols.npos)cols.chain=label_chain;
+    if(cols.res_seq==cols.npos)cols.res_seq=label_seq;
+    if(cols.element==cols.npos || cols.xyz[0]==cols.npos ||
+       cols.xyz[1]==cols.npos || cols.xyz[2]==cols.npos)
+        throw std::runtime_error("mmCIF atom_site loop lacks the element "
+                                 "symbols or coordinates");
+
+    //The rows run until the next comment, loop, data item, or data block
+    size_t end=buffer.size();
+    if(offset<buffer.size())
+        for(const char* stop: {"\n#","\nloop_","\n_","\ndata_"})
+        {
+            const size_t pos=buffer.find(stop,offset-1);
+            if(pos!=std::string_view::npos)end=std::min(end,pos+1);
+        }
+    offset=std::min(offset,buffer.size());
+    data=buffer.substr(offset,std::max(end,offset)-offset);
+    return cols;
+}
+
+}//End namespace detail_
+
+bool Biomolecule::operator==(const Biomolecule& rhs)const noexcept
+{
+    return std::tie(atoms,atom_names,atom_residue,residue_names,
+                    residue_numbers,residue_chain,chain_ids)==
+           std::tie(rhs.atoms,rhs.atom_names,rhs.atom_residue,
+                    rhs.residue_names,rhs.residue_numbers,rhs.residue_chain,
+                    rhs.chain_ids);
+}
+
+Biomolecule parse_pdb_buffer(std::string_view buffer, size_t nthreads)
+{
+    //Only the first model
+    const size_t end=buffer.find("\nENDMDL");
+    if(end!=std::string_view::npos)buffer=buffer.substr(0,end+1);
+    return detail_::parse_records(buffer,nthreads,detail_::pdb_record);
+}
+
+Biomolecule parse_mmcif_buffer(std::string_view buffer, size_t nthreads)
+{
+    using detail_::cif_value;
+    std::string_view data;
+    const detail_::AtomSiteColumns cols=detail_::find_atom_site(buffer,data);
+
+    //The model number of the first row is the model we read
+    std::vector<std::string_view> tokens;
+    std::string model;
+    for(size_t pos=0;pos<data.size();)
+    {
+        const size_t nl=std::min(data.find('\n',pos),data.size());
+        detail_::cif_tokens(data.substr(pos,nl-pos),tokens);
+        pos=nl+1;
+        if(tokens.empty())continue;
+        if(tokens.size()==cols.ncolumns)model=cif_value(tokens,cols.model);
+        break;
+    }
+    if(model.empty())model=".";
+
+    return detail_::parse_records(data,nthreads,
+                                  [&](std::string_view line,
+                                      detail_::AtomRecord& r){
+        //Each thread has its own token buffer
+        thread_local std::vector<std::string_view> row;
+        detail_::cif_tokens(line,row);
+        if(row.empty())return false;
+        if(row.size()!=cols.ncolumns)
+            throw std::runtime_error("Expected "+
+                                     std::to_string(cols.ncolumns)+
+                                     " values in atom_site row, got: "+
+                                     std::string(line));
+        const std::string_view row_model=cif_value(row,cols.model);
+        if(!row_model.empty() && row_model!=model)return false;
+        const std::string_view alt_loc=cif_value(row,cols.alt_loc);
+        if(!alt_loc.empty() && alt_loc!="A")return false;
+        r.element=cif_value(row,cols.element);
+        r.name=cif_value(row,cols.name);
+        r.res_name=cif_value(row,cols.res_name);
+        r.chain=cif_value(row,cols.chain);
+        r.res_seq=detail_::to_residue_number(cif_value(row,cols.res_seq),line);
+        r.ins_code=cif_value(row,cols.ins_code);
+        for(size_t i=0;i<3;++i)
+            r.xyz[i]=detail_::to_coordinate(row[cols.xyz[i]],line);
+        return true;
+    });
+}
+
+Biomolecule parse_pdb_file(const std::string& path, size_t nthreads)
+{
+    const detail_::MappedFile file(path);
+    std::string buffer;
+    return parse_pdb_buffer(detail_::decompressed_contents(file.data(),buffer),
+                            nthreads);
+}
+
+Biomolecule parse_mmcif_file(const std::string& path, size_t nthreads)
+{
+    const detail_::MappedFile file(path);
+    std::string buffer;
+    return parse_mmcif_buffer(detail_::decompressed_contents(file.data(),
+                                                             buffer),
+                              nthreads);
+}
+
+}//End namespace
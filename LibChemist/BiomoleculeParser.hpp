@@ -0,0 +1,127 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LibChemist/SetOfAtoms.hpp"
+
+/** \file This file contains readers for the PDB and mmCIF formats.
+ *
+ * Unlike the line-by-line parsers in SetOfAtomsParser.hpp, these readers know
+ * the layout of their formats.  Both formats store one atom per line, so the
+ * atom records are split into chunks which are parsed in parallel and then
+ * stitched together in file order.
+ *
+ * Only the coordinates of the first model are read.  When atoms have
+ * alternate locations, only those without an alternate location indicator or
+ * with indicator "A" are kept.  Coordinates are converted from Angstroms to
+ * Bohr.  Element symbols are taken from the element column when it is present
+ * and from the atom name otherwise.
+ *
+ * For mmCIF files only the atom_site loop is read, the author-provided
+ * residue numbers and chain identifiers are preferred over the label ones
+ * when both are present, and each row of the loop must be on a single line
+ * (which is the case for files written by the PDB).
+ */
+
+namespace LibChemist {
+
+/** \brief The atoms of a biomolecular system and how they group into residues
+ *         and chains.
+ *
+ *  The residue and chain information lives in side arrays, rather than in each
+ *  Atom.  Atom i belongs to residue atom_residue[i], which in turn belongs to
+ *  chain residue_chain[atom_residue[i]].  A new residue starts whenever the
+ *  chain, residue name, residue number or insertion code changes from one
+ *  atom to the next, and a new chain starts whenever the chain identifier
+ *  changes.
+ */
+struct Biomolecule {
+    ///The atoms, in file order
+    SetOfAtoms atoms;
+
+    ///The name of each atom within its residue, e.g. "CA"
+    std::vector<std::string> atom_names;
+
+    ///The index of the residue each atom belongs to
+    std::vector<size_t> atom_residue;
+
+    ///The name of each residue, e.g. "ALA"
+    std::vector<std::string> residue_names;
+
+    ///The sequence number of each residue, as given in the file
+    std::vector<long> residue_numbers;
+
+    ///The index of the chain each residue belongs to
+    std::vector<size_t> residue_chain;
+
+    ///The identifier of each chain, e.g. "A"
+    std::vector<std::string> chain_ids;
+
+    ///Returns the number of residues
+    size_t nresidues()const noexcept
+    {
+        return residue_names.size();
+    }
+
+    ///Returns the number of chains
+    size_t nchains()const noexcept
+    {
+        return chain_ids.size();
+    }
+
+    ///Returns true if every member of this instance equals that of \p rhs
+    bool operator==(const Biomolecule& rhs)const noexcept;
+
+    ///Returns true if any member of this instance differs from that of \p rhs
+    bool operator!=(const Biomolecule& rhs)const noexcept
+    {
+        return !((*this)==rhs);
+    }
+};
+
+/** \brief Parses the contents of a PDB file.
+ *
+ *  Only ATOM and HETATM records are read.
+ *
+ *  \param[in] buffer The contents of the file.
+ *  \param[in] nthreads The number of threads to use, 0 means one per hardware
+ *                      thread.  Small inputs are parsed by a single thread.
+ *  \returns The atoms in the file along with their residues and chains.
+ *  \throws std::runtime_error if a coordinate is malformed.
+ *  \throws std::out_of_range if an element symbol is not recognized.
+ */
+Biomolecule parse_pdb_buffer(std::string_view buffer, size_t nthreads=0);
+
+/** \brief Parses the contents of an mmCIF file.
+ *
+ *  \param[in] buffer The contents of the file.
+ *  \param[in] nthreads The number of threads to use, 0 means one per hardware
+ *                      thread.  Small inputs are parsed by a single thread.
+ *  \returns The atoms in the file along with their residues and chains.
+ *  \throws std::runtime_error if there is no atom_site loop, it lacks the
+ *          coordinates or element symbols, or a row is malformed.
+ *  \throws std::out_of_range if an element symbol is not recognized.
+ */
+Biomolecule parse_mmcif_buffer(std::string_view buffer, size_t nthreads=0);
+
+/** \brief Parses the PDB file at \p path.
+ *
+ *  The file is memory mapped, or decompressed into memory if it is
+ *  gzip-compressed, and then parsed by parse_pdb_buffer.
+ *
+ *  \throws std::runtime_error if the file can not be read, plus anything
+ *          parse_pdb_buffer throws.
+ */
+Biomolecule parse_pdb_file(const std::string& path, size_t nthreads=0);
+
+/** \brief Parses the mmCIF file at \p path.
+ *
+ *  The file is memory mapped, or decompressed into memory if it is
+ *  gzip-compressed, and then parsed by parse_mmcif_buffer.
+ *
+ *  \throws std::runtime_error if the file can not be read, plus anything
+ *          parse_mmcif_buffer throws.
+ */
+Biomolecule parse_mmcif_file(const std::string& path, size_t nthreads=0);
+
+}//End namespace
@@ -0,0 +1,514 @@
+#include "LibChemist/CrystalParser.hpp"
+#include "LibChemist/detail_/AtomPrototypes.hpp"
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace LibChemist {
+namespace detail_ {
+
+[[noreturn]] void bad_cif(const std::string& why)
+{
+    throw std::runtime_error("Malformed CIF file: "+why);
+}
+
+std::string to_lower(std::string_view s)
+{
+    std::string rv(s);
+    for(char& c: rv)c=(c>='A' && c<='Z' ? c-'A'+'a' : c);
+    return rv;
+}
+
+//A token of a CIF file, quoted values and text fields are never tags
+struct CifToken {
+    std::string_view text;
+    bool quoted=false;
+
+    bool is(std::string_view keyword)const
+    {
+        return !quoted && to_lower(text.substr(0,keyword.size()))==keyword;
+    }
+};
+
+//Splits the first data block of buffer into tokens, dropping comments
+std::vector<CifToken> cif_block_tokens(std::string_view buffer)
+{
+    std::vector<CifToken> rv;
+    bool in_block=false;
+    size_t pos=0;
+    while(pos<buffer.size())
+    {
+        size_t eol=buffer.find('\n',pos);
+        if(eol==std::string_view::npos)eol=buffer.size();
+        if(buffer[pos]==';')
+        {
+            //A text field runs up to the next line starting with a ';'
+            const size_t end=buffer.find("\n;",pos);
+            if(end==std::string_view::npos)bad_cif("unterminated text field");
+            rv.push_back(CifToken{buffer.substr(pos+1,end-pos-1),true});
+            eol=buffer.find('\n',end+1);
+            pos=(eol==std::string_view::npos ? buffer.size() : eol+1);
+            continue;
+        }
+        const std::string_view line=buffer.substr(pos,eol-pos);
+        pos=eol+1;
+        const size_t n=line.size();
+        for(size_t i=0;;)
+        {
+            while(i<n && is_space(line[i]))++i;
+            if(i==n || line[i]=='#')break;
+            CifToken token;
+            const char quote=line[i];
+            if(quote=='\'' || quote=='"')
+            {
+                //A quote only closes the value if followed by whitespace
+                size_t end=i+1;
+                while(end<n && !(line[end]==quote &&
+                                 (end+1==n || is_space(line[end+1]))))
+                    ++end;
+                token=CifToken{line.substr(i+1,end-i-1),true};
+                i=end+1;
+            }
+            else
+            {
+                const size_t begin=i;
+                while(i<n && !is_space(line[i]))++i;
+                token=CifToken{line.substr(begin,i-begin),false};
+            }
+            if(token.is("data_"))
+            {
+                if(in_block)return rv;
+                in_block=true;
+                continue;
+            }
+            rv.push_back(token);
+        }
+    }
+    return rv;
+}
+
+//A loop of a CIF file, its values row by row
+struct CifLoop {
+    std::vector<std::string> tags;
+    std::vector<std::string_view> values;
+
+    size_t column(std::string_view tag)const noexcept
+    {
+        for(size_t i=0;i<tags.size();++i)
+            if(tags[i]==tag)return i;
+        return std::string_view::npos;
+    }
+
+    size_t nrows()const noexcept
+    {
+        return values.size()/tags.size();
+    }
+
+    std::string_view value(size_t row, size_t col)const noexcept
+    {
+        return values[row*tags.size()+col];
+    }
+};
+
+//The data items and loops of a CIF data block, tags in lower case
+struct CifBlock {
+    std::unordered_map<std::string,std::string_view> items;
+    std::vector<CifLoop> loops;
+
+    ///The loop with a column tag, nullptr if there is none
+    const CifLoop* find_loop(std::string_view tag)const noexcept
+    {
+        for(const CifLoop& loop: loops)
+            if(loop.column(tag)!=std::string_view::npos)return &loop;
+        return nullptr;
+    }
+
+    ///The value of a data item, empty if there is none
+    std::string_view item(const std::string& tag)const
+    {
+        auto it=items.find(tag);
+        return it==items.end() ? std::string_view() : it->second;
+    }
+};
+
+CifBlock read_cif_block(std::string_view buffer)
+{
+    const std::vector<CifToken> tokens=cif_block_tokens(buffer);
+    auto is_tag=[](const CifToken& t){
+        return !t.quoted && !t.text.empty() && t.text[0]=='_';
+    };
+    CifBlock rv;
+    for(size_t i=0;i<tokens.size();)
+    {
+        if(tokens[i].is("loop_"))
+        {
+            CifLoop loop;
+            for(++i;i<tokens.size() && is_tag(tokens[i]);++i)
+                loop.tags.push_back(to_lower(tokens[i].text));
+            for(;i<tokens.size() && !is_tag(tokens[i]) &&
+                 !tokens[i].is("loop_");++i)
+                loop.values.push_back(tokens[i].text);
+            if(loop.tags.empty() || loop.values.size()%loop.tags.size())
+                bad_cif("loop with "+std::to_string(loop.tags.size())+
+                        " columns has "+std::to_string(loop.values.size())+
+                        " values");
+            rv.loops.push_back(std::move(loop));
+        }
+        else if(is_tag(tokens[i]))
+        {
+            if(i+1==tokens.size() || is_tag(tokens[i+1]))
+                bad_cif("missing value for "+std::string(tokens[i].text));
+            rv.items[to_lower(tokens[i].text)]=tokens[i+1].text;
+            i+=2;
+        }
+        else
+            ++i;//Save frames, global blocks and such are of no interest
+    }
+    return rv;
+}
+
+//Converts a CIF number, which may carry an uncertainty, e.g. "1.234(5)"
+bool cif_number(std::string_view token, double& value)
+{
+    const size_t paren=token.find('(');
+    if(paren!=std::string_view::npos)token=token.substr(0,paren);
+    return to_double(token,value);
+}
+
+double required_number(const CifBlock& block, const std::string& tag)
+{
+    double rv;
+    if(!cif_number(block.item(tag),rv))
+        bad_cif("missing or malformed "+tag);
+    return rv;
+}
+
+//The element of an atom site, from its type symbol (e.g. "Fe3+") or label
+size_t site_Z(std::string_view type, std::string_view label)
+{
+    if(!type.empty() && type!="?" && type!=".")
+    {
+        size_t n=0;
+        while(n<type.size() && is_alpha(type[n]))++n;
+        return symbol_to_Z(type.substr(0,n));
+    }
+    //Labels are the symbol followed by a number, e.g. "Cl1" or "C12"
+    const bool two=(label.size()>1 && label[1]>='a' && label[1]<='z');
+    return symbol_to_Z(label.substr(0,two ? 2 : 1));
+}
+
+//Hashes positions into cubic cells as wide as the tolerance
+class SpatialHash {
+public:
+    explicit SpatialHash(double tolerance):
+        tolerance_(tolerance)
+    {}
+
+    ///True if an atom of element Z closer than the tolerance to r is known
+    bool has_copy(const std::array<double,3>& r, size_t Z)const
+    {
+        const Key key=key_of(r);
+        for(long dx=-1;dx<=1;++dx)
+            for(long dy=-1;dy<=1;++dy)
+                for(long dz=-1;dz<=1;++dz)
+                {
+                    auto it=cells_.find(Key{key[0]+dx,key[1]+dy,key[2]+dz});
+                    if(it==cells_.end())continue;
+                    for(size_t i: it->second)
+                    {
+                        double r2=0.0;
+                        for(size_t k=0;k<3;++k)
+                            r2+=(r[k]-r_[i][k])*(r[k]-r_[i][k]);
+                        if(Z_[i]==Z && r2<tolerance_*tolerance_)return true;
+                    }
+                }
+        return false;
+    }
+
+    void insert(const std::array<double,3>& r, size_t Z)
+    {
+        cells_[key_of(r)].push_back(r_.size());
+        r_.push_back(r);
+        Z_.push_back(Z);
+    }
+
+private:
+    using Key=std::array<long,3>;
+
+    struct KeyHash {
+        size_t operator()(const Key& key)const noexcept
+        {
+            return static_cast<size_t>(key[0])*73856093u^
+                   static_cast<size_t>(key[1])*19349663u^
+                   static_cast<size_t>(key[2])*83492791u;
+        }
+    };
+
+    Key key_of(const std::array<double,3>& r)const noexcept
+    {
+        return Key{static_cast<long>(std::floor(r[0]/tolerance_)),
+                   static_cast<long>(std::floor(r[1]/tolerance_)),
+                   static_cast<long>(std::floor(r[2]/tolerance_))};
+    }
+
+    double tolerance_;
+    std::unordered_map<Key,std::vector<size_t>,KeyHash> cells_;
+    std::vector<std::array<double,3>> r_;
+    std::vector<size_t> Z_;
+};
+
+std::vector<SymmetryOperator> symmetry_operators(const CifBlock& block,
+                                                 std::string& space_group)
+{
+    space_group=std::string(block.item("_space_group_name_h-m_alt"));
+    if(space_group.empty())
+        space_group=std::string(block.item("_symmetry_space_group_name_h-m"));
+
+    std::vector<SymmetryOperator> rv;
+    for(const char* tag: {"_space_group_symop_operation_xyz",
+                          "_symmetry_equiv_pos_as_xyz"})
+    {
+        if(const CifLoop* loop=block.find_loop(tag))
+        {
+            const size_t col=loop->column(tag);
+            for(size_t i=0;i<loop->nrows();++i)
+                rv.push_back(parse_symmetry_operator(loop->value(i,col)));
+            return rv;
+        }
+        if(block.items.count(tag))
+            return {parse_symmetry_operator(block.item(tag))};
+    }
+
+    std::string compact;
+    for(char c: space_group)
+        if(!is_space(c))compact.push_back(c);
+    if(!compact.empty() && compact!="P1")
+        bad_cif("no symmetry operators for space group "+space_group);
+    SymmetryOperator identity;
+    for(size_t i=0;i<3;++i)identity.rotation[i][i]=1.0;
+    return {identity};
+}
+
+}//End namespace detail_
+
+std::array<std::array<double,3>,3> UnitCell::fractional_to_cartesian()const
+{
+    const double to_rad=std::acos(-1.0)/180.0;
+    const double ca=std::cos(angles[0]*to_rad), cb=std::cos(angles[1]*to_rad),
+                 cg=std::cos(angles[2]*to_rad), sg=std::sin(angles[2]*to_rad);
+    const double v=std::sqrt(1.0-ca*ca-cb*cb-cg*cg+2.0*ca*cb*cg);
+    const double a=lengths[0], b=lengths[1], c=lengths[2];
+    return {{{a,b*cg,c*cb},
+             {0.0,b*sg,c*(ca-cb*cg)/sg},
+             {0.0,0.0,c*v/sg}}};
+}
+
+SymmetryOperator parse_symmetry_operator(std::string_view op)
+{
+    auto bad=[&](){
+        throw std::runtime_error("Malformed symmetry operator: "+
+                                 std::string(op));
+    };
+    SymmetryOperator rv;
+    size_t row=0, pos=0;
+    const size_t n=op.size();
+    while(true)
+    {
+        if(row==3)bad();
+        bool have_term=false;
+        while(true)
+        {
+            while(pos<n && detail_::is_space(op[pos]))++pos;
+            if(pos==n || op[pos]==',')break;
+            double sign=1.0;
+            if(op[pos]=='+' || op[pos]=='-')
+            {
+                sign=(op[pos++]=='-' ? -1.0 : 1.0);
+                while(pos<n && detail_::is_space(op[pos]))++pos;
+            }
+            double value=1.0;
+            bool have_number=false;
+            if(pos<n && (detail_::is_digit(op[pos]) || op[pos]=='.'))
+            {
+                size_t end=pos;
+                while(end<n && (detail_::is_digit(op[end]) || op[end]=='.'))
+                    ++end;
+                if(!detail_::to_double(op.substr(pos,end-pos),value))bad();
+                pos=end;
+                if(pos<n && op[pos]=='/')
+                {
+                    end=++pos;
+                    while(end<n && detail_::is_digit(op[end]))++end;
+                    double denominator;
+                    if(!detail_::to_double(op.substr(pos,end-pos),
+                                           denominator) || !denominator)
+                        bad();
+                    value/=denominator;
+                    pos=end;
+                }
+                have_number=true;
+                while(pos<n && (detail_::is_space(op[pos]) || op[pos]=='*'))
+                    ++pos;
+            }
+            const char axis=(pos<n ? op[pos]|0x20 : '\0');//Lower case
+            if(axis>='x' && axis<='z')
+            {
+                rv.rotation[row][axis-'x']+=sign*value;
+                ++pos;
+            }
+            else if(have_number)
+                rv.shift[row]+=sign*value;
+            else
+                bad();
+            have_term=true;
+        }
+        if(!have_term)bad();
+        ++row;
+        if(pos==n)break;
+        ++pos;//The comma
+    }
+    if(row!=3)bad();
+    return rv;
+}
+
+Crystal parse_cif_buffer(std::string_view buffer, double tolerance)
+{
+    using namespace detail_;
+    if(!(tolerance>0.0))
+        throw std::invalid_argument("Tolerance must be positive");
+    const CifBlock block=read_cif_block(buffer);
+
+    Crystal rv;
+    UnitCell& cell=rv.cell;
+    const std::array<const char*,3> sides({"_cell_length_a","_cell_length_b",
+                                           "_cell_length_c"});
+    const std::array<const char*,3> angles({"_cell_angle_alpha",
+                                            "_cell_angle_beta",
+                                            "_cell_angle_gamma"});
+    for(size_t i=0;i<3;++i)
+    {
+        cell.lengths[i]=required_number(block,sides[i])*angstrom2bohr;
+        cell.angles[i]=required_number(block,angles[i]);
+    }
+    const auto to_cart=cell.fractional_to_cartesian();
+    if(!(to_cart[2][2]>0.0) || !(cell.lengths[0]>0.0) ||
+       !(cell.lengths[1]>0.0))
+        bad_cif("degenerate unit cell");
+    const std::vector<SymmetryOperator> ops=
+        symmetry_operators(block,cell.space_group);
+
+    //The asymmetric unit
+    const CifLoop* sites=block.find_loop("_atom_site_fract_x");
+    if(!sites)bad_cif("no fractional coordinates");
+    std::array<size_t,3> cols;
+    for(size_t k=0;k<3;++k)
+    {
+        cols[k]=sites->column(std::string("_atom_site_fract_")+
+                              static_cast<char>('x'+k));
+        if(cols[k]==std::string_view::npos)
+            bad_cif("missing fractional coordinate column");
+    }
+    const size_t type_col=sites->column("_atom_site_type_symbol");
+    const size_t label_col=sites->column("_atom_site_label");
+    if(type_col==std::string_view::npos && label_col==std::string_view::npos)
+        bad_cif("atom sites have neither type symbols nor labels");
+    const size_t nasym=sites->nrows();
+    std::array<std::vector<double>,3> f;
+    std::vector<size_t> Zs(nasym);
+    for(size_t k=0;k<3;++k)f[k].resize(nasym);
+    for(size_t a=0;a<nasym;++a)
+    {
+        for(size_t k=0;k<3;++k)
+            if(!cif_number(sites->value(a,cols[k]),f[k][a]))
+                bad_cif("malformed coordinate "+
+                        std::string(sites->value(a,cols[k])));
+        Zs[a]=site_Z(type_col==std::string_view::npos ? std::string_view() :
+                     sites->value(a,type_col),
+                     label_col==std::string_view::npos ? std::string_view() :
+                     sites->value(a,label_col));
+    }
+    rv.nasymmetric=nasym;
+
+    /* How far apart two atoms closer than the tolerance can be, in fractions
+     * of each side.  Rows of the inverse of to_cart are the reciprocal
+     * vectors, i.e. the cross products of the other two sides over the volume.
+     */
+    std::array<double,3> feps;
+    const double volume=to_cart[0][0]*to_cart[1][1]*to_cart[2][2];
+    for(size_t k=0;k<3;++k)
+    {
+        const size_t i=(k+1)%3, j=(k+2)%3;
+        double norm2=0.0;
+        for(size_t x=0;x<3;++x)
+        {
+            const size_t y=(x+1)%3, z=(x+2)%3;
+            const double cross=to_cart[y][i]*to_cart[z][j]-
+                               to_cart[z][i]*to_cart[y][j];
+            norm2+=cross*cross;
+        }
+        feps[k]=tolerance*std::sqrt(norm2)/volume;
+    }
+
+    //Apply each operator to the whole asymmetric unit at once
+    std::array<std::vector<double>,3> g;
+    for(auto& gk: g)gk.resize(nasym);
+    SpatialHash hash(tolerance);
+    AtomPrototypes prototypes;
+    rv.atoms.reserve(nasym*ops.size());
+    for(const SymmetryOperator& op: ops)
+    {
+        for(size_t k=0;k<3;++k)
+        {
+            const auto& R=op.rotation[k];
+            double* gk=g[k].data();
+            for(size_t a=0;a<nasym;++a)
+            {
+                const double x=R[0]*f[0][a]+R[1]*f[1][a]+R[2]*f[2][a]+
+                               op.shift[k];
+                gk[a]=x-std::floor(x);
+            }
+        }
+        for(size_t a=0;a<nasym;++a)
+        {
+            std::array<double,3> r;
+            for(size_t i=0;i<3;++i)
+                r[i]=to_cart[i][0]*g[0][a]+to_cart[i][1]*g[1][a]+
+                     to_cart[i][2]*g[2][a];
+            //Near a face the copy may be on the far side, so also look at
+            //the images of r one cell over across each face it is near
+            std::array<int,3> side;
+            for(size_t k=0;k<3;++k)
+                side[k]=(g[k][a]<feps[k] ? 1 : (g[k][a]>1.0-feps[k] ? -1 : 0));
+            bool copy=false;
+            for(unsigned faces=0;faces<8 && !copy;++faces)
+            {
+                std::array<double,3> image=r;
+                bool near=true;
+                for(size_t k=0;k<3 && near;++k)
+                {
+                    if(!(faces>>k & 1u))continue;
+                    near=(side[k]!=0);
+                    for(size_t i=0;i<3;++i)image[i]+=side[k]*to_cart[i][k];
+                }
+                copy=near && hash.has_copy(image,Zs[a]);
+            }
+            if(copy)continue;
+            hash.insert(r,Zs[a]);
+            rv.atoms.push_back(prototypes.make(r,Zs[a]));
+        }
+    }
+    return rv;
+}
+
+Crystal parse_cif_file(const std::string& path, double tolerance)
+{
+    const detail_::MappedFile file(path);
+    std::string buffer;
+    return parse_cif_buffer(detail_::decompressed_contents(file.data(),buffer),
+                            tolerance);
+}
+
+}//End namespace
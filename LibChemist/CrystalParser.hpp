@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LibChemist/SetOfAtoms.hpp"
+
+/** \file This file contains a reader for the CIF files of small-molecule and
+ *  inorganic crystal structures.
+ *
+ * Such files give the unit cell, the symmetry operators of the space group and
+ * the fractional coordinates of the atoms of the asymmetric unit.  The reader
+ * applies every operator to every atom of the asymmetric unit, wraps the
+ * results into the unit cell, and drops the copies of atoms sitting on
+ * special positions (i.e. those mapped onto themselves by some operator).
+ *
+ * Copies are found with a spatial hash whose cells are as wide as the
+ * tolerance, so each new atom is only compared against the atoms in the 27
+ * cells around it and expanding a cell of N atoms costs O(N), unlike
+ * SetOfAtoms::insert which compares against every atom and only removes
+ * exact copies.  Two atoms are copies if they are of the same element and
+ * closer than the tolerance, taking the periodicity of the cell into account.
+ *
+ * Only the first data block is read.  Occupancies are ignored, so all sites
+ * of a disordered structure are kept.  Lengths are converted from Angstroms
+ * to Bohr.  The symmetry operators are taken from the
+ * _space_group_symop_operation_xyz or _symmetry_equiv_pos_as_xyz loop; the
+ * space group symbol is recorded but not looked up.
+ */
+
+namespace LibChemist {
+
+///The unit cell of a crystal
+struct UnitCell {
+    ///The lengths of the sides a, b and c, in Bohr
+    std::array<double,3> lengths{0.0,0.0,0.0};
+
+    ///The angles alpha, beta and gamma, in degrees
+    std::array<double,3> angles{90.0,90.0,90.0};
+
+    ///The Hermann-Mauguin symbol of the space group, as given in the file
+    std::string space_group;
+
+    /** \brief Returns the matrix taking fractional to Cartesian coordinates.
+     *
+     *  The convention is the usual one: a lies along x and b in the xy
+     *  plane.  Row i of the result gives Cartesian component i.
+     */
+    std::array<std::array<double,3>,3> fractional_to_cartesian()const;
+
+    bool operator==(const UnitCell& rhs)const noexcept
+    {
+        return lengths==rhs.lengths && angles==rhs.angles &&
+               space_group==rhs.space_group;
+    }
+
+    bool operator!=(const UnitCell& rhs)const noexcept
+    {
+        return !((*this)==rhs);
+    }
+};
+
+///A symmetry operator, taking fractional coordinates f to rotation*f+shift
+struct SymmetryOperator {
+    std::array<std::array<double,3>,3> rotation{};
+    std::array<double,3> shift{};
+};
+
+/** \brief Parses a symmetry operator written as in CIF files.
+ *
+ *  \param[in] op The operator, e.g. "-x+1/2, y, -z" or "x-y,x,z+1/3".
+ *  \returns The operator.
+ *  \throws std::runtime_error if \p op is malformed.
+ */
+SymmetryOperator parse_symmetry_operator(std::string_view op);
+
+///The contents of one unit cell of a crystal
+struct Crystal {
+    UnitCell cell;
+
+    ///The atoms in the unit cell, in Cartesian coordinates
+    SetOfAtoms atoms;
+
+    ///The number of atoms in the asymmetric unit
+    size_t nasymmetric=0;
+};
+
+/** \brief Parses the contents of a CIF file and expands the asymmetric unit
+ *         to the full unit cell.
+ *
+ *  \param[in] buffer The contents of the file.
+ *  \param[in] tolerance Atoms of the same element closer than this many Bohr
+ *                       are considered copies of each other.
+ *  \returns The unit cell and the atoms in it.  Atoms appear in the order of
+ *           the operators, and for each operator in the order of the
+ *           asymmetric unit.
+ *  \throws std::runtime_error if the file lacks the cell, the fractional
+ *          coordinates, or the symmetry operators (unless the space group is
+ *          P 1), or if any of them is malformed.
+ *  \throws std::out_of_range if an element symbol is not recognized.
+ */
+Crystal parse_cif_buffer(std::string_view buffer, double tolerance=0.1);
+
+/** \brief Parses the CIF file at \p path.
+ *
+ *  The file is memory mapped, or decompressed into memory if it is
+ *  gzip-compressed, and then parsed by parse_cif_buffer.
+ *
+ *  \throws std::runtime_error if the file can not be read, plus anything
+ *          parse_cif_buffer throws.
+ */
+Crystal parse_cif_file(const std::string& path, double tolerance=0.1);
+
+}//End namespace
@@ -0,0 +1,174 @@
+#include "LibChemist/DCDTrajectory.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace LibChemist {
+namespace detail_ {
+
+//The size of the first header record
+constexpr std::uint32_t dcd_header_record=84;
+
+//The size of a unit cell record, including its markers
+constexpr size_t dcd_cell_record=8+6*sizeof(double);
+
+std::uint32_t byte_swap(std::uint32_t x)noexcept
+{
+    return (x>>24)|((x>>8)&0xFF00)|((x<<8)&0xFF0000)|(x<<24);
+}
+
+//Reads the 4 byte word at p, which need not be aligned
+std::uint32_t read_word(const char* p, bool swap)noexcept
+{
+    std::uint32_t rv;
+    std::memcpy(&rv,p,sizeof(rv));
+    return swap ? byte_swap(rv) : rv;
+}
+
+float read_float(const char* p, bool swap)noexcept
+{
+    const std::uint32_t word=read_word(p,swap);
+    float rv;
+    std::memcpy(&rv,&word,sizeof(rv));
+    return rv;
+}
+
+double read_double(const char* p, bool swap)noexcept
+{
+    std::uint64_t word;
+    std::memcpy(&word,p,sizeof(word));
+    if(swap)
+        word=(static_cast<std::uint64_t>(byte_swap(word&0xFFFFFFFF))<<32)|
+             byte_swap(word>>32);
+    double rv;
+    std::memcpy(&rv,&word,sizeof(rv));
+    return rv;
+}
+
+[[noreturn]] void bad_dcd(const std::string& why)
+{
+    throw std::runtime_error("Malformed DCD file: "+why);
+}
+
+//Checks the Fortran record at pos and returns the position after it
+size_t skip_record(std::string_view data, size_t pos, bool swap)
+{
+    if(pos+4>data.size())bad_dcd("truncated header");
+    const size_t size=read_word(data.data()+pos,swap);
+    if(pos+8+size>data.size() ||
+       read_word(data.data()+pos+4+size,swap)!=size)
+        bad_dcd("mismatched record markers");
+    return pos+8+size;
+}
+
+}//End namespace detail_
+
+DCDTrajectory::DCDTrajectory(const std::string& path):
+    file_(path)
+{
+    using namespace detail_;
+    const std::string_view data=file_.data();
+    if(data.size()<8+dcd_header_record)bad_dcd("too short");
+    const std::uint32_t marker=read_word(data.data(),false);
+    if(marker!=dcd_header_record)
+    {
+        if(byte_swap(marker)!=dcd_header_record)
+            bad_dcd("unrecognized header, 64-bit record markers are not "
+                    "supported");
+        swap_=true;
+    }
+    if(data.compare(4,4,"CORD"))bad_dcd("missing CORD signature");
+
+    //The twenty control words following the signature
+    auto icntrl=[&](size_t j){return read_word(data.data()+8+4*j,swap_);};
+    const bool charmm=(icntrl(19)!=0);
+    if(icntrl(8))
+        throw std::runtime_error("DCD files with fixed atoms are not "
+                                 "supported");
+    if(charmm)
+    {
+        timestep_=read_float(data.data()+8+4*9,swap_);
+        has_cell_=(icntrl(10)!=0);
+    }
+    else
+        timestep_=read_double(data.data()+8+4*9,swap_);
+    const bool four_d=(charmm && icntrl(11)!=0);
+
+    size_t pos=skip_record(data,0,swap_);
+    pos=skip_record(data,pos,swap_);//Title
+    if(pos+12>data.size() || read_word(data.data()+pos,swap_)!=4)
+        bad_dcd("missing number of atoms");
+    natoms_=read_word(data.data()+pos+4,swap_);
+    header_size_=skip_record(data,pos,swap_);
+
+    const size_t coord_record=8+4*natoms_;
+    frame_size_=(has_cell_ ? dcd_cell_record : 0)+(four_d ? 4 : 3)*
+                coord_record;
+    nframes_=(data.size()-header_size_)/frame_size_;
+    //The markers of the first frame catch files we misunderstood
+    if(nframes_)
+    {
+        size_t frame=header_size_;
+        if(has_cell_)frame=skip_record(data,frame,swap_);
+        if(read_word(data.data()+frame,swap_)!=4*natoms_ ||
+           skip_record(data,frame,swap_)!=frame+coord_record)
+            bad_dcd("frame size does not match the number of atoms");
+    }
+}
+
+const char* DCDTrajectory::coordinates(size_t i)const
+{
+    if(i>=nframes_)
+        throw std::out_of_range("Frame "+std::to_string(i)+" requested, but "
+                                "the trajectory has "+std::to_string(nframes_)+
+                                " frames");
+    return file_.data().data()+offset(i)+
+           (has_cell_ ? detail_::dcd_cell_record : 0);
+}
+
+DCDFrame DCDTrajectory::frame_view(size_t i)const
+{
+    const char* x=coordinates(i)+4;
+    if(swap_)
+        throw std::runtime_error("The DCD file is not in this machine's byte "
+                                 "order, its coordinates can not be viewed");
+    //Records hold whole words and the mapping is page aligned, so the
+    //coordinates are aligned
+    const size_t stride=8+4*natoms_;
+    DCDFrame rv;
+    rv.x=Span<const float>(reinterpret_cast<const float*>(x),natoms_);
+    rv.y=Span<const float>(reinterpret_cast<const float*>(x+stride),natoms_);
+    rv.z=Span<const float>(reinterpret_cast<const float*>(x+2*stride),
+                           natoms_);
+    return rv;
+}
+
+std::array<double,6> DCDTrajectory::unit_cell(size_t i)const
+{
+    const char* x=coordinates(i);
+    if(!has_cell_)
+        throw std::runtime_error("The DCD file has no unit cells");
+    const char* cell=x-detail_::dcd_cell_record+4;
+    std::array<double,6> rv;
+    for(size_t j=0;j<6;++j)
+        rv[j]=detail_::read_double(cell+8*j,swap_);
+    return rv;
+}
+
+void DCDTrajectory::patch(size_t i, SetOfAtoms& atoms)const
+{
+    const char* x=coordinates(i)+4;
+    if(atoms.size()!=natoms_)
+        throw std::runtime_error("The DCD file has "+std::to_string(natoms_)+
+                                 " atoms per frame, but the SetOfAtoms has "+
+                                 std::to_string(atoms.size()));
+    const size_t stride=8+4*natoms_;
+    for(size_t j=0;j<natoms_;++j)
+        for(size_t k=0;k<3;++k)
+            atoms[j].coord[k]=
+                detail_::read_float(x+k*stride+4*j,swap_)*
+                detail_::angstrom2bohr;
+}
+
+}//End namespace
@@ -0,0 +1,157 @@
+#pragma once
+#include <array>
+#include <string>
+#include "LibChemist/SetOfAtoms.hpp"
+#include "LibChemist/Span.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+
+/** \file This file contains a reader for the binary DCD trajectories written by
+ *  CHARMM, NAMD, OpenMM and friends.
+ *
+ * A DCD file is a header followed by frames of the same size, so the offset of
+ * every frame follows from the header alone and the file never needs to be
+ * scanned.  The file is memory mapped and a frame's coordinates are handed out
+ * as views into the mapping.  The number of frames is taken from the size of
+ * the file rather than from the header, which is often out of date for
+ * trajectories that were cut short or are still being written; a partial last
+ * frame is ignored.
+ *
+ * Both byte orders are understood, as are X-PLOR and CHARMM headers, unit
+ * cells and the fourth dimension (which is skipped).  Files with 64-bit
+ * record markers or fixed atoms are not supported.
+ */
+
+namespace LibChemist {
+
+/** \brief The coordinates of one frame of a DCD trajectory.
+ *
+ *  The coordinates are in Angstroms, as in the file, and the spans point into
+ *  the mapping of the file, i.e. they are only valid as long as the
+ *  DCDTrajectory they came from.
+ */
+struct DCDFrame {
+    Span<const float> x;
+    Span<const float> y;
+    Span<const float> z;
+};
+
+/** \brief Random access to the frames of a DCD trajectory on disk.
+ *
+ *  Frames are usually turned into SetOfAtoms by patching their coordinates
+ *  into a template holding everything else, e.g. the elements, charge and
+ *  basis sets:
+ *
+ *  \code
+    DCDTrajectory traj("md.dcd");
+    SetOfAtoms frame=apply_basis_set("PRIMARY",basis,topology);
+    for(size_t i=0;i<traj.size();++i)
+    {
+        traj.patch(i,frame);
+        analyze(frame);
+    }
+    \endcode
+ */
+class DCDTrajectory {
+public:
+    /** \brief Opens the trajectory at \p path.
+     *
+     *  \param[in] path The path to the trajectory.
+     *  \throws std::runtime_error if the file can not be mapped, is not a DCD
+     *          file, or uses a layout that is not supported.
+     */
+    explicit DCDTrajectory(const std::string& path);
+
+    ///Returns the number of complete frames in the trajectory
+    size_t size()const noexcept
+    {
+        return nframes_;
+    }
+
+    ///Returns the number of atoms in each frame
+    size_t natoms()const noexcept
+    {
+        return natoms_;
+    }
+
+    ///Returns the time between frames, in AKMA units, as stored in the header
+    double timestep()const noexcept
+    {
+        return timestep_;
+    }
+
+    ///Returns true if each frame carries a unit cell
+    bool has_unit_cell()const noexcept
+    {
+        return has_cell_;
+    }
+
+    ///Returns true if the file has this machine's byte order
+    bool native_byte_order()const noexcept
+    {
+        return !swap_;
+    }
+
+    ///Returns the byte offset of frame \p i, \p i may be size()
+    size_t offset(size_t i)const noexcept
+    {
+        return header_size_+i*frame_size_;
+    }
+
+    /** \brief Returns views of the coordinates of frame \p i.
+     *
+     *  No coordinates are copied or converted.
+     *
+     *  \throws std::out_of_range if \p i is not a valid frame.
+     *  \throws std::runtime_error if the file does not have this machine's
+     *          byte order, in which case the coordinates can not be used in
+     *          place; use patch instead.
+     */
+    DCDFrame frame_view(size_t i)const;
+
+    /** \brief Returns the unit cell of frame \p i.
+     *
+     *  \returns The cell in the order the file stores it: a, gamma, b, beta,
+     *           alpha, c (or the cosines of the angles, depending on the
+     *           program that wrote the file).
+     *  \throws std::out_of_range if \p i is not a valid frame.
+     *  \throws std::runtime_error if the trajectory has no unit cells.
+     */
+    std::array<double,6> unit_cell(size_t i)const;
+
+    /** \brief Overwrites the coordinates of \p atoms with those of frame \p i.
+     *
+     *  Coordinates are converted to Bohr.  Nothing else about \p atoms is
+     *  touched, so elements, charges and basis sets carry over from frame to
+     *  frame.
+     *
+     *  \param[in] i The frame to read.
+     *  \param[in,out] atoms The atoms to move, in the order of the trajectory.
+     *  \throws std::out_of_range if \p i is not a valid frame.
+     *  \throws std::runtime_error if \p atoms does not have natoms() atoms.
+     */
+    void patch(size_t i, SetOfAtoms& atoms)const;
+
+    ///Same as patch, but returns a copy of \p templ with the coordinates
+    SetOfAtoms frame(size_t i, const SetOfAtoms& templ)const
+    {
+        SetOfAtoms rv(templ);
+        patch(i,rv);
+        return rv;
+    }
+
+private:
+    ///Returns the start of frame i's coordinate records, checking i
+    const char* coordinates(size_t i)const;
+
+    ///The mapped trajectory
+    detail_::MappedFile file_;
+    size_t natoms_=0;
+    size_t nframes_=0;
+    size_t header_size_=0;
+    size_t frame_size_=0;
+    double timestep_=0.0;
+    bool has_cell_=false;
+    bool swap_=false;
+};
+
+}//End namespace
@@ -0,0 +1,64 @@
+#pragma once
+#include <tuple>
+#include <vector>
+
+namespace LibChemist {
+
+/** \brief The effective core potential (ECP) of an element.
+ *
+ *  An ECP replaces the \p ncore innermost electrons of an atom by a potential.
+ *  The potential is made of channels, each of which is a sum of terms
+ *  \f$c r^{n-2} e^{-\alpha r^2}\f$.  Channels \f$l<l_{max}\f$ are projected
+ *  onto angular momentum \f$l\f$, channel \f$l_{max}\f$ is the local part felt
+ *  by all angular momenta of \f$l_{max}\f$ and above.
+ *
+ *  The terms of all channels are stored back to back, in order of angular
+ *  momentum, in three flat arrays.  Channel \f$l\f$ is terms offsets[l]
+ *  through offsets[l+1].  A default constructed instance is the empty ECP
+ *  of an all-electron atom.
+ */
+struct ECP {
+    ///The number of core electrons the potential replaces
+    size_t ncore=0;
+
+    ///The angular momentum of the local channel, -1 for the empty ECP
+    int lmax=-1;
+
+    ///Where each channel starts in the term arrays, lmax+2 long
+    std::vector<size_t> offsets;
+
+    ///The power of r (plus 2) of each term
+    std::vector<int> powers;
+
+    ///The Gaussian exponent of each term
+    std::vector<double> alphas;
+
+    ///The coefficient of each term
+    std::vector<double> coefs;
+
+    ///Returns true if this is the empty ECP
+    bool empty()const noexcept{return lmax<0;}
+
+    ///Returns the total number of terms, over all channels
+    size_t nterms()const noexcept{return alphas.size();}
+
+    ///Returns the number of terms in channel \p l, which must be in [0,lmax]
+    size_t nterms(int l)const noexcept{return offsets[l+1]-offsets[l];}
+
+    /** \brief Returns true if this instance is exactly equal to another.
+     *
+     *  \param[in] rhs The instance to compare against.
+     *  \throw No throw guarantee.
+     */
+    bool operator==(const ECP& rhs)const noexcept
+    {
+        return std::tie(ncore,lmax,offsets,powers,alphas,coefs)==
+               std::tie(rhs.ncore,rhs.lmax,rhs.offsets,rhs.powers,rhs.alphas,
+                        rhs.coefs);
+    }
+
+    ///Returns true if any part of this instance differs from \p rhs
+    bool operator!=(const ECP& rhs)const noexcept{return !(*this==rhs);}
+};
+
+}//End namespace LibChemist
@@ -0,0 +1,437 @@
+#include "LibChemist/MoleculeParser.hpp"
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace LibChemist {
+namespace detail_ {
+
+//Below this many bytes per thread it's not worth decoding in parallel
+constexpr size_t min_molecule_chunk=1<<16;
+
+//A bond as read from the file, atoms numbered from 1
+struct BondEntry {
+    size_t a;
+    size_t b;
+    std::uint8_t order;
+};
+
+//Returns the next line of buffer, without its newline or carriage return
+bool next_line(std::string_view buffer, size_t& pos, std::string_view& line)
+{
+    if(pos>=buffer.size())return false;
+    size_t eol=buffer.find('\n',pos);
+    if(eol==std::string_view::npos)eol=buffer.size();
+    line=buffer.substr(pos,eol-pos);
+    if(!line.empty() && line.back()=='\r')line.remove_suffix(1);
+    pos=eol+1;
+    return true;
+}
+
+bool starts_with(std::string_view line, std::string_view prefix)noexcept
+{
+    return line.substr(0,prefix.size())==prefix;
+}
+
+bool is_sdf_terminator(std::string_view line)noexcept
+{
+    return trim(line)=="$$$$";
+}
+
+bool is_mol2_start(std::string_view line)noexcept
+{
+    return starts_with(line,"@<TRIPOS>MOLECULE");
+}
+
+//Converts a non-negative integer, throwing if it is malformed
+size_t to_count(std::string_view token, std::string_view line)
+{
+    size_t value=0;
+    const auto result=std::from_chars(token.data(),token.data()+token.size(),
+                                      value);
+    if(token.empty() || result.ec!=std::errc() ||
+       result.ptr!=token.data()+token.size())
+        throw std::runtime_error("Malformed integer in line: "+
+                                 std::string(line));
+    return value;
+}
+
+BondTable make_bond_table(size_t natoms, const std::vector<BondEntry>& bonds)
+{
+    BondTable rv;
+    rv.offsets.assign(natoms+1,0);
+    for(const BondEntry& bond: bonds)
+    {
+        if(!bond.a || !bond.b || bond.a>natoms || bond.b>natoms ||
+           bond.a==bond.b)
+            throw std::runtime_error("Bond between atoms "+
+                                     std::to_string(bond.a)+" and "+
+                                     std::to_string(bond.b)+" of a molecule "
+                                     "with "+std::to_string(natoms)+" atoms");
+        ++rv.offsets[bond.a];
+        ++rv.offsets[bond.b];
+    }
+    for(size_t i=1;i<=natoms;++i)
+        rv.offsets[i]+=rv.offsets[i-1];
+    rv.neighbors.resize(2*bonds.size());
+    rv.orders.resize(2*bonds.size());
+    std::vector<std::uint32_t> fill(rv.offsets.begin(),rv.offsets.end()-1);
+    for(const BondEntry& bond: bonds)
+    {
+        const size_t i=bond.a-1, j=bond.b-1;
+        rv.neighbors[fill[i]]=j;
+        rv.orders[fill[i]++]=bond.order;
+        rv.neighbors[fill[j]]=i;
+        rv.orders[fill[j]++]=bond.order;
+    }
+    return rv;
+}
+
+//Calls fxn(value) for each atom/value pair of an "M  CHG"-like property line
+template<typename value_fxn>
+void for_each_property(std::string_view line, value_fxn&& fxn)
+{
+    size_t pos=6;
+    const size_t n=to_count(next_token(line,pos),line);
+    for(size_t i=0;i<n;++i)
+    {
+        next_token(line,pos);
+        double value;
+        if(!to_double(next_token(line,pos),value))
+            throw std::runtime_error("Malformed property line: "+
+                                     std::string(line));
+        fxn(value);
+    }
+}
+
+//Reads an atom line of a V2000 molfile, which is fixed-width by the standard
+void sdf_atom(std::string_view line, std::array<double,3>& xyz,
+              std::string_view& sym, size_t& charge_code)
+{
+    bool good=true;
+    for(size_t i=0;i<3;++i)
+        good=good && to_double(column(line,10*i,10*i+10),xyz[i]);
+    sym=column(line,31,34);
+    const std::string_view code=column(line,36,39);
+    charge_code=0;
+    if(good && is_alpha(sym))
+    {
+        if(!code.empty())charge_code=to_count(code,line);
+        return;
+    }
+    //Some writers don't respect the columns, fall back to the tokens
+    size_t pos=0;
+    for(size_t i=0;i<3;++i)
+        if(!to_double(next_token(line,pos),xyz[i]))
+            throw std::runtime_error("Malformed SDF atom line: "+
+                                     std::string(line));
+    sym=next_token(line,pos);
+    next_token(line,pos);
+    const std::string_view token=next_token(line,pos);
+    if(!token.empty())charge_code=to_count(token,line);
+}
+
+Molecule decode_sdf(std::string_view record, AtomPrototypes& prototypes)
+{
+    Molecule rv;
+    size_t pos=0;
+    std::string_view line;
+    auto require=[&](const char* what){
+        if(!next_line(record,pos,line))
+            throw std::runtime_error(std::string("Truncated SDF record, "
+                                                 "missing ")+what);
+    };
+    require("name");
+    rv.name=std::string(trim(line));
+    require("header");
+    require("comment");
+    require("counts line");
+    if(line.find("V3000")!=std::string_view::npos)
+        throw std::runtime_error("V3000 molfiles are not supported");
+    const size_t natoms=to_count(column(line,0,3),line);
+    const size_t nbonds=to_count(column(line,3,6),line);
+
+    rv.atoms.reserve(natoms);
+    double block_charge=0.0;
+    for(size_t i=0;i<natoms;++i)
+    {
+        require("atoms");
+        std::array<double,3> xyz;
+        std::string_view sym;
+        size_t code;
+        sdf_atom(line,xyz,sym,code);
+        for(double& x: xyz)x*=angstrom2bohr;
+        rv.atoms.push_back(prototypes.make(xyz,symbol_to_Z(sym)));
+        //Codes 1-3 are +3 to +1, 4 is a doublet radical, 5-7 are -1 to -3
+        if(code && code<8 && code!=4)block_charge+=4.0-code;
+    }
+
+    std::vector<BondEntry> bonds(nbonds);
+    for(BondEntry& bond: bonds)
+    {
+        require("bonds");
+        bond.a=to_count(column(line,0,3),line);
+        bond.b=to_count(column(line,3,6),line);
+        bond.order=static_cast<std::uint8_t>(to_count(column(line,6,9),line));
+    }
+    rv.bonds=make_bond_table(natoms,bonds);
+
+    //The properties block, which supersedes the atom block's charges
+    bool have_charges=false;
+    double charge=0.0, unpaired=0.0;
+    while(next_line(record,pos,line) && !starts_with(line,"M  END"))
+    {
+        if(starts_with(line,"M  CHG"))
+        {
+            have_charges=true;
+            for_each_property(line,[&](double value){charge+=value;});
+        }
+        else if(starts_with(line,"M  RAD"))
+            //1 is a singlet, 2 a doublet and 3 a triplet
+            for_each_property(line,[&](double value){
+                if(value>1.0)unpaired+=value-1.0;
+            });
+    }
+    rv.atoms.charge=(have_charges ? charge : block_charge);
+    rv.atoms.multiplicity=1.0+unpaired;
+    return rv;
+}
+
+std::uint8_t mol2_bond_order(std::string_view type)noexcept
+{
+    if(type=="1" || type=="2" || type=="3")return type[0]-'0';
+    if(type=="ar")return 4;
+    if(type=="am")return 1;
+    return 0;
+}
+
+Molecule decode_mol2(std::string_view record, AtomPrototypes& prototypes)
+{
+    enum class section_type{other,molecule,atom,bond};
+    section_type section=section_type::other;
+    size_t nline=0, natoms=0, nbonds=0;
+    bool sequential_ids=true;
+    std::vector<size_t> ids;
+    std::vector<BondEntry> bonds;
+    double charge=0.0;
+    Molecule rv;
+
+    size_t pos=0;
+    std::string_view line;
+    while(next_line(record,pos,line))
+    {
+        if(starts_with(line,"#"))continue;
+        if(starts_with(line,"@<TRIPOS>"))
+        {
+            const std::string_view name=trim(line.substr(9));
+            section=(name=="MOLECULE" ? section_type::molecule :
+                     name=="ATOM" ? section_type::atom :
+                     name=="BOND" ? section_type::bond : section_type::other);
+            nline=0;
+            continue;
+        }
+        if(section==section_type::molecule)
+        {
+            if(nline==0)rv.name=std::string(trim(line));
+            else if(nline==1)
+            {
+                size_t tpos=0;
+                natoms=to_count(next_token(line,tpos),line);
+                const std::string_view token=next_token(line,tpos);
+                nbonds=(token.empty() ? 0 : to_count(token,line));
+                rv.atoms.reserve(natoms);
+                bonds.reserve(nbonds);
+            }
+            ++nline;
+            continue;
+        }
+        if(trim(line).empty())continue;
+        size_t tpos=0;
+        if(section==section_type::atom)
+        {
+            const size_t id=to_count(next_token(line,tpos),line);
+            next_token(line,tpos);
+            std::array<double,3> xyz;
+            for(double& x: xyz)
+            {
+                if(!to_double(next_token(line,tpos),x))
+                    throw std::runtime_error("Malformed MOL2 atom line: "+
+                                             std::string(line));
+                x*=angstrom2bohr;
+            }
+            //The element is the part of the SYBYL type before the '.'
+            std::string_view type=next_token(line,tpos);
+            type=type.substr(0,type.find('.'));
+            rv.atoms.push_back(prototypes.make(xyz,symbol_to_Z(type)));
+            sequential_ids=sequential_ids && id==ids.size()+1;
+            ids.push_back(id);
+            next_token(line,tpos);
+            next_token(line,tpos);
+            double q;
+            if(to_double(next_token(line,tpos),q))charge+=q;
+        }
+        else if(section==section_type::bond)
+        {
+            BondEntry bond;
+            next_token(line,tpos);
+            bond.a=to_count(next_token(line,tpos),line);
+            bond.b=to_count(next_token(line,tpos),line);
+            bond.order=mol2_bond_order(next_token(line,tpos));
+            bonds.push_back(bond);
+        }
+    }
+    if(rv.atoms.size()!=natoms || bonds.size()!=nbonds)
+        throw std::runtime_error("MOL2 record "+rv.name+" should have "+
+                                 std::to_string(natoms)+" atoms and "+
+                                 std::to_string(nbonds)+" bonds, found "+
+                                 std::to_string(rv.atoms.size())+" and "+
+                                 std::to_string(bonds.size()));
+
+    //Bonds refer to atom ids, which are almost always 1,2,3,...
+    if(!sequential_ids)
+    {
+        std::unordered_map<size_t,size_t> index;
+        for(size_t i=0;i<ids.size();++i)index.emplace(ids[i],i+1);
+        for(BondEntry& bond: bonds)
+        {
+            auto a=index.find(bond.a), b=index.find(bond.b);
+            bond.a=(a==index.end() ? 0 : a->second);
+            bond.b=(b==index.end() ? 0 : b->second);
+        }
+    }
+    rv.bonds=make_bond_table(natoms,bonds);
+    rv.atoms.charge=std::round(charge);
+    return rv;
+}
+
+Molecule decode_molecule(std::string_view record, MoleculeFormat format,
+                         AtomPrototypes& prototypes)
+{
+    return (format==MoleculeFormat::sdf ? decode_sdf(record,prototypes) :
+                                          decode_mol2(record,prototypes));
+}
+
+}//End namespace detail_
+
+std::vector<std::string_view>
+split_molecule_records(std::string_view buffer, MoleculeFormat format)
+{
+    std::vector<std::string_view> rv;
+    const bool sdf=(format==MoleculeFormat::sdf);
+    //Where the current record starts, npos if before the first MOL2 record
+    size_t begin=(sdf ? 0 : std::string_view::npos);
+    detail_::for_each_line(buffer,[&](std::string_view line){
+        const size_t offset=line.data()-buffer.data();
+        if(sdf && detail_::is_sdf_terminator(line))
+        {
+            rv.push_back(buffer.substr(begin,offset-begin));
+            begin=offset+line.size()+1;
+        }
+        else if(!sdf && detail_::is_mol2_start(line))
+        {
+            if(begin!=std::string_view::npos)
+                rv.push_back(buffer.substr(begin,offset-begin));
+            begin=offset;
+        }
+    });
+    if(begin<buffer.size() &&
+       (!sdf || !detail_::trim(buffer.substr(begin)).empty()))
+        rv.push_back(buffer.substr(begin));
+    return rv;
+}
+
+Molecule parse_molecule_record(std::string_view record, MoleculeFormat format)
+{
+    detail_::AtomPrototypes prototypes;
+    return detail_::decode_molecule(record,format,prototypes);
+}
+
+std::vector<Molecule> parse_molecule_buffer(std::string_view buffer,
+                                            MoleculeFormat format,
+                                            size_t nthreads)
+{
+    const auto records=split_molecule_records(buffer,format);
+    nthreads=std::max<size_t>(
+                 std::min(detail_::resolve_nthreads(nthreads),
+                          buffer.size()/detail_::min_molecule_chunk),1);
+    std::vector<Molecule> rv(records.size());
+    std::vector<detail_::AtomPrototypes> prototypes(nthreads);
+    detail_::parallel_for(records.size(),nthreads,
+                          [&](size_t i, size_t thread){
+        rv[i]=detail_::decode_molecule(records[i],format,prototypes[thread]);
+    });
+    return rv;
+}
+
+std::vector<Molecule> parse_molecule_file(const std::string& path,
+                                          MoleculeFormat format,
+                                          size_t nthreads)
+{
+    const detail_::MappedFile file(path);
+    std::string buffer;
+    return parse_molecule_buffer(detail_::decompressed_contents(file.data(),
+                                                                buffer),
+                                 format,nthreads);
+}
+
+MoleculeStream::MoleculeStream(const std::string& path, MoleculeFormat format):
+    format_(format)
+{
+    detail_::ByteSource source=detail_::file_source(path);
+    if(detail_::is_gzip_file(path))
+        source=detail_::gzip_source(std::move(source));
+    reader_=std::make_unique<detail_::PipelinedLineReader>(std::move(source));
+}
+
+MoleculeStream::MoleculeStream(std::istream& is, MoleculeFormat format):
+    reader_(std::make_unique<detail_::PipelinedLineReader>(
+                [&is](char* buffer, size_t n){
+        is.read(buffer,n);
+        if(is.bad())throw std::runtime_error("Could not read stream");
+        return static_cast<size_t>(is.gcount());
+    })),
+    format_(format)
+{}
+
+bool MoleculeStream::next(Molecule& mol)
+{
+    if(done_)return false;
+    const bool sdf=(format_==MoleculeFormat::sdf);
+    std::string_view line;
+    while(reader_->next(line))
+    {
+        if(sdf && detail_::is_sdf_terminator(line))
+        {
+            mol=detail_::decode_sdf(record_,prototypes_);
+            record_.clear();
+            ++nrecords_;
+            return true;
+        }
+        if(!sdf && detail_::is_mol2_start(line) && !record_.empty())
+        {
+            mol=detail_::decode_mol2(record_,prototypes_);
+            record_.assign(line);
+            record_.push_back('\n');
+            ++nrecords_;
+            return true;
+        }
+        //MOL2 files may have comments before the first record
+        if(sdf || !record_.empty() || detail_::is_mol2_start(line))
+        {
+            record_.append(line);
+            record_.push_back('\n');
+        }
+    }
+    done_=true;
+    if(detail_::trim(record_).empty())return false;
+    mol=detail_::decode_molecule(record_,format_,prototypes_);
+    record_.clear();
+    ++nrecords_;
+    return true;
+}
+
+}//End namespace
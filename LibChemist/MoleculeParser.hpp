@@ -0,0 +1,212 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LibChemist/SetOfAtoms.hpp"
+#include "LibChemist/Span.hpp"
+#include "LibChemist/detail_/AtomPrototypes.hpp"
+#include "LibChemist/detail_/PipelinedLineReader.hpp"
+
+/** \file This file contains readers for the multi-molecule SDF and MOL2
+ *  formats screening libraries come in.
+ *
+ * Unlike the line-by-line parsers in SetOfAtomsParser.hpp, which gather every
+ * atom of a file into a single SetOfAtoms, these readers return one Molecule
+ * per record.  A record of an SDF file is a V2000 molfile followed by its data
+ * items and ends with a "$$$$" line.  A record of a MOL2 file starts with a
+ * "@<TRIPOS>MOLECULE" line and runs up to the next one.
+ *
+ * Libraries are read either a record at a time with MoleculeStream, so memory
+ * usage does not depend on the size of the library, or all at once with
+ * parse_molecule_buffer/parse_molecule_file, which decode the records in
+ * parallel.  Both find the record boundaries first and then hand each record
+ * to parse_molecule_record.
+ *
+ * Coordinates are converted from Angstroms to Bohr.  For SDF files the charge
+ * is the sum of the "M  CHG" entries, or of the atom block's charge codes if
+ * there are none, and the multiplicity counts the unpaired electrons of the
+ * "M  RAD" entries.  MOL2 files only have partial charges, the charge is
+ * their sum rounded to the nearest integer.
+ */
+
+namespace LibChemist {
+
+///The formats understood by the readers in this file
+enum class MoleculeFormat{sdf,mol2};
+
+/** \brief The bonds of a molecule in compressed sparse row (CSR) form.
+ *
+ *  The bonds of atom i are entries [offsets[i],offsets[i+1]) of neighbors and
+ *  orders, in the order they appear in the file.  Each bond is stored once
+ *  for each of its atoms.  Orders use the SDF codes: 1 to 3 for single to
+ *  triple bonds, 4 for aromatic bonds, and 5 to 8 for the query types.  MOL2
+ *  amide bonds are single bonds and other MOL2 types (dummy, unknown, not
+ *  connected) are 0.
+ */
+struct BondTable {
+    ///Where the bonds of each atom start, natoms+1 elements
+    std::vector<std::uint32_t> offsets;
+
+    ///The other atom of each bond
+    std::vector<std::uint32_t> neighbors;
+
+    ///The order of each bond
+    std::vector<std::uint8_t> orders;
+
+    ///Returns the number of bonds
+    size_t nbonds()const noexcept
+    {
+        return neighbors.size()/2;
+    }
+
+    ///Returns the atoms bonded to atom \p i, \p i assumed in range
+    Span<const std::uint32_t> neighbors_of(size_t i)const noexcept
+    {
+        return Span<const std::uint32_t>(neighbors.data()+offsets[i],
+                                         offsets[i+1]-offsets[i]);
+    }
+
+    ///Returns the orders of the bonds of atom \p i, \p i assumed in range
+    Span<const std::uint8_t> orders_of(size_t i)const noexcept
+    {
+        return Span<const std::uint8_t>(orders.data()+offsets[i],
+                                        offsets[i+1]-offsets[i]);
+    }
+
+    bool operator==(const BondTable& rhs)const noexcept
+    {
+        return offsets==rhs.offsets && neighbors==rhs.neighbors &&
+               orders==rhs.orders;
+    }
+
+    bool operator!=(const BondTable& rhs)const noexcept
+    {
+        return !((*this)==rhs);
+    }
+};
+
+///A record of an SDF or MOL2 file
+struct Molecule {
+    ///The name of the molecule, i.e. the first line of the record
+    std::string name;
+
+    ///The atoms, in file order
+    SetOfAtoms atoms;
+
+    ///The bonds between the atoms
+    BondTable bonds;
+
+    bool operator==(const Molecule& rhs)const noexcept
+    {
+        return name==rhs.name && atoms==rhs.atoms && bonds==rhs.bonds;
+    }
+
+    bool operator!=(const Molecule& rhs)const noexcept
+    {
+        return !((*this)==rhs);
+    }
+};
+
+/** \brief Splits the contents of an SDF or MOL2 file into its records.
+ *
+ *  \param[in] buffer The contents of the file.
+ *  \param[in] format The format of the file.
+ *  \returns Views into \p buffer, one per record.  For SDF files the "$$$$"
+ *           line is not part of the record.
+ */
+std::vector<std::string_view>
+split_molecule_records(std::string_view buffer, MoleculeFormat format);
+
+/** \brief Decodes a single record of an SDF or MOL2 file.
+ *
+ *  \param[in] record The record, e.g. as returned by split_molecule_records.
+ *  \param[in] format The format of the record.
+ *  \returns The molecule in the record.
+ *  \throws std::runtime_error if the record is malformed or truncated, or is a
+ *          V3000 molfile.
+ *  \throws std::out_of_range if an element symbol is not recognized.
+ */
+Molecule parse_molecule_record(std::string_view record, MoleculeFormat format);
+
+/** \brief Decodes all the records of an SDF or MOL2 file.
+ *
+ *  \param[in] buffer The contents of the file.
+ *  \param[in] format The format of the file.
+ *  \param[in] nthreads The number of threads to use, 0 means one per hardware
+ *                      thread.
+ *  \returns The molecules, in file order.
+ *  \throws Anything parse_molecule_record throws.
+ */
+std::vector<Molecule> parse_molecule_buffer(std::string_view buffer,
+                                            MoleculeFormat format,
+                                            size_t nthreads=0);
+
+/** \brief Decodes all the records of the SDF or MOL2 file at \p path.
+ *
+ *  The file is memory mapped, or decompressed into memory if it is
+ *  gzip-compressed, and then parsed by parse_molecule_buffer.
+ *
+ *  \throws std::runtime_error if the file can not be read, plus anything
+ *          parse_molecule_buffer throws.
+ */
+std::vector<Molecule> parse_molecule_file(const std::string& path,
+                                          MoleculeFormat format,
+                                          size_t nthreads=0);
+
+/** \brief Reads an SDF or MOL2 file one record at a time.
+ *
+ *  The file is read, and decompressed if it is gzip-compressed, on a separate
+ *  thread by a PipelinedLineReader, and only the record being decoded is held
+ *  in memory.
+ *
+ *  \code
+ *  MoleculeStream library("library.sdf.gz",MoleculeFormat::sdf);
+ *  Molecule mol;
+ *  while(library.next(mol))
+ *      screen(mol);
+ *  \endcode
+ */
+class MoleculeStream {
+public:
+    /** \brief Opens the SDF or MOL2 file at \p path.
+     *
+     *  \throws std::runtime_error if the file can not be opened.
+     */
+    MoleculeStream(const std::string& path, MoleculeFormat format);
+
+    /** \brief Reads the SDF or MOL2 file in \p is.
+     *
+     *  \p is must outlive this instance and may not be used by anything else
+     *  while this instance exists.
+     */
+    MoleculeStream(std::istream& is, MoleculeFormat format);
+
+    /** \brief Reads the next record.
+     *
+     *  \param[out] mol Overwritten with the molecule in the record.
+     *  \returns False if there are no more records.
+     *  \throws std::runtime_error if the file can not be read, plus anything
+     *          parse_molecule_record throws.
+     */
+    bool next(Molecule& mol);
+
+    ///Returns the number of records read so far
+    size_t nrecords()const noexcept
+    {
+        return nrecords_;
+    }
+
+private:
+    std::unique_ptr<detail_::PipelinedLineReader> reader_;
+    MoleculeFormat format_;
+    ///The lines of the record being assembled
+    std::string record_;
+    detail_::AtomPrototypes prototypes_;
+    size_t nrecords_=0;
+    bool done_=false;
+};
+
+}//End namespace
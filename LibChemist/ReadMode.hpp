@@ -0,0 +1,24 @@
+#pragma once
+
+namespace LibChemist {
+
+/** \brief How the path-based parsers get the contents of a file.
+ *
+ *  Either way gzip-compressed files are decompressed on the fly.
+ */
+enum class ReadMode {
+    /** The file is memory mapped and parsed in place.  Pages are read in as
+     *  the parser touches them, so the parser stalls whenever the data is not
+     *  cached yet.  This is the fastest option for local disks and files in
+     *  the page cache.
+     */
+    mapped,
+
+    /** A separate thread reads the file into a few fixed-size buffers, which
+     *  the parser consumes while the next ones are being read.  Reading and
+     *  parsing overlap, which pays off on slow or network-backed filesystems.
+     */
+    pipelined
+};
+
+}//End namespace LibChemist
@@ -1,4 +1,6 @@
 #include "LibChemist/SetOfAtoms.hpp"
+#include <stdexcept>
+
 namespace LibChemist {
 
 BasisSet get_general_basis(const std::string& name, const SetOfAtoms& atoms)
@@ -36,4 +38,22 @@ SetOfAtoms apply_basis_set(const std::string& name,
     return rv;
 }
 
+SetOfAtoms apply_ecp(const std::map<size_t,ECP>& ecps, const SetOfAtoms& atoms)
+{
+    SetOfAtoms rv(atoms);
+    for(Atom& ai:rv)
+    {
+        const size_t Z=ai.Z;
+        auto ecp=ecps.find(Z);
+        if(ecp==ecps.end())continue;
+        const double nelectrons=ai.nelectrons+ai.ecp.ncore;
+        if(nelectrons<ecp->second.ncore)
+            throw std::runtime_error("ECP replaces more electrons than the "
+                                     "atom has");
+        ai.nelectrons=nelectrons-ecp->second.ncore;
+        ai.ecp=ecp->second;
+    }
+    return rv;
+}
+
 }
@@ -35,7 +35,12 @@ namespace LibChemist {
  *    atoms.
  * 3. It does not make sense for SetOfAtoms to contain two copies of exactly the
  *    same atom (note same is not just the same place in space, but same basis,
- *    same mass, etc.)
+ *    same mass, etc.), so insert skips atoms that are already present.
+ * 4. Readers of file formats whose records are referred to by position, e.g.
+ *    the bonds of SDF and MOL2 files or the frames of a trajectory whose atom
+ *    count is fixed, must keep every record.  For them push_back appends
+ *    without de-duplicating, and the instance then holds exactly the atoms
+ *    of the file, duplicates included, in file order.
  *
  * Implementation details:
  *
@@ -114,7 +119,9 @@ public:
 
     /** \brief Returns the number of times \p atom is in the current instance.
      *
-     * \note This class is set-like so an atom may only be present at most once.
+     * \note This class is set-like so an atom inserted with insert is present
+     *       at most once.  Atoms appended with push_back may be present more
+     *       than once, in which case this still returns 1.
      *
      * \param[in] atom The Atom instance to look for.
      *
@@ -153,6 +160,63 @@ public:
         return *this;
     }
 
+    /** \brief Appends an atom, even if it is already present.
+     *
+     * Unlike insert this does not de-duplicate: \p atom always becomes the
+     * `this->size()`-th atom.  It is the order-preserving append the file
+     * readers use, where atom i has to be record i of the file (e.g. so bonds
+     * and frame atom counts stay right) even if two records are identical.
+     * It also avoids the linear search insert performs.
+     *
+     * \param[in] atom The atom to append.
+     * \returns The current instance with \p atom appended.
+     * \throws std::bad_alloc if memory allocation fails
+     */
+    SetOfAtoms& push_back(const Atom& atom)
+    {
+        atoms_.push_back(atom);
+        return *this;
+    }
+
+    /** \brief Appends an atom by moving it in.
+     *
+     * Same as the other overload, but \p atom's basis sets and ECP are moved
+     * rather than copied.
+     *
+     * \param[in] atom The atom to append.  It is left in a valid, but
+     *                 unspecified state.
+     * \returns The current instance with \p atom appended.
+     * \throws std::bad_alloc if memory allocation fails
+     */
+    SetOfAtoms& push_back(Atom&& atom)
+    {
+        atoms_.push_back(std::move(atom));
+        return *this;
+    }
+
+    /** \brief Removes all atoms from the current instance.
+     *
+     * The memory used to hold the atoms is kept so that refilling the instance
+     * does not need to allocate.  The charge and multiplicity are unchanged.
+     *
+     * \throws No throw guarantee.
+     */
+    void clear()noexcept
+    {
+        atoms_.clear();
+    }
+
+    /** \brief Allocates room for at least \p n atoms.
+     *
+     * \param[in] n The number of atoms to make room for.
+     * \throws std::bad_alloc if memory allocation fails.  Strong throw
+     * guarantee.
+     */
+    void reserve(size_t n)
+    {
+        atoms_.reserve(n);
+    }
+
     /** \brief Returns an atom for reading.
      *
      * \param[in] i The index of the requested atom.  \p i assumed in the range
@@ -244,6 +308,24 @@ SetOfAtoms apply_basis_set(const std::string& name,
                            const std::map<size_t,std::vector<BasisShell>>& bs,
                            const SetOfAtoms& atoms);
 
+/** \relates SetOfAtoms
+ *
+ * \brief Gives each atom in a SetOfAtoms the effective core potential for its
+ *        element.
+ *
+ * The core electrons of the ECP are removed from Atom::nelectrons, after
+ * adding back those of any ECP the atom already had.  Atoms whose atomic
+ * number is not in \p ecps are left alone.
+ *
+ * \param[in] ecps A map from atomic number to the ECP atoms with that Z get.
+ * \param[in] atoms The instance to apply the ECPs to.
+ * \returns A deep copy of \p atoms with \p ecps applied to it.
+ * \throws std::runtime_error if an ECP replaces more electrons than its atom
+ *         has.  Strong throw guarantee.
+ * \throws std::bad_alloc if memory allocation fails.  Strong throw guarantee.
+ */
+SetOfAtoms apply_ecp(const std::map<size_t,ECP>& ecps, const SetOfAtoms& atoms);
+
 /** \relates SetOfAtoms
  *  \brief Pulls the basis set off of a SetOfAtoms instances and places it
  *  in a more integrals-friendly container.  General contractions will be
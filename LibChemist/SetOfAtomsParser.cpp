@@ -1,7 +1,13 @@
 #include "LibChemist/SetOfAtomsParser.hpp"
-#include "LibChemist/lut/AtomicInfo.hpp"
+#include "LibChemist/detail_/AtomPrototypes.hpp"
+#include "LibChemist/detail_/GzipSource.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <array>
+#include <stdexcept>
+#include <string>
 
-#include <regex>
 namespace LibChemist {
 
 using action_type=SetOfAtomsFileParser::action_type;
@@ -14,115 +20,257 @@ struct atom {
     std::array<double,3> xyz;
 };
 
-void commit_atom(SetOfAtoms& rv, atom& a)
-{
-    if(a.Z!=0.0)
+//Handler used by parse_SetOfAtoms_file to assemble the atoms
+struct AtomBuilder: public SetOfAtomsFileHandler {
+    SetOfAtoms rv;
+    atom a;
+    AtomPrototypes prototypes;
+
+    void commit_atom()
     {
-        rv.insert(create_atom(a.xyz,a.Z));
+        if(a.Z!=0.0)
+        {
+            //Converting a negative double to size_t is undefined
+            if(!(a.Z>0.0))
+                throw std::out_of_range("Invalid atomic number: "+
+                                        std::to_string(a.Z));
+            rv.insert(prototypes.make(a.xyz,a.Z));
+        }
+        a=atom();
     }
-    a=atom();
+
+    //Returns the finished SetOfAtoms and readies the builder for another file
+    SetOfAtoms finish()
+    {
+        commit_atom();
+        SetOfAtoms result(std::move(rv));
+        rv=SetOfAtoms();
+        return result;
+    }
+
+    void on_new_atom()override{commit_atom();}
+    void on_atomic_number(double Z)override{a.Z=Z;}
+    void on_coordinate(size_t i, double value)override{a.xyz[i]=value;}
+    void on_charge(double charge)override{rv.charge=charge;}
+    void on_multiplicity(double mult)override{rv.multiplicity=mult;}
+};
+
+//Handler used to implement worth_parsing in terms of parse_line
+struct AtomActionProbe: public SetOfAtomsFileHandler {
+    action_type action=action_type::none;
+    void set(action_type a)
+    {
+        if(action==action_type::none)action=a;
+    }
+    void on_new_atom()override{set(action_type::new_atom);}
+    void on_atomic_number(double)override{set(action_type::same_atom);}
+    void on_coordinate(size_t, double)override{set(action_type::same_atom);}
+    void on_charge(double)override{set(action_type::overall_system);}
+    void on_multiplicity(double)override{set(action_type::overall_system);}
+};
+
+//Handler used to implement parse in terms of parse_line
+struct AtomMapBuilder: public SetOfAtomsFileHandler {
+    return_type rv;
+    void on_new_atom()override{}
+    void on_atomic_number(double Z)override
+    {
+        rv[data_type::AtNum].push_back(Z);
+    }
+    void on_coordinate(size_t i, double value)override
+    {
+        static const std::array<data_type,3> comps({data_type::x,data_type::y,
+                                                    data_type::z});
+        rv[comps[i]].push_back(value);
+    }
+    void on_charge(double charge)override
+    {
+        rv[data_type::charge].push_back(charge);
+    }
+    void on_multiplicity(double mult)override
+    {
+        rv[data_type::multiplicity].push_back(mult);
+    }
+};
+
+}//end namespace detail_
+
+action_type SetOfAtomsFileParser::worth_parsing(const std::string& line)const
+{
+    detail_::AtomActionProbe probe;
+    parse_line(line,probe);
+    return probe.action;
 }
 
-void parse(const return_type& data,atom& a)
+return_type SetOfAtomsFileParser::parse(const std::string& line)const
 {
-    if(data.count(data_type::AtNum))
-        a.Z=data.at(data_type::AtNum)[0];
-    if(data.count(data_type::x))
-        a.xyz[0]=data.at(data_type::x)[0];
-    if(data.count(data_type::y))
-        a.xyz[1]=data.at(data_type::y)[0];
-    if(data.count(data_type::z))
-        a.xyz[2]=data.at(data_type::z)[0];
+    detail_::AtomMapBuilder builder;
+    parse_line(line,builder);
+    return builder.rv;
 }
 
-}//end namespace detail_
+void MapSetOfAtomsFileParser::parse_line(std::string_view line,
+                                         SetOfAtomsFileHandler& handler)const
+{
+    const std::string temp(line);
+    const action_type action=worth_parsing(temp);
+    if(action==action_type::none)return;
+    const auto data=parse(temp);
+    if(action==action_type::new_atom)
+        handler.on_new_atom();
+    if(data.count(data_type::AtNum))
+        handler.on_atomic_number(data.at(data_type::AtNum)[0]);
+    const std::array<data_type,3> comps({data_type::x,data_type::y,
+                                         data_type::z});
+    for(size_t i=0;i<3;++i)
+        if(data.count(comps[i]))
+            handler.on_coordinate(i,data.at(comps[i])[0]);
+    if(data.count(data_type::charge))
+        handler.on_charge(data.at(data_type::charge)[0]);
+    if(data.count(data_type::multiplicity))
+        handler.on_multiplicity(data.at(data_type::multiplicity)[0]);
+}
 
 SetOfAtoms parse_SetOfAtoms_file(std::istream& is,
                                  const SetOfAtomsFileParser& parser)
 {
-    SetOfAtoms rv;
-    detail_::atom a;
-    while(is)
+    detail_::AtomBuilder builder;
+    detail_::for_each_stream_line(is,[&](std::string_view line){
+        parser.parse_line(line,builder);
+    });
+    return builder.finish();
+}
+
+SetOfAtoms parse_SetOfAtoms_file(const std::string& path,
+                                 const SetOfAtomsFileParser& parser,
+                                 ReadMode mode)
+{
+    detail_::AtomBuilder builder;
+    auto parse_line=[&](std::string_view line){
+        parser.parse_line(line,builder);
+    };
+    if(mode==ReadMode::pipelined)
+        detail_::for_each_pipelined_line(path,parse_line);
+    else
     {
-        std::string line;
-        std::getline(is,line);
-        switch(parser.worth_parsing(line))
-        {
-        case(action_type::none)://Junk line
-        {
-            break;
-        }
-        case(action_type::new_atom):
-        {
-            detail_::commit_atom(rv,a);
-            //Intentional fall_through
-        }
-        case(action_type::same_atom):
+        const detail_::MappedFile file(path);
+        detail_::for_each_file_line(file.data(),parse_line);
+    }
+    return builder.finish();
+}
+
+std::vector<SetOfAtoms>
+parse_SetOfAtoms_files(const std::vector<std::string>& paths,
+                       const SetOfAtomsFileParser& parser,
+                       std::vector<std::exception_ptr>& errors,
+                       size_t nthreads)
+{
+    std::vector<SetOfAtoms> rv(paths.size());
+    errors.assign(paths.size(),nullptr);
+    nthreads=std::min(detail_::resolve_nthreads(nthreads),
+                      std::max<size_t>(paths.size(),1));
+    //Each thread keeps its file buffer and atom cache from file to file
+    std::vector<std::string> buffers(nthreads);
+    std::vector<detail_::AtomBuilder> builders(nthreads);
+    detail_::parallel_for(paths.size(),nthreads,[&](size_t i, size_t thread){
+        detail_::AtomBuilder& builder=builders[thread];
+        try
         {
-            auto data=parser.parse(line);
-            detail_::parse(data,a);
-            break;
+            detail_::read_file(paths[i],buffers[thread]);
+            detail_::for_each_file_line(buffers[thread],
+                                        [&](std::string_view line){
+                parser.parse_line(line,builder);
+            });
+            rv[i]=builder.finish();
         }
-        default:
+        catch(...)
         {
-            auto data=parser.parse(line);
-            if(data.count(data_type::charge))
-                rv.charge=data.at(data_type::charge)[0];
-            if(data.count(data_type::multiplicity))
-                rv.multiplicity=data.at(data_type::multiplicity)[0];
-            break;
+            errors[i]=std::current_exception();
+            builder.rv=SetOfAtoms();
+            builder.a=detail_::atom();
         }
+    });
+    return rv;
+}
 
-        }
-    }
-    detail_::commit_atom(rv,a);
+std::vector<SetOfAtoms>
+parse_SetOfAtoms_files(const std::vector<std::string>& paths,
+                       const SetOfAtomsFileParser& parser, size_t nthreads)
+{
+    std::vector<std::exception_ptr> errors;
+    auto rv=parse_SetOfAtoms_files(paths,parser,errors,nthreads);
+    for(const auto& error: errors)
+        if(error)std::rethrow_exception(error);
     return rv;
 }
 
-//charge and multiplicity
-static const std::regex xyz_cm("^\\s*-?\\d+.?\\d*\\s*\\d+.?\\d*\\s*$");
-static const std::regex xyz_atom("^\\s*[a-zA-Z]+\\s*(?:\\d*.?\\d*\\s*){3}$");
+namespace detail_ {
+
+/* Single pass classification and extraction of an xyz line.  The lines we care
+ * about are of the form:
+ *
+ * - overall_system: "<charge> <multiplicity>"
+ * - new_atom:       "<symbol> <x> <y> <z>"
+ *
+ * For new_atom lines the symbol is returned in sym, the numbers on the line are
+ * returned in values.
+ */
+action_type scan_xyz(std::string_view line, std::string_view& sym,
+                     std::array<double,3>& values)
+{
+    size_t pos=0;
+    std::string_view token=next_token(line,pos);
+    if(token.empty())return action_type::none;
+    const bool is_atom=is_alpha(token);
+    if(is_atom)
+        sym=token;
+    else if(!to_double(token,values[0]))
+        return action_type::none;
+
+    const size_t nvalues=(is_atom?3:2);
+    for(size_t i=(is_atom?0:1);i<nvalues;++i)
+    {
+        token=next_token(line,pos);
+        if(token.empty() || !to_double(token,values[i]))
+            return action_type::none;
+    }
+    if(!next_token(line,pos).empty())return action_type::none;
+    return is_atom ? action_type::new_atom : action_type::overall_system;
+}
+
+}//End namespace detail_
 
 action_type XYZParser::worth_parsing(const std::string& line)const
 {
-    if(std::regex_search(line,xyz_cm))
-        return action_type::overall_system;
-    else if(std::regex_search(line,xyz_atom))
-        return action_type::new_atom;
-    return action_type::none;
+    std::string_view sym;
+    std::array<double,3> values;
+    return detail_::scan_xyz(line,sym,values);
 }
 
-return_type XYZParser::parse(const std::string &line) const
+void XYZParser::parse_line(std::string_view line,
+                           SetOfAtomsFileHandler& handler)const
 {
-    return_type rv;
-    std::stringstream tokenizer(line);
-    if(std::regex_search(line,xyz_cm))
+    std::string_view sym;
+    std::array<double,3> values;
+    switch(detail_::scan_xyz(line,sym,values))
     {
-        double temp;
-        tokenizer>>temp;
-        rv[data_type::charge].push_back(temp);
-        tokenizer>>temp;
-        rv[data_type::multiplicity].push_back(temp);
+    case(action_type::overall_system):
+    {
+        handler.on_charge(values[0]);
+        handler.on_multiplicity(values[1]);
+        break;
     }
-    else if(std::regex_search(line,xyz_atom))
+    case(action_type::new_atom):
     {
-        std::string sym;
-        tokenizer>>sym;
-        //First letter of atomic symbol
-        std::transform(sym.begin(),sym.begin()+1,sym.begin(), ::toupper);
-        //second plus letters
-        std::transform(sym.begin()+1,sym.end(),sym.begin()+1, ::tolower);
-        double temp=detail_::sym2Z_.at(sym);
-        rv[data_type::AtNum].push_back(temp);
-        tokenizer>>temp;
-        rv[data_type::x].push_back(temp);
-        tokenizer>>temp;
-        rv[data_type::y].push_back(temp);
-        tokenizer>>temp;
-        rv[data_type::z].push_back(temp);
+        handler.on_new_atom();
+        handler.on_atomic_number(detail_::symbol_to_Z(sym));
+        for(size_t i=0;i<3;++i)
+            handler.on_coordinate(i,values[i]);
+        break;
+    }
+    default:
+        break;
     }
-    return rv;
 }
 
-
 }
@@ -1,8 +1,11 @@
 #pragma once
+#include <exception>
 #include <string>
 #include <map>
 #include <vector>
 #include <istream>
+#include <string_view>
+#include "LibChemist/ReadMode.hpp"
 #include "LibChemist/SetOfAtoms.hpp"
 
 /** \file This file contains the machinery for parsing a string representation
@@ -27,20 +30,50 @@
  * - charge: the overall system charge
  * - multiplicity: the overall system multiplicity
  *
+ * As with the basis set parsers, returning an std::map for every line is
+ * expensive.  Parsers instead implement parse_line, which reports the
+ * contents of a line to a SetOfAtomsFileHandler via callbacks that mirror the
+ * actions and data types above.  worth_parsing and parse are available on
+ * every parser, implemented in terms of parse_line.  Parsers written against
+ * the map-based interface derive from MapSetOfAtomsFileParser, which
+ * implements parse_line in terms of them.
+ *
  * \TODO The following data pieces will be needed eventually, but have not been
  * coded up:
  * - q: the charge of a point charge
  * - point: a dummy atom
  * - ghost: a ghost atom
- * - UCSides: the sides of the unit cell
- * - UCAngles: the angles of the unit cell
- * - SpaceGroup: which space group the unit cell belongs to.
+ *
+ * The unit cell and space group of crystals are not data types either, the
+ * CIF reader in CrystalParser.hpp reads them and expands the cell.
  */
 
 
 namespace LibChemist {
 
 
+/** \brief The callbacks a SetOfAtomsFileParser fires while parsing a line.
+ */
+struct SetOfAtomsFileHandler
+{
+    virtual ~SetOfAtomsFileHandler()=default;
+
+    ///A new atom starts; subsequent atomic data is for that atom
+    virtual void on_new_atom()=0;
+
+    ///The atomic number of the current atom
+    virtual void on_atomic_number(double Z)=0;
+
+    ///Component \p i (0 is x, 1 is y, 2 is z) of the current atom's position
+    virtual void on_coordinate(size_t i, double value)=0;
+
+    ///The overall charge of the system
+    virtual void on_charge(double charge)=0;
+
+    ///The overall multiplicity of the system
+    virtual void on_multiplicity(double multiplicity)=0;
+};
+
 /** \brief This class abstracts away the layout of a string representation of a
  *  SetOfAtoms.
  *
@@ -51,9 +84,44 @@ struct SetOfAtomsFileParser
 {
     enum class action_type{none,new_atom,same_atom,overall_system};
     enum class data_type{AtNum,x,y,z,charge,multiplicity};
-    virtual action_type worth_parsing(const std::string& line)const=0;
+
+    virtual ~SetOfAtomsFileParser()=default;
+
+    /** \brief Classifies a line of the file.
+     *
+     *  The default implementation runs parse_line and inspects the callbacks
+     *  it fires.
+     */
+    virtual action_type worth_parsing(const std::string& line)const;
+
+    /** \brief Returns the data contained in a line of the file.
+     *
+     *  The default implementation collects the callbacks fired by parse_line.
+     */
     virtual std::map<data_type,std::vector<double>>
-    parse(const std::string& line)const=0;
+    parse(const std::string& line)const;
+
+    /** \brief Parses a line of the file, reporting its contents to \p handler.
+     *
+     *  \param[in] line The line to parse, without the trailing newline.
+     *  \param[in] handler The object receiving the line's contents.
+     */
+    virtual void parse_line(std::string_view line,
+                            SetOfAtomsFileHandler& handler)const=0;
+};
+
+/** \brief The base class of parsers written against the map-based interface.
+ *
+ *  As for MapBasisSetFileParser, parse_line calls worth_parsing and parse,
+ *  so new parsers should implement parse_line directly instead.
+ */
+struct MapSetOfAtomsFileParser: public SetOfAtomsFileParser
+{
+    action_type worth_parsing(const std::string& line)const override=0;
+    std::map<data_type,std::vector<double>>
+    parse(const std::string& line)const override=0;
+    void parse_line(std::string_view line,
+                    SetOfAtomsFileHandler& handler)const override;
 };
 
 /** \brief This class implements a SetOfAtomsParser for the xyz format.
@@ -62,8 +130,8 @@ struct SetOfAtomsFileParser
 struct XYZParser: public SetOfAtomsFileParser
 {
     action_type worth_parsing(const std::string& line)const override;
-    std::map<data_type, std::vector<double> >
-    parse(const std::string& line)const override;
+    void parse_line(std::string_view line,
+                    SetOfAtomsFileHandler& handler)const override;
 };
 
 /** \brief The function to call to parse a SetOfAtomsFile.
@@ -77,4 +145,64 @@ struct XYZParser: public SetOfAtomsFileParser
 SetOfAtoms parse_SetOfAtoms_file(std::istream& is,
                                  const SetOfAtomsFileParser& parser);
 
+/** \brief Parses the SetOfAtoms file at a given path.
+ *
+ * By default the file is memory mapped and the parser is handed views of the
+ * lines in the mapping, i.e. the lines are never copied.  This is the
+ * preferred way to parse a file that lives on disk.  On slow filesystems
+ * ReadMode::pipelined overlaps reading the file with parsing it.
+ *
+ * gzip-compressed files are detected by their magic bytes and decompressed on
+ * the fly, in bounded-size chunks, on a separate thread from the parsing.
+ *
+ * \param[in] path The path to the file.
+ * \param[in] parser The parser to be used to parse the file.
+ * \param[in] mode Whether to map the file or read it on a separate thread.
+ * \returns The SetOfAtoms instance represented in the file.
+ * \throws std::runtime_error if the file can not be opened, mapped, or read,
+ *         or is gzip-compressed and can not be decompressed (including when
+ *         the library was built without ENABLE_ZLIB).
+ */
+SetOfAtoms parse_SetOfAtoms_file(const std::string& path,
+                                 const SetOfAtomsFileParser& parser,
+                                 ReadMode mode=ReadMode::mapped);
+
+/** \brief Parses many small SetOfAtoms files at once.
+ *
+ * This is meant for loading large numbers of small files, e.g. the ligands of
+ * a virtual screen, where the time goes to the per-file overhead rather than
+ * to parsing.  The files are handed out to \p nthreads threads.  Each thread
+ * reads its files into a buffer it reuses from file to file, rather than
+ * mapping them, and caches the atoms it has made so that atomic data is only
+ * looked up once per element.
+ *
+ * A file that can not be read or parsed does not stop the others from being
+ * parsed.  Its SetOfAtoms is left empty and the exception is stored in
+ * \p errors instead.
+ *
+ * \param[in] paths The paths to the files.
+ * \param[in] parser The parser to be used to parse the files.  It is shared
+ *                   by the threads so parse_line must be thread safe, which
+ *                   is the case for the parsers in this file.
+ * \param[out] errors Set to one element per file, null if the file was parsed
+ *                    and the exception it raised otherwise.
+ * \param[in] nthreads The number of threads to use, 0 means one per hardware
+ *                     thread.
+ * \returns The SetOfAtoms in each file, in the same order as \p paths.
+ */
+std::vector<SetOfAtoms>
+parse_SetOfAtoms_files(const std::vector<std::string>& paths,
+                       const SetOfAtomsFileParser& parser,
+                       std::vector<std::exception_ptr>& errors,
+                       size_t nthreads=0);
+
+/** \brief Same as the other overload, but throws if any file fails.
+ *
+ * \throws The exception raised by the first file, in the order of \p paths,
+ *         that failed.  All files are attempted first.
+ */
+std::vector<SetOfAtoms>
+parse_SetOfAtoms_files(const std::vector<std::string>& paths,
+                       const SetOfAtomsFileParser& parser, size_t nthreads=0);
+
 }//End namespace
@@ -0,0 +1,68 @@
+#include "LibChemist/SetOfAtomsWriter.hpp"
+#include "LibChemist/detail_/TextWriting.hpp"
+#include "LibChemist/lut/AtomicInfo.hpp"
+
+namespace LibChemist {
+
+void append_xyz(const SetOfAtoms& atoms, std::string& buffer)
+{
+    detail_::append_integer(atoms.size(),buffer);
+    buffer.push_back('\n');
+    detail_::append_double(atoms.charge,buffer);
+    buffer.push_back(' ');
+    detail_::append_double(atoms.multiplicity,buffer);
+    buffer.push_back('\n');
+    for(const Atom& ai: atoms)
+    {
+        buffer.append(detail_::Z2sym_.at(static_cast<size_t>(ai.Z)));
+        for(double x: ai.coord)
+        {
+            buffer.push_back(' ');
+            detail_::append_double(x,buffer);
+        }
+        buffer.push_back('\n');
+    }
+}
+
+XYZWriter::XYZWriter(const std::string& path, bool append,
+                     size_t buffer_size):
+    file_(std::make_unique<detail_::FileWriter>(path,append)),
+    buffer_size_(buffer_size)
+{
+    buffer_.reserve(buffer_size);
+}
+
+XYZWriter::~XYZWriter()noexcept
+{
+    try{flush();}
+    catch(...){}
+}
+
+void XYZWriter::write(const SetOfAtoms& frame)
+{
+    const size_t size=buffer_.size();
+    try{append_xyz(frame,buffer_);}
+    catch(...)
+    {
+        //Don't leave half a frame behind
+        buffer_.resize(size);
+        throw;
+    }
+    ++nframes_;
+    if(buffer_.size()>=buffer_size_)flush();
+}
+
+void XYZWriter::flush()
+{
+    file_->write(buffer_);
+    buffer_.clear();
+}
+
+void write_xyz_file(const std::string& path, const SetOfAtoms& atoms)
+{
+    XYZWriter writer(path);
+    writer.write(atoms);
+    writer.flush();
+}
+
+}//End namespace
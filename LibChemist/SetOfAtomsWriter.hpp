@@ -0,0 +1,104 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "LibChemist/SetOfAtoms.hpp"
+
+/** \file This file contains the machinery for writing SetOfAtoms instances to
+ *  xyz files.
+ *
+ * Each SetOfAtoms is written as one frame in the layout the readers in
+ * XYZTrajectory.hpp expect:
+ *
+ * \verbatim
+   <number of atoms>
+   <charge> <multiplicity>
+   <symbol> <x> <y> <z>
+   ...
+   \endverbatim
+ *
+ * Coordinates are written as they are stored, i.e. in Bohr, which is what
+ * XYZParser reads them as.  Numbers are written in the shortest form that
+ * reads back to the same double, so parsing a written file (with
+ * parse_SetOfAtoms_file and XYZParser, or frame by frame with XYZTrajectory)
+ * gives back exactly the atoms that were written.  Only the atomic numbers,
+ * coordinates, charge, and multiplicity are written; the other properties of
+ * the atoms come back as create_atom makes them.
+ */
+
+namespace LibChemist {
+namespace detail_ {
+class FileWriter;
+}
+
+/** \brief Appends \p atoms to \p buffer as an xyz frame.
+ *
+ *  \param[in] atoms The atoms to format.
+ *  \param[in,out] buffer The string to append the frame to.
+ *  \throws std::out_of_range if an atom's atomic number has no symbol.
+ */
+void append_xyz(const SetOfAtoms& atoms, std::string& buffer);
+
+/** \brief Writes the frames of an xyz trajectory to a file.
+ *
+ *  Frames are formatted into an internal buffer, which is written to the file
+ *  with a single call whenever it reaches the buffer size, so writing many
+ *  small frames costs about one write call per buffer.  The buffer is also
+ *  written by flush and when the writer is destroyed.
+ */
+class XYZWriter {
+public:
+    /** \brief Opens \p path for writing.
+     *
+     *  \param[in] path The path to the trajectory.
+     *  \param[in] append If true frames are added to the end of an existing
+     *                    file, otherwise the file is overwritten.
+     *  \param[in] buffer_size How many bytes to collect before writing them.
+     *  \throws std::runtime_error if the file can not be opened.
+     */
+    explicit XYZWriter(const std::string& path, bool append=false,
+                       size_t buffer_size=1<<20);
+
+    /** \brief Writes what is still buffered.
+     *
+     *  Errors are swallowed; call flush first to find out about them.
+     */
+    ~XYZWriter()noexcept;
+
+    XYZWriter(const XYZWriter&)=delete;
+    XYZWriter& operator=(const XYZWriter&)=delete;
+
+    /** \brief Adds \p frame to the end of the trajectory.
+     *
+     *  \throws std::out_of_range if an atom's atomic number has no symbol.
+     *  \throws std::runtime_error if the buffer had to be written and that
+     *          failed.
+     */
+    void write(const SetOfAtoms& frame);
+
+    /** \brief Writes the buffered frames to the file.
+     *
+     *  \throws std::runtime_error if the write fails.
+     */
+    void flush();
+
+    ///Returns the number of frames written so far
+    size_t nframes()const noexcept
+    {
+        return nframes_;
+    }
+
+private:
+    std::unique_ptr<detail_::FileWriter> file_;
+    std::string buffer_;
+    size_t buffer_size_;
+    size_t nframes_=0;
+};
+
+/** \brief Writes \p atoms to the xyz file at \p path, overwriting it.
+ *
+ *  \throws std::runtime_error if the file can not be written.
+ *  \throws std::out_of_range if an atom's atomic number has no symbol.
+ */
+void write_xyz_file(const std::string& path, const SetOfAtoms& atoms);
+
+}//End namespace
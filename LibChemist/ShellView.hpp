@@ -0,0 +1,78 @@
+#pragma once
+#include "LibChemist/BasisShell.hpp"
+#include "LibChemist/Span.hpp"
+#include "LibChemist/Utilities.hpp"
+
+namespace LibChemist {
+
+/** \brief A non-owning view of one shell of a BasisSet.
+ *
+ *  The view points into the arrays of the BasisSet it came from, so making
+ *  one copies nothing and it is only valid until that BasisSet is changed or
+ *  goes away.  The exponents and coefficients are laid out as in BasisShell:
+ *  nprim exponents, and ngen rows of nprim coefficients.
+ */
+struct ShellView {
+    ///The x, y, and z coordinates (in a.u.) of the shell's center
+    const double* center=nullptr;
+
+    ///The type of the shell
+    ShellType type=ShellType::SphericalGaussian;
+
+    ///The angular momentum of the shell, negative for e.g. "sp" shells
+    int l=0;
+
+    ///The number of general contractions in this shell
+    size_t ngen=0;
+
+    ///The number of primitives in this shell
+    size_t nprim=0;
+
+    ///The nprim exponents of the primitives
+    Span<const double> alphas;
+
+    ///The ngen by nprim coefficients, stored row-major
+    Span<const double> coefs;
+
+    ///Returns the i-th exponent, i in the range [0,nprim)
+    double alpha(size_t i)const noexcept
+    {
+        return alphas[i];
+    }
+
+    /** \brief Returns the i-th coefficient of the j-th contraction
+     *
+     *  \param[in] i Which primitive, in the range [0,nprim).
+     *  \param[in] j Which contraction, in the range [0,ngen).
+     *  \throw No throw guarantee.
+     */
+    double coef(size_t i, size_t j)const noexcept
+    {
+        return coefs[j*nprim+i];
+    }
+
+    ///Returns the nprim coefficients of the j-th contraction
+    Span<const double> contraction(size_t j)const noexcept
+    {
+        return Span<const double>(coefs.data()+j*nprim,nprim);
+    }
+
+    /** \brief Returns the number of basis functions in the i-th contraction
+     *
+     *  As for BasisShell::nfunctions.
+     */
+    size_t nfunctions(size_t i)const noexcept
+    {
+        const size_t temp_l=am_2int(l,i);
+        if(type!=ShellType::CartesianGaussian)return 2*temp_l+1;
+        return multinomial_coefficient(3ul,temp_l);
+    }
+
+    ///Copies the shell out of the BasisSet
+    BasisShell to_shell()const
+    {
+        return BasisShell(type,l,ngen,alphas.to_vector(),coefs.to_vector());
+    }
+};
+
+}//End namespace LibChemist
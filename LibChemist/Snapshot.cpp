@@ -0,0 +1,583 @@
+#include "LibChemist/Snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace LibChemist {
+namespace detail_ {
+
+static_assert(sizeof(size_t)==sizeof(std::uint64_t),
+              "Snapshots assume size_t is 64-bit");
+
+//Layout of the snapshot's header, 64 bytes
+struct SnapshotHeader {
+    char magic[8];
+    std::uint64_t byte_order;
+    std::uint64_t version;
+    char kind[8];
+    std::uint64_t narrays;
+    std::uint64_t file_size;
+    std::uint64_t checksum;
+    std::uint64_t reserved;
+};
+
+//Layout of a directory entry, 64 bytes
+struct SnapshotEntry {
+    char name[32];
+    std::uint64_t type;
+    std::uint64_t elem_size;
+    std::uint64_t offset;
+    std::uint64_t n;
+};
+
+//Returns the name of a directory entry, which is only null terminated if short
+std::string_view entry_name(const SnapshotEntry& entry)
+{
+    return std::string_view(entry.name,strnlen(entry.name,sizeof(entry.name)));
+}
+
+constexpr char snapshot_magic[8]={'L','C','S','N','A','P','S','H'};
+constexpr std::uint64_t snapshot_byte_order=0x0102030405060708;
+constexpr std::uint64_t snapshot_version=1;
+constexpr size_t snapshot_alignment=64;
+
+//Rounds n up to the next multiple of snapshot_alignment
+size_t snapshot_pad(size_t n)
+{
+    return (n+snapshot_alignment-1)/snapshot_alignment*snapshot_alignment;
+}
+
+/* 64-bit FNV-1a, applied to whole words rather than bytes so that verifying a
+ * snapshot runs at close to memory bandwidth.  Data may be fed in pieces of
+ * any length, a trailing partial word is zero padded.
+ */
+class SnapshotChecksum {
+public:
+    void update(const char* data, size_t n)
+    {
+        while(n && npending_)
+        {
+            pending_[npending_++]=*data++;
+            --n;
+            if(npending_==8)flush();
+        }
+        for(;n>=8;data+=8,n-=8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word,data,8);
+            mix(word);
+        }
+        for(;n;--n)
+            pending_[npending_++]=*data++;
+    }
+
+    std::uint64_t value()
+    {
+        if(npending_)
+        {
+            std::fill(pending_+npending_,pending_+8,'\0');
+            flush();
+        }
+        return hash_;
+    }
+
+private:
+    void mix(std::uint64_t word)
+    {
+        hash_=(hash_^word)*0x100000001b3;
+    }
+
+    void flush()
+    {
+        std::uint64_t word;
+        std::memcpy(&word,pending_,8);
+        mix(word);
+        npending_=0;
+    }
+
+    std::uint64_t hash_=0xcbf29ce484222325;
+    char pending_[8];
+    size_t npending_=0;
+};
+
+//The arrays of a BasisSet are stored under prefix+<member name>
+void add_basis_set(SnapshotWriter& writer, const std::string& prefix,
+                   const BasisSet& bs)
+{
+    writer.add(prefix+"centers",bs.centers());
+    writer.add(prefix+"ngens",
+               reinterpret_cast<const std::uint64_t*>(bs.ngens().data()),
+               bs.ngens().size());
+    writer.add(prefix+"nprims",
+               reinterpret_cast<const std::uint64_t*>(bs.nprims().data()),
+               bs.nprims().size());
+    writer.add(prefix+"coefs",bs.coefs());
+    writer.add(prefix+"alphas",bs.alphas());
+    writer.add(prefix+"types",bs.types());
+    writer.add(prefix+"ls",bs.ls());
+}
+
+[[noreturn]] void bad_length(const char* what)
+{
+    throw std::runtime_error(std::string("Snapshot array ")+what+
+                             " has the wrong length");
+}
+
+//Throws unless the array called what has n elements
+void check_length(size_t length, size_t n, const char* what)
+{
+    if(length!=n)bad_length(what);
+}
+
+//Throws unless counts, times scale if given, add up to total
+void check_total(Span<const std::uint64_t> counts, size_t total,
+                 const char* what, Span<const std::uint64_t> scale={})
+{
+    size_t sum=0;
+    for(size_t i=0;i<counts.size();++i)
+    {
+        const size_t factor=(scale.empty() ? 1 : scale[i]);
+        if(factor && counts[i]>(total-sum)/factor)bad_length(what);
+        sum+=counts[i]*factor;
+    }
+    check_length(total,sum,what);
+}
+
+//Throws unless the arrays of bs describe the same shells
+void check_view(const BasisSetView& bs)
+{
+    const size_t n=bs.nshells();
+    if(bs.centers.size()%3 || bs.centers.size()/3!=n)bad_length("centers");
+    check_length(bs.ngens.size(),n,"ngens");
+    check_length(bs.nprims.size(),n,"nprims");
+    check_length(bs.types.size(),n,"types");
+    check_total(bs.nprims,bs.alphas.size(),"alphas");
+    check_total(bs.nprims,bs.coefs.size(),"coefs",bs.ngens);
+}
+
+//Throws unless the arrays of atoms describe the same atoms
+void check_view(const SetOfAtomsView& atoms)
+{
+    const size_t n=atoms.size();
+    check_length(atoms.isotope.size(),n,"isotope");
+    check_length(atoms.mass.size(),n,"mass");
+    check_length(atoms.isotope_mass.size(),n,"isotope_mass");
+    check_length(atoms.charges.size(),n,"charge");
+    check_length(atoms.multiplicities.size(),n,"multiplicity");
+    check_length(atoms.nelectrons.size(),n,"nelectrons");
+    check_length(atoms.cov_radius.size(),n,"cov_radius");
+    check_length(atoms.vdw_radius.size(),n,"vdw_radius");
+    if(atoms.coords.size()%3 || atoms.coords.size()/3!=n)bad_length("coords");
+    if(!atoms.ecp_ncore.empty())
+    {
+        check_length(atoms.ecp_ncore.size(),n,"ecp.ncore");
+        check_length(atoms.ecp_lmax.size(),n,"ecp.lmax");
+        check_length(atoms.ecp_noffsets.size(),n,"ecp.noffsets");
+        check_length(atoms.ecp_nterms.size(),n,"ecp.nterms");
+        check_total(atoms.ecp_noffsets,atoms.ecp_offsets.size(),
+                    "ecp.offsets");
+        check_total(atoms.ecp_nterms,atoms.ecp_powers.size(),"ecp.powers");
+        check_total(atoms.ecp_nterms,atoms.ecp_alphas.size(),"ecp.alphas");
+        check_total(atoms.ecp_nterms,atoms.ecp_coefs.size(),"ecp.coefs");
+    }
+    if(atoms.basis_sets.size()!=atoms.basis_names.size() ||
+       atoms.shells_per_atom.size()!=atoms.basis_names.size())
+        throw std::runtime_error("Snapshot basis sets are incomplete");
+    for(size_t k=0;k<atoms.basis_sets.size();++k)
+    {
+        check_view(atoms.basis_sets[k]);
+        check_length(atoms.shells_per_atom[k].size(),n,"nshells");
+        check_total(atoms.shells_per_atom[k],atoms.basis_sets[k].nshells(),
+                    "nshells");
+    }
+}
+
+BasisSetView basis_set_view(const Snapshot& snapshot, const std::string& prefix)
+{
+    BasisSetView rv;
+    rv.centers=snapshot.array<double>(prefix+"centers");
+    rv.ngens=snapshot.array<std::uint64_t>(prefix+"ngens");
+    rv.nprims=snapshot.array<std::uint64_t>(prefix+"nprims");
+    rv.coefs=snapshot.array<double>(prefix+"coefs");
+    rv.alphas=snapshot.array<double>(prefix+"alphas");
+    rv.types=snapshot.array<ShellType>(prefix+"types");
+    rv.ls=snapshot.array<int>(prefix+"ls");
+    check_view(rv);
+    return rv;
+}
+
+//Throws unless snapshot holds kind
+void check_kind(const Snapshot& snapshot, const std::string& kind)
+{
+    if(snapshot.kind()!=kind)
+        throw std::runtime_error("Expected a "+kind+" snapshot, got a "+
+                                 snapshot.kind()+" snapshot");
+}
+
+const std::string basis_set_kind("BASISSET");
+const std::string set_of_atoms_kind("ATOMS");
+
+}//End namespace detail_
+
+SnapshotWriter::SnapshotWriter(const std::string& kind):
+    kind_(kind)
+{
+    if(kind.size()>sizeof(detail_::SnapshotHeader::kind))
+        throw std::length_error("Snapshot kind is too long: "+kind);
+}
+
+void SnapshotWriter::add_(const std::string& name, std::uint64_t type,
+                          std::uint64_t elem_size, const char* data, size_t n)
+{
+    if(name.size()>=sizeof(detail_::SnapshotEntry::name))
+        throw std::length_error("Snapshot array name is too long: "+name);
+    entries_.push_back(Entry{name,type,elem_size,data,n});
+}
+
+void SnapshotWriter::write(const std::string& path)const
+{
+    using detail_::snapshot_pad;
+    detail_::SnapshotHeader header{};
+    std::memcpy(header.magic,detail_::snapshot_magic,sizeof(header.magic));
+    header.byte_order=detail_::snapshot_byte_order;
+    header.version=detail_::snapshot_version;
+    std::memcpy(header.kind,kind_.data(),kind_.size());
+    header.narrays=entries_.size();
+
+    std::vector<detail_::SnapshotEntry> directory(entries_.size());
+    size_t offset=snapshot_pad(sizeof(header)+
+                               directory.size()*sizeof(directory[0]));
+    for(size_t i=0;i<entries_.size();++i)
+    {
+        const Entry& entry=entries_[i];
+        std::memset(&directory[i],0,sizeof(directory[i]));
+        std::memcpy(directory[i].name,entry.name.data(),entry.name.size());
+        directory[i].type=entry.type;
+        directory[i].elem_size=entry.elem_size;
+        directory[i].offset=offset;
+        directory[i].n=entry.n;
+        offset=snapshot_pad(offset+entry.n*entry.elem_size);
+    }
+    header.file_size=offset;
+
+    //Everything after the header goes through the checksum
+    const char zeros[detail_::snapshot_alignment]={};
+    detail_::SnapshotChecksum checksum;
+    std::ofstream os(path,std::ios::binary|std::ios::trunc);
+    size_t written=sizeof(header);
+    auto put=[&](const char* data, size_t n){
+        os.write(data,n);
+        checksum.update(data,n);
+        written+=n;
+    };
+    os.write(reinterpret_cast<const char*>(&header),sizeof(header));
+    put(reinterpret_cast<const char*>(directory.data()),
+        directory.size()*sizeof(directory[0]));
+    for(size_t i=0;i<entries_.size();++i)
+    {
+        put(zeros,directory[i].offset-written);
+        put(entries_[i].data,entries_[i].n*entries_[i].elem_size);
+    }
+    put(zeros,header.file_size-written);
+
+    header.checksum=checksum.value();
+    os.seekp(0);
+    os.write(reinterpret_cast<const char*>(&header),sizeof(header));
+    if(!os)
+        throw std::runtime_error("Could not write snapshot: "+path);
+}
+
+Snapshot::Snapshot(const std::string& path, bool verify):
+    file_(path)
+{
+    const std::string_view buffer=file_.data();
+    detail_::SnapshotHeader header;
+    if(buffer.size()<sizeof(header))
+        throw std::runtime_error("Not a snapshot: "+path);
+    std::memcpy(&header,buffer.data(),sizeof(header));
+    if(std::memcmp(header.magic,detail_::snapshot_magic,sizeof(header.magic)))
+        throw std::runtime_error("Not a snapshot: "+path);
+    if(header.byte_order!=detail_::snapshot_byte_order)
+        throw std::runtime_error("Snapshot has the wrong byte order: "+path);
+    if(header.version!=detail_::snapshot_version)
+        throw std::runtime_error("Snapshot has format version "+
+                                 std::to_string(header.version)+", expected "+
+                                 std::to_string(detail_::snapshot_version)+
+                                 ": "+path);
+    //Sizes are checked by division, as a corrupt count could overflow
+    if(buffer.size()<header.file_size || header.file_size<sizeof(header) ||
+       header.narrays>(header.file_size-sizeof(header))/
+                      sizeof(detail_::SnapshotEntry))
+        throw std::runtime_error("Snapshot is truncated: "+path);
+    if(verify)
+    {
+        detail_::SnapshotChecksum checksum;
+        checksum.update(buffer.data()+sizeof(header),
+                        header.file_size-sizeof(header));
+        if(checksum.value()!=header.checksum)
+            throw std::runtime_error("Snapshot failed its checksum: "+path);
+    }
+    kind_.assign(header.kind,strnlen(header.kind,sizeof(header.kind)));
+    narrays_=header.narrays;
+    directory_=buffer.data()+sizeof(header);
+    for(size_t i=0;i<narrays_;++i)
+    {
+        detail_::SnapshotEntry entry;
+        std::memcpy(&entry,directory_+i*sizeof(entry),sizeof(entry));
+        if(entry.offset%detail_::snapshot_alignment ||
+           entry.offset>header.file_size || (entry.elem_size &&
+           entry.n>(header.file_size-entry.offset)/entry.elem_size))
+            throw std::runtime_error("Snapshot is corrupt: "+path);
+    }
+}
+
+bool Snapshot::count(const std::string& name)const noexcept
+{
+    for(size_t i=0;i<narrays_;++i)
+    {
+        detail_::SnapshotEntry entry;
+        std::memcpy(&entry,directory_+i*sizeof(entry),sizeof(entry));
+        if(name==detail_::entry_name(entry))return true;
+    }
+    return false;
+}
+
+void Snapshot::array_(const std::string& name, std::uint64_t type,
+                      std::uint64_t elem_size, const char*& data,
+                      size_t& n)const
+{
+    for(size_t i=0;i<narrays_;++i)
+    {
+        detail_::SnapshotEntry entry;
+        std::memcpy(&entry,directory_+i*sizeof(entry),sizeof(entry));
+        if(name!=detail_::entry_name(entry))continue;
+        if(entry.type!=type || entry.elem_size!=elem_size)
+            throw std::runtime_error("Snapshot array "+name+" does not hold "
+                                     "the requested type");
+        data=file_.data().data()+entry.offset;
+        n=entry.n;
+        return;
+    }
+    throw std::out_of_range("Snapshot has no array called "+name);
+}
+
+BasisSet BasisSetView::to_basis_set()const
+{
+    detail_::check_view(*this);
+    return BasisSet(centers.to_vector(),
+                    std::vector<size_t>(ngens.begin(),ngens.end()),
+                    std::vector<size_t>(nprims.begin(),nprims.end()),
+                    coefs.to_vector(),alphas.to_vector(),types.to_vector(),
+                    ls.to_vector());
+}
+
+SetOfAtoms SetOfAtomsView::to_set_of_atoms()const
+{
+    detail_::check_view(*this);
+    SetOfAtoms rv;
+    rv.charge=charge;
+    rv.multiplicity=multiplicity;
+    rv.reserve(size());
+    for(size_t i=0;i<size();++i)
+        rv.push_back(Atom({coords[3*i],coords[3*i+1],coords[3*i+2]},Z[i],
+                          isotope[i],mass[i],isotope_mass[i],charges[i],
+                          multiplicities[i],nelectrons[i],cov_radius[i],
+                          vdw_radius[i]));
+    size_t offset=0, term=0;
+    for(size_t i=0;i<ecp_ncore.size();++i)
+    {
+        ECP& ecp=rv[i].ecp;
+        ecp.ncore=ecp_ncore[i];
+        ecp.lmax=ecp_lmax[i];
+        const size_t noffsets=ecp_noffsets[i], nterms=ecp_nterms[i];
+        ecp.offsets.assign(ecp_offsets.begin()+offset,
+                           ecp_offsets.begin()+offset+noffsets);
+        ecp.powers.assign(ecp_powers.begin()+term,
+                          ecp_powers.begin()+term+nterms);
+        ecp.alphas.assign(ecp_alphas.begin()+term,
+                          ecp_alphas.begin()+term+nterms);
+        ecp.coefs.assign(ecp_coefs.begin()+term,
+                         ecp_coefs.begin()+term+nterms);
+        offset+=noffsets;
+        term+=nterms;
+    }
+    for(size_t k=0;k<basis_names.size();++k)
+    {
+        const BasisSetView& bs=basis_sets[k];
+        size_t shell=0, prim=0, coef=0;
+        for(size_t i=0;i<size();++i)
+        {
+            for(size_t j=0;j<shells_per_atom[k][i];++j,++shell)
+            {
+                const size_t nprim=bs.nprims[shell];
+                const size_t ncoef=nprim*bs.ngens[shell];
+                rv[i].add_shell(basis_names[k],
+                                BasisShell(bs.types[shell],bs.ls[shell],
+                                           bs.ngens[shell],
+                                           std::vector<double>(
+                                               bs.alphas.begin()+prim,
+                                               bs.alphas.begin()+prim+nprim),
+                                           std::vector<double>(
+                                               bs.coefs.begin()+coef,
+                                               bs.coefs.begin()+coef+ncoef)));
+                prim+=nprim;
+                coef+=ncoef;
+            }
+        }
+    }
+    return rv;
+}
+
+void save_snapshot(const std::string& path, const BasisSet& bs)
+{
+    SnapshotWriter writer(detail_::basis_set_kind);
+    detail_::add_basis_set(writer,"",bs);
+    writer.write(path);
+}
+
+void save_snapshot(const std::string& path, const SetOfAtoms& atoms)
+{
+    const size_t natoms=atoms.size();
+    const double system[2]={atoms.charge,atoms.multiplicity};
+    std::vector<double> Z(natoms),mass(natoms),isotope_mass(natoms),
+                        charges(natoms),multiplicities(natoms),
+                        nelectrons(natoms),cov_radius(natoms),
+                        vdw_radius(natoms),coords(3*natoms);
+    std::vector<std::uint64_t> isotope(natoms);
+    std::vector<std::uint64_t> ecp_ncore(natoms),ecp_noffsets(natoms),
+                               ecp_nterms(natoms),ecp_offsets;
+    std::vector<int> ecp_lmax(natoms),ecp_powers;
+    std::vector<double> ecp_alphas,ecp_coefs;
+    std::vector<std::string> basis_names;
+    for(size_t i=0;i<natoms;++i)
+    {
+        const Atom& ai=atoms[i];
+        Z[i]=ai.Z;
+        isotope[i]=ai.isotope;
+        mass[i]=ai.mass;
+        isotope_mass[i]=ai.isotope_mass;
+        charges[i]=ai.charge;
+        multiplicities[i]=ai.multiplicity;
+        nelectrons[i]=ai.nelectrons;
+        cov_radius[i]=ai.cov_radius;
+        vdw_radius[i]=ai.vdw_radius;
+        std::copy(ai.coord.begin(),ai.coord.end(),coords.begin()+3*i);
+        ecp_ncore[i]=ai.ecp.ncore;
+        ecp_lmax[i]=ai.ecp.lmax;
+        ecp_noffsets[i]=ai.ecp.offsets.size();
+        ecp_nterms[i]=ai.ecp.nterms();
+        ecp_offsets.insert(ecp_offsets.end(),ai.ecp.offsets.begin(),
+                           ai.ecp.offsets.end());
+        ecp_powers.insert(ecp_powers.end(),ai.ecp.powers.begin(),
+                          ai.ecp.powers.end());
+        ecp_alphas.insert(ecp_alphas.end(),ai.ecp.alphas.begin(),
+                          ai.ecp.alphas.end());
+        ecp_coefs.insert(ecp_coefs.end(),ai.ecp.coefs.begin(),
+                         ai.ecp.coefs.end());
+        for(const std::string& name: ai.basis_set_names())
+            if(std::find(basis_names.begin(),basis_names.end(),name)==
+               basis_names.end())
+                basis_names.push_back(name);
+    }
+    std::sort(basis_names.begin(),basis_names.end());
+
+    SnapshotWriter writer(detail_::set_of_atoms_kind);
+    writer.add("system",system,2);
+    writer.add("Z",Z);
+    writer.add("isotope",isotope);
+    writer.add("mass",mass);
+    writer.add("isotope_mass",isotope_mass);
+    writer.add("charge",charges);
+    writer.add("multiplicity",multiplicities);
+    writer.add("nelectrons",nelectrons);
+    writer.add("cov_radius",cov_radius);
+    writer.add("vdw_radius",vdw_radius);
+    writer.add("coords",coords);
+    writer.add("ecp.ncore",ecp_ncore);
+    writer.add("ecp.lmax",ecp_lmax);
+    writer.add("ecp.noffsets",ecp_noffsets);
+    writer.add("ecp.nterms",ecp_nterms);
+    writer.add("ecp.offsets",ecp_offsets);
+    writer.add("ecp.powers",ecp_powers);
+    writer.add("ecp.alphas",ecp_alphas);
+    writer.add("ecp.coefs",ecp_coefs);
+
+    //Basis set k goes under "basis<k>.", its name under "basis<k>.name"
+    std::vector<BasisSet> basis_sets(basis_names.size());
+    std::vector<std::vector<std::uint64_t>> nshells(basis_names.size());
+    for(size_t k=0;k<basis_names.size();++k)
+    {
+        const std::string prefix="basis"+std::to_string(k)+".";
+        basis_sets[k]=get_general_basis(basis_names[k],atoms);
+        for(const Atom& ai: atoms)
+            nshells[k].push_back(ai.nshells(basis_names[k]));
+        writer.add(prefix+"name",basis_names[k].data(),basis_names[k].size());
+        writer.add(prefix+"nshells",nshells[k]);
+        detail_::add_basis_set(writer,prefix,basis_sets[k]);
+    }
+    writer.write(path);
+}
+
+BasisSetView basis_set_view(const Snapshot& snapshot)
+{
+    detail_::check_kind(snapshot,detail_::basis_set_kind);
+    return detail_::basis_set_view(snapshot,"");
+}
+
+SetOfAtomsView set_of_atoms_view(const Snapshot& snapshot)
+{
+    detail_::check_kind(snapshot,detail_::set_of_atoms_kind);
+    SetOfAtomsView rv;
+    const auto system=snapshot.array<double>("system");
+    detail_::check_length(system.size(),2,"system");
+    rv.charge=system[0];
+    rv.multiplicity=system[1];
+    rv.Z=snapshot.array<double>("Z");
+    rv.isotope=snapshot.array<std::uint64_t>("isotope");
+    rv.mass=snapshot.array<double>("mass");
+    rv.isotope_mass=snapshot.array<double>("isotope_mass");
+    rv.charges=snapshot.array<double>("charge");
+    rv.multiplicities=snapshot.array<double>("multiplicity");
+    rv.nelectrons=snapshot.array<double>("nelectrons");
+    rv.cov_radius=snapshot.array<double>("cov_radius");
+    rv.vdw_radius=snapshot.array<double>("vdw_radius");
+    rv.coords=snapshot.array<double>("coords");
+    if(snapshot.count("ecp.ncore"))
+    {
+        rv.ecp_ncore=snapshot.array<std::uint64_t>("ecp.ncore");
+        rv.ecp_lmax=snapshot.array<int>("ecp.lmax");
+        rv.ecp_noffsets=snapshot.array<std::uint64_t>("ecp.noffsets");
+        rv.ecp_nterms=snapshot.array<std::uint64_t>("ecp.nterms");
+        rv.ecp_offsets=snapshot.array<std::uint64_t>("ecp.offsets");
+        rv.ecp_powers=snapshot.array<int>("ecp.powers");
+        rv.ecp_alphas=snapshot.array<double>("ecp.alphas");
+        rv.ecp_coefs=snapshot.array<double>("ecp.coefs");
+    }
+    for(size_t k=0;;++k)
+    {
+        const std::string prefix="basis"+std::to_string(k)+".";
+        if(!snapshot.count(prefix+"name"))break;
+        const auto name=snapshot.array<char>(prefix+"name");
+        rv.basis_names.emplace_back(name.begin(),name.end());
+        rv.shells_per_atom.push_back(
+                snapshot.array<std::uint64_t>(prefix+"nshells"));
+        rv.basis_sets.push_back(detail_::basis_set_view(snapshot,prefix));
+    }
+    detail_::check_view(rv);
+    return rv;
+}
+
+BasisSet load_basis_set_snapshot(const std::string& path)
+{
+    const Snapshot snapshot(path);
+    return basis_set_view(snapshot).to_basis_set();
+}
+
+SetOfAtoms load_set_of_atoms_snapshot(const std::string& path)
+{
+    const Snapshot snapshot(path);
+    return set_of_atoms_view(snapshot).to_set_of_atoms();
+}
+
+}//End namespace
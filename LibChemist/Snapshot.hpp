@@ -0,0 +1,290 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LibChemist/SetOfAtoms.hpp"
+#include "LibChemist/Span.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+
+/** \file This file contains the machinery for binary snapshots.
+ *
+ * A snapshot is a binary file holding a named collection of flat arrays, e.g.
+ * the arrays of a BasisSet.  It is meant for checkpointing and for handing
+ * data to other processes, where writing and re-parsing text is wasteful.
+ * Loading a snapshot maps the file, after which the arrays are used in place,
+ * i.e. they are never copied unless the caller asks for it.
+ *
+ * All integers in a snapshot are 64-bit and in native byte order.  The layout
+ * is:
+ *
+ * \verbatim
+   header:    magic "LCSNAPSH", byte order tag, format version, an 8 character
+              kind (e.g. "BASISSET"), number of arrays, total file size, and
+              a checksum of everything after the header
+   directory: per array: a 32 character name, element type, element size,
+              byte offset from the start of the file and number of elements
+   arrays:    the data of each array, each starting on a 64 byte boundary
+   \endverbatim
+ *
+ * The byte order tag and element sizes guard against reading a snapshot on a
+ * machine with a different data layout than the one that wrote it.
+ */
+
+namespace LibChemist {
+namespace detail_ {
+
+///Maps the element types a snapshot may hold to the tag stored for them
+template<typename T> struct SnapshotType;
+template<> struct SnapshotType<char> {static constexpr std::uint64_t value=1;};
+template<> struct SnapshotType<int> {static constexpr std::uint64_t value=2;};
+template<> struct SnapshotType<std::uint64_t>
+{static constexpr std::uint64_t value=3;};
+template<> struct SnapshotType<double>
+{static constexpr std::uint64_t value=4;};
+template<> struct SnapshotType<ShellType>
+{static constexpr std::uint64_t value=5;};
+
+}//End namespace detail_
+
+/** \brief Collects arrays and writes them to a snapshot.
+ *
+ *  The writer does not copy the arrays, they must stay alive until write is
+ *  called.
+ */
+class SnapshotWriter {
+public:
+    /** \brief Makes a writer for a snapshot of the given kind.
+     *
+     *  \param[in] kind What the snapshot holds, at most 8 characters.
+     *  \throws std::length_error if \p kind is too long.
+     */
+    explicit SnapshotWriter(const std::string& kind);
+
+    /** \brief Adds the \p n elements starting at \p data as array \p name.
+     *
+     *  \param[in] name The name of the array, at most 31 characters.
+     *  \throws std::length_error if \p name is too long.
+     */
+    template<typename T>
+    void add(const std::string& name, const T* data, size_t n)
+    {
+        add_(name,detail_::SnapshotType<T>::value,sizeof(T),
+             reinterpret_cast<const char*>(data),n);
+    }
+
+    ///Adds the elements of \p data as array \p name
+    template<typename T>
+    void add(const std::string& name, const std::vector<T>& data)
+    {
+        add(name,data.data(),data.size());
+    }
+
+    /** \brief Writes the snapshot to \p path.
+     *
+     *  \throws std::runtime_error if \p path can not be written.
+     */
+    void write(const std::string& path)const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::uint64_t type;
+        std::uint64_t elem_size;
+        const char* data;
+        size_t n;
+    };
+
+    void add_(const std::string& name, std::uint64_t type,
+              std::uint64_t elem_size, const char* data, size_t n);
+
+    std::string kind_;
+    std::vector<Entry> entries_;
+};
+
+/** \brief A memory-mapped snapshot.
+ *
+ *  The arrays returned by an instance are views of the mapping and are only
+ *  valid for the lifetime of the instance.
+ */
+class Snapshot {
+public:
+    /** \brief Maps the snapshot at \p path.
+     *
+     *  \param[in] path The path to the snapshot.
+     *  \param[in] verify If true the checksum is verified, which means reading
+     *                    the entire file.  Skipping it keeps the cost of
+     *                    loading proportional to the data actually used.
+     *  \throws std::runtime_error if the file can not be mapped, is not a
+     *          snapshot, was written with a different byte order or format
+     *          version, is truncated, or fails the checksum.
+     */
+    explicit Snapshot(const std::string& path, bool verify=true);
+
+    ///Returns what the snapshot holds, e.g. "BASISSET"
+    const std::string& kind()const noexcept
+    {
+        return kind_;
+    }
+
+    ///Returns true if the snapshot has an array called \p name
+    bool count(const std::string& name)const noexcept;
+
+    /** \brief Returns the array called \p name.
+     *
+     *  \throws std::out_of_range if there is no such array.
+     *  \throws std::runtime_error if the array does not hold elements of type
+     *          T.
+     */
+    template<typename T>
+    Span<const T> array(const std::string& name)const
+    {
+        const char* data;
+        size_t n;
+        array_(name,detail_::SnapshotType<T>::value,sizeof(T),data,n);
+        return Span<const T>(reinterpret_cast<const T*>(data),n);
+    }
+
+private:
+    void array_(const std::string& name, std::uint64_t type,
+                std::uint64_t elem_size, const char*& data, size_t& n)const;
+
+    ///The mapped snapshot
+    detail_::MappedFile file_;
+
+    ///What the snapshot holds
+    std::string kind_;
+
+    ///The number of arrays and the start of the directory
+    size_t narrays_=0;
+    const char* directory_=nullptr;
+};
+
+/** \brief The arrays of a BasisSet, viewed in place.
+ *
+ *  The members have the same meaning as the arrays of BasisSet.
+ */
+struct BasisSetView {
+    Span<const double> centers;
+    Span<const std::uint64_t> ngens;
+    Span<const std::uint64_t> nprims;
+    Span<const double> coefs;
+    Span<const double> alphas;
+    Span<const ShellType> types;
+    Span<const int> ls;
+
+    ///Returns the number of shells
+    size_t nshells()const noexcept
+    {
+        return ls.size();
+    }
+
+    /** \brief Copies the arrays into a BasisSet.
+     *
+     *  \throws std::runtime_error if the lengths of the arrays do not agree.
+     *  \throws std::bad_alloc if memory allocation fails.
+     */
+    BasisSet to_basis_set()const;
+};
+
+/** \brief The atoms of a SetOfAtoms, viewed in place.
+ *
+ *  Each property of the atoms is a separate array with one element per atom,
+ *  except for coords which is natoms by 3 in row-major form.  Each basis set
+ *  applied to the atoms is stored as the BasisSet get_general_basis would
+ *  return, along with the number of shells each atom contributes to it.  The
+ *  ECPs are stored the same way, as their concatenated arrays plus the length
+ *  of each atom's piece.  They are empty for snapshots older than ECPs.
+ */
+struct SetOfAtomsView {
+    double charge=0.0;///<The charge of the system
+    double multiplicity=1.0;///<The multiplicity of the system
+
+    Span<const double> Z;
+    Span<const std::uint64_t> isotope;
+    Span<const double> mass;
+    Span<const double> isotope_mass;
+    Span<const double> charges;
+    Span<const double> multiplicities;
+    Span<const double> nelectrons;
+    Span<const double> cov_radius;
+    Span<const double> vdw_radius;
+    Span<const double> coords;
+
+    ///The names of the basis sets, sorted
+    std::vector<std::string> basis_names;
+
+    ///The basis sets, in the same order as basis_names
+    std::vector<BasisSetView> basis_sets;
+
+    ///For each basis set, how many shells each atom has in it
+    std::vector<Span<const std::uint64_t>> shells_per_atom;
+
+    ///Each atom's ECP::ncore and ECP::lmax
+    Span<const std::uint64_t> ecp_ncore;
+    Span<const int> ecp_lmax;
+
+    ///How many offsets and terms each atom's ECP has
+    Span<const std::uint64_t> ecp_noffsets;
+    Span<const std::uint64_t> ecp_nterms;
+
+    ///The arrays of the atoms' ECPs, back to back in the order of the atoms
+    Span<const std::uint64_t> ecp_offsets;
+    Span<const int> ecp_powers;
+    Span<const double> ecp_alphas;
+    Span<const double> ecp_coefs;
+
+    ///Returns the number of atoms
+    size_t size()const noexcept
+    {
+        return Z.size();
+    }
+
+    /** \brief Rebuilds the SetOfAtoms, including its basis sets.
+     *
+     *  \throws std::runtime_error if the lengths of the arrays do not agree.
+     *  \throws std::bad_alloc if memory allocation fails.
+     */
+    SetOfAtoms to_set_of_atoms()const;
+};
+
+/** \brief Writes a snapshot of a BasisSet.
+ *
+ *  \throws std::runtime_error if \p path can not be written.
+ */
+void save_snapshot(const std::string& path, const BasisSet& bs);
+
+/** \brief Writes a snapshot of a SetOfAtoms, including its basis sets.
+ *
+ *  \throws std::runtime_error if \p path can not be written.
+ */
+void save_snapshot(const std::string& path, const SetOfAtoms& atoms);
+
+/** \brief Views the BasisSet in a snapshot.
+ *
+ *  \throws std::runtime_error if \p snapshot does not hold a BasisSet, or
+ *          the lengths of its arrays do not agree.
+ */
+BasisSetView basis_set_view(const Snapshot& snapshot);
+
+/** \brief Views the SetOfAtoms in a snapshot.
+ *
+ *  \throws std::runtime_error if \p snapshot does not hold a SetOfAtoms, or
+ *          the lengths of its arrays do not agree.
+ */
+SetOfAtomsView set_of_atoms_view(const Snapshot& snapshot);
+
+/** \brief Loads a copy of the BasisSet in the snapshot at \p path.
+ *
+ *  \throws std::runtime_error if the snapshot can not be loaded or does not
+ *          hold a BasisSet.
+ */
+BasisSet load_basis_set_snapshot(const std::string& path);
+
+/** \brief Loads a copy of the SetOfAtoms in the snapshot at \p path.
+ *
+ *  \throws std::runtime_error if the snapshot can not be loaded or does not
+ *          hold a SetOfAtoms.
+ */
+SetOfAtoms load_set_of_atoms_snapshot(const std::string& path);
+
+}//End namespace
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace LibChemist {
+
+/** \brief A non-owning view of a contiguous array.
+ *
+ *  This is used to hand out arrays that live somewhere we do not want to copy
+ *  them from, e.g. a memory-mapped file.  A Span is only valid as long as the
+ *  memory it refers to.
+ *
+ *  \tparam T The type of the elements, typically const qualified.
+ */
+template<typename T>
+class Span {
+public:
+    using value_type=T;
+    using iterator=T*;
+    using const_iterator=T*;
+
+    ///Makes an empty span
+    Span()noexcept=default;
+
+    ///Makes a span of the \p n elements starting at \p data
+    Span(T* data, size_t n)noexcept:
+        data_(data),size_(n)
+    {}
+
+    ///Makes a span of the elements of \p v
+    template<typename U>
+    Span(const std::vector<U>& v)noexcept:
+        data_(v.data()),size_(v.size())
+    {}
+
+    ///Returns a pointer to the first element
+    T* data()const noexcept
+    {
+        return data_;
+    }
+
+    ///Returns the number of elements
+    size_t size()const noexcept
+    {
+        return size_;
+    }
+
+    ///Returns true if there are no elements
+    bool empty()const noexcept
+    {
+        return !size_;
+    }
+
+    ///Returns element \p i, \p i assumed in the range [0,size())
+    T& operator[](size_t i)const noexcept
+    {
+        return data_[i];
+    }
+
+    iterator begin()const noexcept
+    {
+        return data_;
+    }
+
+    iterator end()const noexcept
+    {
+        return data_+size_;
+    }
+
+    ///Copies the elements into a vector
+    std::vector<std::remove_const_t<T>> to_vector()const
+    {
+        return std::vector<std::remove_const_t<T>>(begin(),end());
+    }
+
+private:
+    T* data_=nullptr;
+    size_t size_=0;
+};
+
+///Returns true if \p lhs and \p rhs hold the same elements
+template<typename T, typename U>
+bool operator==(const Span<T>& lhs, const std::vector<U>& rhs)noexcept
+{
+    if(lhs.size()!=rhs.size())return false;
+    for(size_t i=0;i<lhs.size();++i)
+        if(!(lhs[i]==rhs[i]))return false;
+    return true;
+}
+
+}//End namespace
@@ -0,0 +1,416 @@
+#include "LibChemist/XYZTrajectory.hpp"
+#include "LibChemist/SetOfAtomsParser.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LibChemist {
+namespace detail_ {
+
+//Handler that appends the atoms of a frame to a SetOfAtoms
+struct FrameBuilder: public SetOfAtomsFileHandler {
+    SetOfAtoms& frame;
+    size_t natoms=0;
+    double Z=0.0;
+    std::array<double,3> xyz{};
+
+    explicit FrameBuilder(SetOfAtoms& frame_):
+        frame(frame_)
+    {}
+
+    void commit_atom()
+    {
+        if(Z!=0.0)
+        {
+            frame.push_back(create_atom(xyz,Z));
+            ++natoms;
+        }
+        Z=0.0;
+    }
+
+    void on_new_atom()override{commit_atom();}
+    void on_atomic_number(double Z_)override{Z=Z_;}
+    void on_coordinate(size_t i, double value)override{xyz[i]=value;}
+    void on_charge(double charge)override{frame.charge=charge;}
+    void on_multiplicity(double mult)override{frame.multiplicity=mult;}
+};
+
+//Returns the number of atoms in the frame if line is a frame header
+bool frame_size(std::string_view line, size_t& natoms)
+{
+    size_t pos=0;
+    double n;
+    bool is_int;
+    const std::string_view token=next_token(line,pos);
+    if(!to_double(token,n,is_int) || !is_int || n<0 ||
+       !next_token(line,pos).empty())
+        return false;
+    natoms=n;
+    return true;
+}
+
+//True if the line is nothing but whitespace
+bool is_blank(std::string_view line)
+{
+    size_t pos=0;
+    return next_token(line,pos).empty();
+}
+
+/* Reads one frame, pulling lines from next_line, which should be a callable
+ * that sets its argument to the next line and returns false at the end of
+ * the input.  iframe is only used for error messages.  Returns false if there
+ * are no more frames.
+ */
+template<typename line_source>
+bool read_xyz_frame(line_source&& next_line, SetOfAtoms& frame, size_t iframe)
+{
+    static const XYZParser parser;
+    std::string_view line;
+
+    //Skip to the header of the next frame
+    bool found=false;
+    while(next_line(line))
+    {
+        if(!is_blank(line))
+        {
+            found=true;
+            break;
+        }
+    }
+    if(!found)return false;
+
+    size_t natoms;
+    if(!frame_size(line,natoms))
+        throw std::runtime_error("Expected the number of atoms in xyz frame "+
+                                 std::to_string(iframe)+", got: "+
+                                 std::string(line));
+    if(!next_line(line))
+        throw std::runtime_error("xyz frame "+std::to_string(iframe)+
+                                 " is missing its comment line");
+
+    frame.clear();
+    frame.reserve(natoms);
+    frame.charge=0.0;
+    frame.multiplicity=1.0;
+    FrameBuilder builder(frame);
+    parser.parse_line(line,builder);
+    builder.Z=0.0;//Comment lines never contribute an atom
+    for(size_t i=0;i<natoms;++i)
+    {
+        if(!next_line(line))
+            throw std::runtime_error("xyz frame "+std::to_string(iframe)+
+                                     " ends after "+std::to_string(i)+
+                                     " of its "+std::to_string(natoms)+
+                                     " atoms");
+        parser.parse_line(line,builder);
+        builder.commit_atom();
+        if(builder.natoms!=i+1)
+            throw std::runtime_error("Expected an atom in xyz frame "+
+                                     std::to_string(iframe)+", got: "+
+                                     std::string(line));
+    }
+    return true;
+}
+
+//Line source over an in-memory buffer, starting at offset
+struct BufferLines {
+    std::string_view buffer;
+    size_t offset;
+
+    bool operator()(std::string_view& line)
+    {
+        if(offset>=buffer.size())return false;
+        size_t eol=buffer.find('\n',offset);
+        if(eol==std::string_view::npos)eol=buffer.size();
+        line=buffer.substr(offset,eol-offset);
+        offset=eol+1;
+        return true;
+    }
+};
+
+//Scans buffer for the start of each frame, see index_xyz_trajectory
+std::vector<size_t> index_xyz_buffer(std::string_view buffer)
+{
+    std::vector<size_t> offsets;
+    BufferLines lines{buffer,0};
+    std::string_view line;
+    size_t end=0;
+    while(true)
+    {
+        const size_t start=lines.offset;
+        if(!lines(line))break;
+        if(is_blank(line))continue;
+        size_t natoms;
+        if(!frame_size(line,natoms))
+            throw std::runtime_error("Expected the number of atoms in xyz "
+                                     "frame "+std::to_string(offsets.size())+
+                                     ", got: "+std::string(line));
+        offsets.push_back(start);
+        //Skip the comment and atom lines without looking at them
+        for(size_t i=0;i<natoms+1;++i)
+            if(!lines(line))
+                throw std::runtime_error("xyz frame "+
+                                         std::to_string(offsets.size()-1)+
+                                         " is truncated");
+        end=std::min(lines.offset,buffer.size());
+    }
+    offsets.push_back(end);
+    return offsets;
+}
+
+/* If a complete frame, i.e. its header, comment, and atom lines each ended by
+ * a newline, starts at or after begin in buffer, sets begin to where it starts
+ * and end to one past its last newline and returns true.  Otherwise begin is
+ * moved past any complete blank lines and false is returned.  iframe is only
+ * used for error messages.
+ */
+bool complete_xyz_frame(std::string_view buffer, size_t& begin, size_t& end,
+                        size_t iframe)
+{
+    while(true)
+    {
+        const size_t nl=buffer.find('\n',begin);
+        if(nl==std::string_view::npos)return false;
+        const std::string_view line=buffer.substr(begin,nl-begin);
+        if(is_blank(line))
+        {
+            begin=nl+1;
+            continue;
+        }
+        size_t natoms;
+        if(!frame_size(line,natoms))
+            throw std::runtime_error("Expected the number of atoms in xyz "
+                                     "frame "+std::to_string(iframe)+
+                                     ", got: "+std::string(line));
+        end=nl+1;
+        for(size_t i=0;i<natoms+1;++i)
+        {
+            const size_t next_nl=buffer.find('\n',end);
+            if(next_nl==std::string_view::npos)return false;
+            end=next_nl+1;
+        }
+        return true;
+    }
+}
+
+//Layout of the sidecar's header
+struct XYZIndexHeader {
+    char magic[8];
+    std::uint64_t version;
+    std::uint64_t file_size;
+    std::uint64_t mtime;
+    std::uint64_t nframes;
+};
+
+constexpr char xyz_index_magic[8]={'L','C','X','Y','Z','I','D','X'};
+constexpr std::uint64_t xyz_index_version=2;
+
+//The modification time of the file at path in ns, or 0 if it can't be found
+std::uint64_t xyz_file_mtime(const std::string& path)noexcept
+{
+    struct stat info;
+    if(::stat(path.c_str(),&info))return 0;
+    return static_cast<std::uint64_t>(info.st_mtim.tv_sec)*1000000000u+
+           info.st_mtim.tv_nsec;
+}
+
+//Same as load_xyz_index, but for a trajectory whose size we know
+bool load_xyz_index(const std::string& path, size_t file_size,
+                    std::vector<size_t>& offsets)noexcept
+{
+    try
+    {
+        std::ifstream is(xyz_index_path(path),std::ios::binary);
+        XYZIndexHeader header;
+        if(!is.read(reinterpret_cast<char*>(&header),sizeof(header)))
+            return false;
+        if(std::memcmp(header.magic,xyz_index_magic,sizeof(header.magic)) ||
+           header.version!=xyz_index_version || header.file_size!=file_size ||
+           header.mtime!=xyz_file_mtime(path))
+            return false;
+        //Every frame takes up at least one byte
+        if(header.nframes>file_size)return false;
+        std::vector<std::uint64_t> buffer(header.nframes+1);
+        if(!is.read(reinterpret_cast<char*>(buffer.data()),
+                    buffer.size()*sizeof(std::uint64_t)))
+            return false;
+        for(size_t i=1;i<buffer.size();++i)
+            if(buffer[i]<=buffer[i-1])return false;
+        if(buffer.back()>file_size)return false;
+        offsets.assign(buffer.begin(),buffer.end());
+        return true;
+    }
+    catch(...)
+    {
+        return false;
+    }
+}
+
+//Same as save_xyz_index, but for a trajectory whose size we know
+void save_xyz_index(const std::string& path, size_t file_size,
+                    const std::vector<size_t>& offsets)
+{
+    XYZIndexHeader header;
+    std::memcpy(header.magic,xyz_index_magic,sizeof(header.magic));
+    header.version=xyz_index_version;
+    header.file_size=file_size;
+    header.mtime=xyz_file_mtime(path);
+    header.nframes=offsets.size()-1;
+    const std::vector<std::uint64_t> buffer(offsets.begin(),offsets.end());
+    const std::string index_path=xyz_index_path(path);
+    std::ofstream os(index_path,std::ios::binary|std::ios::trunc);
+    os.write(reinterpret_cast<const char*>(&header),sizeof(header));
+    os.write(reinterpret_cast<const char*>(buffer.data()),
+             buffer.size()*sizeof(std::uint64_t));
+    if(!os)
+        throw std::runtime_error("Could not write xyz index: "+index_path);
+}
+
+}//End namespace detail_
+
+bool XYZTrajectory::next(SetOfAtoms& frame)
+{
+    auto next_line=[this](std::string_view& line){
+        if(!std::getline(*is_,line_))return false;
+        line=line_;
+        return true;
+    };
+    if(!detail_::read_xyz_frame(next_line,frame,nframes_))return false;
+    ++nframes_;
+    return true;
+}
+
+XYZTrajectoryFollower::XYZTrajectoryFollower(const std::string& path,
+                                             duration poll_interval):
+    path_(path),fd_(::open(path.c_str(),O_RDONLY)),
+    poll_interval_(poll_interval)
+{
+    if(fd_<0)
+        throw std::runtime_error("Could not open file: "+path);
+}
+
+XYZTrajectoryFollower::~XYZTrajectoryFollower()noexcept
+{
+    ::close(fd_);
+}
+
+bool XYZTrajectoryFollower::read_new_bytes()
+{
+    //Drop what was handed out, once it's worth moving the rest
+    if(begin_>buffer_.size()/2)
+    {
+        buffer_.erase(0,begin_);
+        begin_=0;
+    }
+    constexpr size_t block_size=1<<16;
+    const size_t size=buffer_.size();
+    buffer_.resize(size+block_size);
+    ssize_t n;
+    do n=::read(fd_,&buffer_[size],block_size);
+    while(n<0 && errno==EINTR);
+    buffer_.resize(size+std::max<ssize_t>(n,0));
+    if(n<0)throw std::runtime_error("Could not read file: "+path_);
+    bytes_read_+=n;
+    if(n)return true;
+    struct stat info;
+    if(::fstat(fd_,&info)==0 && static_cast<size_t>(info.st_size)<bytes_read_)
+        throw std::runtime_error("Trajectory shrank while being followed: "+
+                                 path_);
+    return false;
+}
+
+bool XYZTrajectoryFollower::try_next(SetOfAtoms& frame)
+{
+    size_t end;
+    while(!detail_::complete_xyz_frame(buffer_,begin_,end,nframes_))
+        if(!read_new_bytes())return false;
+    const std::string_view buffer(buffer_.data(),end);
+    detail_::read_xyz_frame(detail_::BufferLines{buffer,begin_},frame,nframes_);
+    begin_=end;
+    ++nframes_;
+    return true;
+}
+
+bool XYZTrajectoryFollower::next(SetOfAtoms& frame, duration timeout)
+{
+    const auto deadline=std::chrono::steady_clock::now()+timeout;
+    while(!try_next(frame))
+    {
+        const auto now=std::chrono::steady_clock::now();
+        if(now>=deadline)return false;
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                                        poll_interval_,deadline-now));
+    }
+    return true;
+}
+
+IndexedXYZTrajectory::IndexedXYZTrajectory(const std::string& path):
+    file_(path)
+{
+    if(detail_::load_xyz_index(path,file_.size(),offsets_))return;
+    offsets_=detail_::index_xyz_buffer(file_.data());
+    try{detail_::save_xyz_index(path,file_.size(),offsets_);}
+    catch(const std::runtime_error&){}
+}
+
+void IndexedXYZTrajectory::read_frame(size_t i, SetOfAtoms& frame)const
+{
+    if(i>=size())
+        throw std::out_of_range("Frame "+std::to_string(i)+" requested, but "
+                                "the trajectory has "+std::to_string(size())+
+                                " frames");
+    const std::string_view buffer=file_.data().substr(0,offsets_[i+1]);
+    if(!detail_::read_xyz_frame(detail_::BufferLines{buffer,offsets_[i]},
+                                frame,i))
+        throw std::runtime_error("xyz frame "+std::to_string(i)+
+                                 " is empty, the index may be out of date");
+}
+
+std::vector<SetOfAtoms>
+IndexedXYZTrajectory::read_frames(const std::vector<size_t>& frames,
+                                  size_t nthreads)const
+{
+    std::vector<SetOfAtoms> rv(frames.size());
+    detail_::parallel_for(frames.size(),nthreads,[&](size_t i, size_t){
+        read_frame(frames[i],rv[i]);
+    });
+    return rv;
+}
+
+std::vector<size_t> index_xyz_trajectory(const std::string& path)
+{
+    const detail_::MappedFile file(path);
+    return detail_::index_xyz_buffer(file.data());
+}
+
+void save_xyz_index(const std::string& path,
+                    const std::vector<size_t>& offsets)
+{
+    const detail_::MappedFile file(path);
+    detail_::save_xyz_index(path,file.size(),offsets);
+}
+
+bool load_xyz_index(const std::string& path,
+                    std::vector<size_t>& offsets)noexcept
+{
+    try
+    {
+        const detail_::MappedFile file(path);
+        return detail_::load_xyz_index(path,file.size(),offsets);
+    }
+    catch(...)
+    {
+        return false;
+    }
+}
+
+}//End namespace
@@ -0,0 +1,410 @@
+#pragma once
+#include <chrono>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "LibChemist/SetOfAtoms.hpp"
+#include "LibChemist/detail_/MappedFile.hpp"
+
+/** \file This file contains the machinery for reading multi-frame xyz files.
+ *
+ * parse_SetOfAtoms_file reads an entire stream into a single SetOfAtoms, which
+ * for a trajectory means every frame gets merged into one molecule.  The
+ * classes in this file instead read a trajectory one frame at a time.  Each
+ * frame is expected to be in the standard xyz layout:
+ *
+ * \verbatim
+   <number of atoms>
+   <comment line>
+   <symbol> <x> <y> <z>
+   ...
+   \endverbatim
+ *
+ * If the comment line is of the form "<charge> <multiplicity>" (i.e. it is an
+ * overall_system line for XYZParser) the frame's charge and multiplicity are
+ * taken from it, otherwise they are 0 and 1 respectively.  Blank lines between
+ * frames are ignored.
+ *
+ * XYZTrajectory reads a stream front to back.  For random access to the frames
+ * of a trajectory on disk, IndexedXYZTrajectory uses a frame index: the byte
+ * offset of each frame, found by a one-time pass over the file that only looks
+ * at the atom-count lines.  The index is cached next to the trajectory in a
+ * small binary sidecar file (the trajectory's path with ".idx" appended) so
+ * later runs can skip the indexing pass.  The sidecar holds, in native byte
+ * order, the 8-byte magic "LCXYZIDX", a 64-bit format version, the size of the
+ * trajectory in bytes, its modification time in nanoseconds since the epoch,
+ * the number of frames n, and n+1 64-bit offsets.  A sidecar is only used if
+ * the size and modification time still match and its offsets are increasing
+ * and within the trajectory.
+ *
+ * XYZTrajectoryFollower reads a trajectory that is still being written, e.g.
+ * by a running MD engine, handing out each frame as soon as all of it has
+ * been flushed to disk.
+ */
+
+namespace LibChemist {
+
+/** \brief Reads the frames of an xyz trajectory one at a time.
+ *
+ *  Only the current frame is held in memory and its storage is reused for the
+ *  next frame, so memory usage is independent of the number of frames.  The
+ *  class can be used directly via next, or as a range:
+ *
+ *  \code
+    std::ifstream file("traj.xyz");
+    for(const SetOfAtoms& frame: XYZTrajectory(file))
+        do_something(frame);
+    \endcode
+ *
+ *  \note Because the storage is reused, references to the current frame are
+ *  invalidated by reading the next frame.
+ */
+class XYZTrajectory {
+public:
+    class iterator;
+
+    /** \brief Makes a reader for the trajectory in \p is.
+     *
+     *  \param[in] is The stream containing the trajectory.  \p is must outlive
+     *                the current instance.
+     *  \throws No throw guarantee.
+     */
+    explicit XYZTrajectory(std::istream& is)noexcept:
+        is_(&is)
+    {}
+
+    /** \brief Reads the next frame of the trajectory.
+     *
+     *  \param[out] frame The SetOfAtoms to read the frame into.  Its atoms are
+     *                    replaced, but its memory is reused.
+     *  \returns False if the stream contains no more frames.
+     *  \throws std::runtime_error if the stream ends in the middle of a frame
+     *          or the frame is malformed.
+     *  \throws std::out_of_range if an atomic symbol is not recognized.
+     */
+    bool next(SetOfAtoms& frame);
+
+    /** \brief Reads the next frame of the trajectory into the internal frame.
+     *
+     *  \returns False if the stream contains no more frames.
+     *  \throws See the other overload.
+     */
+    bool next()
+    {
+        return next(frame_);
+    }
+
+    ///Returns the most recently read frame
+    const SetOfAtoms& frame()const noexcept
+    {
+        return frame_;
+    }
+
+    ///Returns the number of frames read so far
+    size_t nframes()const noexcept
+    {
+        return nframes_;
+    }
+
+    ///Reads the first frame and returns an iterator to it
+    iterator begin();
+
+    ///Returns the iterator signaling the end of the trajectory
+    iterator end()noexcept;
+
+private:
+    ///The stream we are reading from
+    std::istream* is_;
+
+    ///The current frame
+    SetOfAtoms frame_;
+
+    ///Buffer for the current line, reused between lines
+    std::string line_;
+
+    ///How many frames have been read
+    size_t nframes_=0;
+};
+
+/** \brief An input iterator over the frames of an XYZTrajectory.
+ *
+ *  Incrementing the iterator reads the next frame into the trajectory's
+ *  internal frame.
+ */
+class XYZTrajectory::iterator {
+public:
+    using iterator_category=std::input_iterator_tag;
+    using value_type=SetOfAtoms;
+    using difference_type=std::ptrdiff_t;
+    using pointer=const SetOfAtoms*;
+    using reference=const SetOfAtoms&;
+
+    ///Makes an end iterator
+    iterator()noexcept=default;
+
+    reference operator*()const noexcept
+    {
+        return traj_->frame();
+    }
+
+    pointer operator->()const noexcept
+    {
+        return &traj_->frame();
+    }
+
+    iterator& operator++()
+    {
+        if(!traj_->next())traj_=nullptr;
+        return *this;
+    }
+
+    bool operator==(const iterator& rhs)const noexcept
+    {
+        return traj_==rhs.traj_;
+    }
+
+    bool operator!=(const iterator& rhs)const noexcept
+    {
+        return !((*this)==rhs);
+    }
+
+private:
+    friend class XYZTrajectory;
+
+    explicit iterator(XYZTrajectory* traj)noexcept:
+        traj_(traj)
+    {}
+
+    ///The trajectory we are iterating over, nullptr signals the end
+    XYZTrajectory* traj_=nullptr;
+};
+
+/** \brief Random access to the frames of an xyz trajectory on disk.
+ *
+ *  The trajectory is memory mapped and frames are located via the frame index,
+ *  so reading frame i costs the same regardless of i.  Several frames can be
+ *  decoded in parallel with read_frames.
+ */
+class IndexedXYZTrajectory {
+public:
+    /** \brief Opens the trajectory at \p path.
+     *
+     *  The frame index is loaded from the sidecar file if it exists and
+     *  matches the trajectory.  Otherwise the trajectory is indexed and the
+     *  sidecar is (re)written.  Failing to write the sidecar is not an error,
+     *  the index will simply be rebuilt next time.
+     *
+     *  \param[in] path The path to the trajectory.
+     *  \throws std::runtime_error if the trajectory can not be mapped or a
+     *          frame header is malformed.
+     */
+    explicit IndexedXYZTrajectory(const std::string& path);
+
+    ///Returns the number of frames in the trajectory
+    size_t size()const noexcept
+    {
+        return offsets_.size()-1;
+    }
+
+    ///Returns the byte offsets of the frames, the last element is the end
+    const std::vector<size_t>& offsets()const noexcept
+    {
+        return offsets_;
+    }
+
+    /** \brief Reads frame \p i of the trajectory.
+     *
+     *  \param[in] i The frame to read.  Must be in the range [0,size()).
+     *  \param[out] frame The SetOfAtoms to read the frame into.  Its atoms are
+     *                    replaced, but its memory is reused.
+     *  \throws std::out_of_range if \p i is not a valid frame.
+     *  \throws std::runtime_error if the frame is malformed.
+     */
+    void read_frame(size_t i, SetOfAtoms& frame)const;
+
+    ///Same as the other overload, but returns a new SetOfAtoms
+    SetOfAtoms frame(size_t i)const
+    {
+        SetOfAtoms rv;
+        read_frame(i,rv);
+        return rv;
+    }
+
+    /** \brief Reads several frames of the trajectory in parallel.
+     *
+     *  \param[in] frames The indices of the frames to read, in any order.
+     *  \param[in] nthreads The number of threads to use, 0 means one per
+     *                      hardware thread.
+     *  \returns The requested frames, in the same order as \p frames.
+     *  \throws See read_frame.
+     */
+    std::vector<SetOfAtoms> read_frames(const std::vector<size_t>& frames,
+                                        size_t nthreads=0)const;
+
+private:
+    ///The mapped trajectory
+    detail_::MappedFile file_;
+
+    ///Where each frame starts, plus the end of the last frame
+    std::vector<size_t> offsets_;
+};
+
+/** \brief Reads the frames of an xyz trajectory that is still growing.
+ *
+ *  The file is read with plain reads that pick up where the previous one
+ *  left off, so no byte is read twice no matter how long the trajectory gets.
+ *  Only as much is read as it takes to complete the next frame, so following
+ *  a trajectory that is already large does not load all of it at once.
+ *  A frame is only handed out once all of its lines, including the newline
+ *  ending its last line, are in the file; until then its bytes are held back
+ *  and next waits for more data, checking the file every poll interval.
+ *
+ *  \code
+    XYZTrajectoryFollower traj("md.xyz");
+    SetOfAtoms frame;
+    while(traj.next(frame,std::chrono::minutes(5)))
+        analyze(frame);
+    \endcode
+ */
+class XYZTrajectoryFollower {
+public:
+    using duration=std::chrono::milliseconds;
+
+    /** \brief Opens the trajectory at \p path.
+     *
+     *  \param[in] path The path to the trajectory.  The file must exist, but
+     *                  may be empty.
+     *  \param[in] poll_interval How long to sleep between checks for new data.
+     *  \throws std::runtime_error if the file can not be opened.
+     */
+    explicit XYZTrajectoryFollower(const std::string& path,
+                                   duration poll_interval=duration(100));
+
+    ///Closes the file
+    ~XYZTrajectoryFollower()noexcept;
+
+    XYZTrajectoryFollower(const XYZTrajectoryFollower&)=delete;
+    XYZTrajectoryFollower& operator=(const XYZTrajectoryFollower&)=delete;
+
+    /** \brief Reads the next frame if all of it is in the file, without
+     *         waiting.
+     *
+     *  \param[out] frame The SetOfAtoms to read the frame into.  Its atoms are
+     *                    replaced, but its memory is reused.  Unchanged if
+     *                    false is returned.
+     *  \returns False if the next frame is not complete yet.
+     *  \throws std::runtime_error if the file can not be read, shrank (e.g.
+     *          the engine restarted and truncated it), or the frame is
+     *          malformed.
+     *  \throws std::out_of_range if an atomic symbol is not recognized.
+     */
+    bool try_next(SetOfAtoms& frame);
+
+    /** \brief Reads the next frame, waiting for it to be written if needed.
+     *
+     *  \param[out] frame See try_next.
+     *  \param[in] timeout How long to wait for the frame.
+     *  \returns False if the frame was not complete before \p timeout ran
+     *           out, e.g. because the engine is done.
+     *  \throws See try_next.
+     */
+    bool next(SetOfAtoms& frame, duration timeout);
+
+    ///Same as next, but reads the frame into the internal frame
+    bool next(duration timeout)
+    {
+        return next(frame_,timeout);
+    }
+
+    ///Returns the frame most recently read into the internal frame
+    const SetOfAtoms& frame()const noexcept
+    {
+        return frame_;
+    }
+
+    ///Returns the number of frames read so far
+    size_t nframes()const noexcept
+    {
+        return nframes_;
+    }
+
+    ///Returns the number of bytes of the file read so far
+    size_t bytes_read()const noexcept
+    {
+        return bytes_read_;
+    }
+
+private:
+    /** \brief Appends up to one block of what was added to the file since
+     *         the last call to buffer_.
+     *
+     *  \returns False if there was nothing new to read.
+     */
+    bool read_new_bytes();
+
+    std::string path_;
+    int fd_=-1;
+    duration poll_interval_;
+
+    ///Bytes read but not handed out yet start at buffer_[begin_]
+    std::string buffer_;
+    size_t begin_=0;
+
+    size_t bytes_read_=0;
+    size_t nframes_=0;
+    SetOfAtoms frame_;
+};
+
+/** \brief Finds the byte offset of each frame in an xyz trajectory.
+ *
+ *  Only the atom-count lines are parsed, the remaining lines of each frame are
+ *  skipped over.
+ *
+ *  \param[in] path The path to the trajectory.
+ *  \returns The n+1 offsets of the trajectory's n frames, frame i spans the
+ *           bytes [rv[i],rv[i+1]).
+ *  \throws std::runtime_error if the trajectory can not be mapped, a frame
+ *          header is malformed, or the last frame is truncated.
+ */
+std::vector<size_t> index_xyz_trajectory(const std::string& path);
+
+/** \brief Writes the sidecar frame index for the trajectory at \p path.
+ *
+ *  \param[in] path The path to the trajectory (not the sidecar).
+ *  \param[in] offsets The frame index, as returned by index_xyz_trajectory.
+ *  \throws std::runtime_error if the sidecar can not be written or the
+ *          trajectory can not be opened.
+ */
+void save_xyz_index(const std::string& path,
+                    const std::vector<size_t>& offsets);
+
+/** \brief Loads the sidecar frame index for the trajectory at \p path.
+ *
+ *  \param[in] path The path to the trajectory (not the sidecar).
+ *  \param[out] offsets The frame index.  Unchanged if false is returned.
+ *  \returns False if there is no sidecar, it does not match the trajectory
+ *           (i.e. the trajectory changed since the sidecar was written), or
+ *           its offsets are not increasing or run past the trajectory.
+ *  \throws None No throw guarantee.
+ */
+bool load_xyz_index(const std::string& path,
+                    std::vector<size_t>& offsets)noexcept;
+
+///Returns the path of the sidecar frame index for the trajectory at \p path
+inline std::string xyz_index_path(const std::string& path)
+{
+    return path+".idx";
+}
+
+inline XYZTrajectory::iterator XYZTrajectory::begin()
+{
+    return next() ? iterator(this) : iterator();
+}
+
+inline XYZTrajectory::iterator XYZTrajectory::end()noexcept
+{
+    return iterator();
+}
+
+}//End namespace
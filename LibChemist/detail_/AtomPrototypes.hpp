@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "LibChemist/Atom.hpp"
+#include "LibChemist/lut/AtomicInfo.hpp"
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief Caches one Atom per atomic number so that parsers can stamp out
+ *         atoms without redoing create_atom's look ups every time.
+ *
+ *  create_atom has to find the most common isotope, the isotope's mass, and
+ *  the rest of the atomic data, each a separate table look up.  When reading
+ *  thousands of atoms the same handful of elements come up over and over, so
+ *  it is much cheaper to copy a previously made atom and move it.
+ *
+ *  Not thread safe; give each thread its own instance.
+ */
+class AtomPrototypes {
+public:
+    /** \brief Returns an atom with atomic number \p Z at \p xyz.
+     *
+     *  The result is the same as create_atom(xyz,Z).  Only the elements
+     *  numbered below Z2sym_.size() are cached; anything else, e.g. the dummy
+     *  atom, is passed straight to create_atom, so a corrupt \p Z can not
+     *  make the cache huge.
+     *
+     *  \throws std::out_of_range if \p Z is not a known atomic number.
+     */
+    Atom make(const std::array<double,3>& xyz, size_t Z)
+    {
+        if(Z>=Z2sym_.size())return create_atom(xyz,Z);
+        if(Z>=prototypes_.size())
+        {
+            prototypes_.resize(Z+1);
+            have_prototype_.resize(Z+1,false);
+        }
+        if(!have_prototype_[Z])
+        {
+            prototypes_[Z]=create_atom({0.0,0.0,0.0},Z);
+            have_prototype_[Z]=true;
+        }
+        Atom rv(prototypes_[Z]);
+        rv.coord=xyz;
+        return rv;
+    }
+
+private:
+    std::vector<Atom> prototypes_;
+    std::vector<bool> have_prototype_;
+};
+
+}}//End namespaces
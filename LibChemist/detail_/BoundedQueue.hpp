@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief A fixed-capacity, thread-safe FIFO queue.
+ *
+ *  Used to hand work between a producer and a consumer thread without letting
+ *  the producer run arbitrarily far ahead.  push blocks while the queue is
+ *  full and pop blocks while it is empty.  Closing the queue wakes everyone
+ *  up: further pushes fail, and pops fail once the queue has been drained.
+ *
+ *  \tparam T The type of the elements, must be movable.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    ///Makes a queue holding at most \p capacity elements (at least 1)
+    explicit BoundedQueue(size_t capacity)noexcept:
+        capacity_(capacity ? capacity : 1)
+    {}
+
+    /** \brief Appends \p value, waiting for room if the queue is full.
+     *
+     *  \returns False if the queue was closed, in which case \p value is
+     *           unchanged.
+     */
+    bool push(T& value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock,[this]{
+            return closed_ || items_.size()<capacity_;
+        });
+        if(closed_)return false;
+        items_.push_back(std::move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    ///Same as the other overload, but for temporaries
+    bool push(T&& value)
+    {
+        return push(value);
+    }
+
+    /** \brief Removes the oldest element, waiting for one if the queue is
+     *         empty.
+     *
+     *  \param[out] value Set to the removed element.
+     *  \returns False if the queue is closed and empty.
+     */
+    bool pop(T& value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock,[this]{return closed_ || !items_.empty();});
+        if(items_.empty())return false;
+        value=std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    ///Closes the queue, waking up all waiting threads
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_=true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    bool closed_=false;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+}}//End namespaces
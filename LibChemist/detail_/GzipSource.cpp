@@ -0,0 +1,122 @@
+#include "LibChemist/detail_/GzipSource.hpp"
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace LibChemist {
+namespace detail_ {
+
+bool is_gzip_file(const std::string& path)
+{
+    std::array<char,2> magic;
+    std::ifstream is(path,std::ios::binary);
+    is.read(magic.data(),magic.size());
+    return is_gzip(std::string_view(magic.data(),is.gcount()));
+}
+
+#ifdef ENABLE_ZLIB
+
+bool gzip_supported()noexcept
+{
+    return true;
+}
+
+namespace {
+
+//The decompression state behind a gzip_source
+class Inflater {
+public:
+    explicit Inflater(ByteSource input):
+        input_(std::move(input)),buffer_(1<<16)
+    {
+        std::memset(&zs_,0,sizeof(zs_));
+        //15 is the largest window, +32 detects gzip vs zlib headers for us
+        if(inflateInit2(&zs_,15+32)!=Z_OK)
+            throw std::runtime_error("Could not initialize zlib");
+    }
+
+    ~Inflater(){inflateEnd(&zs_);}
+
+    Inflater(const Inflater&)=delete;
+    Inflater& operator=(const Inflater&)=delete;
+
+    size_t operator()(char* out, size_t n)
+    {
+        if(finished_)return 0;
+        //avail_out is only 32 bits
+        n=std::min<size_t>(n,std::numeric_limits<uInt>::max());
+        zs_.next_out=reinterpret_cast<Bytef*>(out);
+        zs_.avail_out=n;
+        while(zs_.avail_out)
+        {
+            if(!zs_.avail_in)refill();
+            const int ret=inflate(&zs_,Z_NO_FLUSH);
+            if(ret==Z_STREAM_END)
+            {
+                //Another gzip member may follow
+                if(!zs_.avail_in)refill();
+                if(!zs_.avail_in)
+                {
+                    finished_=true;
+                    break;
+                }
+                inflateReset(&zs_);
+            }
+            else if(ret==Z_BUF_ERROR && !zs_.avail_in && input_done_)
+                throw std::runtime_error("gzip data is truncated");
+            else if(ret!=Z_OK && ret!=Z_BUF_ERROR)
+                throw std::runtime_error(std::string("Invalid gzip data: ")+
+                                         (zs_.msg ? zs_.msg : "unknown"));
+        }
+        return n-zs_.avail_out;
+    }
+
+private:
+    //Pulls more compressed bytes, if there are any
+    void refill()
+    {
+        if(input_done_)return;
+        const size_t n=input_(buffer_.data(),buffer_.size());
+        input_done_=!n;
+        zs_.next_in=reinterpret_cast<Bytef*>(buffer_.data());
+        zs_.avail_in=n;
+    }
+
+    ByteSource input_;
+    std::vector<char> buffer_;
+    bool input_done_=false;
+    bool finished_=false;
+    z_stream zs_;
+};
+
+}//End anonymous namespace
+
+ByteSource gzip_source(ByteSource compressed)
+{
+    auto inflater=std::make_shared<Inflater>(std::move(compressed));
+    return [inflater](char* out, size_t n){return (*inflater)(out,n);};
+}
+
+#else
+
+bool gzip_supported()noexcept
+{
+    return false;
+}
+
+ByteSource gzip_source(ByteSource)
+{
+    throw std::runtime_error("Can not read gzip data, LibChemist was built "
+                             "without zlib (ENABLE_ZLIB)");
+}
+
+#endif
+
+}}//End namespaces
@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include "LibChemist/detail_/PipelinedLineReader.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+
+namespace LibChemist {
+namespace detail_ {
+
+///True if \p data starts with the gzip magic bytes
+inline bool is_gzip(std::string_view data)noexcept
+{
+    return data.size()>=2 && static_cast<unsigned char>(data[0])==0x1f &&
+           static_cast<unsigned char>(data[1])==0x8b;
+}
+
+///True if the file at \p path starts with the gzip magic bytes
+bool is_gzip_file(const std::string& path);
+
+///True if the library was built with zlib, i.e. can read gzip files
+bool gzip_supported()noexcept;
+
+/** \brief Returns a ByteSource handing out the decompressed bytes of the gzip
+ *         data pulled from \p compressed.
+ *
+ *  Concatenated gzip members are read as one stream.
+ *
+ *  \throws std::runtime_error if the library was built without zlib.  The
+ *          source throws std::runtime_error if the data is not valid gzip or
+ *          is truncated.
+ */
+ByteSource gzip_source(ByteSource compressed);
+
+/** \brief Calls \p fxn with each line of the contents of a file, which may be
+ *         gzip-compressed.
+ *
+ *  Compressed contents are decompressed on a separate thread, in bounded-size
+ *  chunks, by a PipelinedLineReader.
+ *
+ *  \param[in] contents The contents of the file, e.g. its mapping.
+ *  \param[in] fxn A callable taking an std::string_view.
+ *  \throws std::runtime_error if \p contents is gzip data but the library was
+ *          built without zlib, or it is not valid gzip.
+ */
+template<typename line_fxn>
+void for_each_file_line(std::string_view contents, line_fxn&& fxn)
+{
+    if(!is_gzip(contents))
+    {
+        for_each_line(contents,fxn);
+        return;
+    }
+    PipelinedLineReader reader(gzip_source(memory_source(contents)));
+    std::string_view line;
+    while(reader.next(line))
+        fxn(line);
+}
+
+/** \brief Calls \p fxn with each line of the file at \p path, which may be
+ *         gzip-compressed, reading the file on a separate thread.
+ *
+ *  Unlike mapping the file, the parsing thread never waits on the disk (or
+ *  the network, for remote filesystems) as long as it is slower than the
+ *  reads; the reads run ahead of it by up to \p nchunks chunks.
+ *
+ *  \param[in] path The path to the file.
+ *  \param[in] fxn A callable taking an std::string_view.
+ *  \param[in] chunk_size The number of bytes read at a time.
+ *  \param[in] nchunks The number of chunks that may be read ahead.
+ *  \throws std::runtime_error if the file can not be read, or is gzip data
+ *          that can not be decompressed.
+ */
+template<typename line_fxn>
+void for_each_pipelined_line(const std::string& path, line_fxn&& fxn,
+                             size_t chunk_size=pipeline_chunk_size,
+                             size_t nchunks=pipeline_nchunks)
+{
+    ByteSource source=file_source(path);
+    if(is_gzip_file(path))source=gzip_source(std::move(source));
+    PipelinedLineReader reader(std::move(source),chunk_size,nchunks);
+    std::string_view line;
+    while(reader.next(line))
+        fxn(line);
+}
+
+/** \brief Returns the contents of a file, decompressing them if they are
+ *         gzip-compressed.
+ *
+ *  This is for readers that need all of a file in memory at once.  If
+ *  \p contents is not compressed it is returned as is, otherwise it is
+ *  inflated straight into \p buffer, on the calling thread, and a view of
+ *  \p buffer is returned.
+ *
+ *  \param[in] contents The contents of the file, e.g. its mapping.
+ *  \param[out] buffer Holds the decompressed contents, if any.
+ *  \throws std::runtime_error if \p contents is gzip data but can not be
+ *          decompressed.
+ */
+inline std::string_view decompressed_contents(std::string_view contents,
+                                              std::string& buffer)
+{
+    if(!is_gzip(contents))return contents;
+    ByteSource source=gzip_source(memory_source(contents));
+    //Text usually compresses to well under a quarter of its size
+    buffer.resize(std::max<size_t>(4*contents.size(),4096));
+    size_t size=0;
+    while(true)
+    {
+        if(size==buffer.size())buffer.resize(2*buffer.size());
+        const size_t n=source(buffer.data()+size,buffer.size()-size);
+        if(!n)break;
+        size+=n;
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+}}//End namespaces
@@ -0,0 +1,288 @@
+#include "LibChemist/detail_/JsonReader.hpp"
+#include "LibChemist/detail_/TextParsing.hpp"
+#include <stdexcept>
+
+namespace LibChemist {
+namespace detail_ {
+
+using token_type=JsonReader::token_type;
+
+namespace {
+
+[[noreturn]] void malformed(const std::string& what)
+{
+    throw std::runtime_error("Malformed JSON: "+what);
+}
+
+//Value of a hexadecimal digit, or -1 if c isn't one
+int hex_value(char c)noexcept
+{
+    if(c>='0' && c<='9')return c-'0';
+    if(c>='a' && c<='f')return c-'a'+10;
+    if(c>='A' && c<='F')return c-'A'+10;
+    return -1;
+}
+
+//Reads the four hex digits at raw[i]
+unsigned read_code_unit(std::string_view raw, size_t i)
+{
+    if(i+4>raw.size())malformed("truncated \\u escape");
+    unsigned rv=0;
+    for(size_t j=i;j<i+4;++j)
+    {
+        const int digit=hex_value(raw[j]);
+        if(digit<0)malformed("bad \\u escape");
+        rv=rv*16+digit;
+    }
+    return rv;
+}
+
+void append_utf8(unsigned code, std::string& out)
+{
+    if(code<0x80)
+        out.push_back(static_cast<char>(code));
+    else if(code<0x800)
+    {
+        out.push_back(static_cast<char>(0xC0|(code>>6)));
+        out.push_back(static_cast<char>(0x80|(code&0x3F)));
+    }
+    else if(code<0x10000)
+    {
+        out.push_back(static_cast<char>(0xE0|(code>>12)));
+        out.push_back(static_cast<char>(0x80|((code>>6)&0x3F)));
+        out.push_back(static_cast<char>(0x80|(code&0x3F)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xF0|(code>>18)));
+        out.push_back(static_cast<char>(0x80|((code>>12)&0x3F)));
+        out.push_back(static_cast<char>(0x80|((code>>6)&0x3F)));
+        out.push_back(static_cast<char>(0x80|(code&0x3F)));
+    }
+}
+
+//Replaces the escape sequences of the string body raw, writing it to out
+void unescape(std::string_view raw, std::string& out)
+{
+    out.clear();
+    for(size_t i=0;i<raw.size();++i)
+    {
+        if(raw[i]!='\\')
+        {
+            out.push_back(raw[i]);
+            continue;
+        }
+        //The closing quote search guarantees something follows a backslash
+        switch(raw[++i])
+        {
+            case('"'): out.push_back('"'); break;
+            case('\\'): out.push_back('\\'); break;
+            case('/'): out.push_back('/'); break;
+            case('b'): out.push_back('\b'); break;
+            case('f'): out.push_back('\f'); break;
+            case('n'): out.push_back('\n'); break;
+            case('r'): out.push_back('\r'); break;
+            case('t'): out.push_back('\t'); break;
+            case('u'):
+            {
+                unsigned code=read_code_unit(raw,i+1);
+                i+=4;
+                //Characters outside the BMP come as a surrogate pair
+                if(code>=0xD800 && code<0xDC00 && i+6<raw.size() &&
+                   raw[i+1]=='\\' && raw[i+2]=='u')
+                {
+                    const unsigned low=read_code_unit(raw,i+3);
+                    if(low>=0xDC00 && low<0xE000)
+                    {
+                        code=0x10000+((code-0xD800)<<10)+(low-0xDC00);
+                        i+=6;
+                    }
+                }
+                append_utf8(code,out);
+                break;
+            }
+            default:
+                malformed("bad escape sequence");
+        }
+    }
+}
+
+bool is_scalar_char(char c)noexcept
+{
+    return is_digit(c) || is_alpha(c) || c=='-' || c=='+' || c=='.';
+}
+
+}//End anonymous namespace
+
+JsonReader::JsonReader(std::string_view data):
+    data_(data)
+{}
+
+JsonReader::JsonReader(ByteSource source, size_t chunk_size):
+    source_(std::move(source)),chunk_size_(std::max<size_t>(chunk_size,1))
+{}
+
+bool JsonReader::refill()
+{
+    if(!source_)return false;
+    buffer_.erase(0,pos_);
+    pos_=0;
+    const size_t size=buffer_.size();
+    buffer_.resize(size+chunk_size_);
+    const size_t nread=source_(&buffer_[size],chunk_size_);
+    buffer_.resize(size+nread);
+    data_=buffer_;
+    return nread>0;
+}
+
+char JsonReader::peek()
+{
+    while(true)
+    {
+        for(;pos_<data_.size();++pos_)
+            if(!is_space(data_[pos_]))return data_[pos_];
+        if(!refill())return '\0';
+    }
+}
+
+void JsonReader::read_string()
+{
+    //Find the closing quote, pulling bytes until the whole string is in hand
+    size_t i=pos_+1;
+    bool escaped=false;
+    while(true)
+    {
+        while(i<data_.size() && data_[i]!='"')
+        {
+            //Skip the escaped character, it may be a quote
+            if(data_[i]=='\\')
+            {
+                escaped=true;
+                ++i;
+            }
+            ++i;
+        }
+        if(i<data_.size())break;
+        const size_t offset=i-pos_;
+        if(!refill())malformed("unterminated string");
+        i=pos_+offset;
+    }
+    const std::string_view raw=data_.substr(pos_+1,i-pos_-1);
+    pos_=i+1;
+    if(!escaped)
+    {
+        value_=raw;
+        return;
+    }
+    unescape(raw,scratch_);
+    value_=scratch_;
+}
+
+token_type JsonReader::read_scalar()
+{
+    size_t i=pos_;
+    while(true)
+    {
+        while(i<data_.size() && is_scalar_char(data_[i]))++i;
+        if(i<data_.size())break;
+        const size_t offset=i-pos_;
+        if(!refill())break;
+        i=pos_+offset;
+    }
+    value_=data_.substr(pos_,i-pos_);
+    pos_=i;
+    if(value_=="true" || value_=="false" || value_=="null")
+        return token_type::literal;
+    double number;
+    if(value_.empty() || !to_double(value_,number))
+        malformed("unexpected "+(value_.empty() ? std::string(1,data_[pos_]) :
+                                                  std::string(value_)));
+    return token_type::number;
+}
+
+token_type JsonReader::next()
+{
+    value_=std::string_view();
+    char c=peek();
+    if(done_)
+    {
+        if(c!='\0')malformed("trailing characters");
+        return token_type::end;
+    }
+    if(c=='\0')malformed("unexpected end of document");
+
+    const bool in_object=(!stack_.empty() && stack_.back()=='{');
+    if(c=='}' || c==']')
+    {
+        //A comma must be followed by something, as must a key
+        if(stack_.empty() || stack_.back()!=(c=='}' ? '{' : '[') ||
+           (!need_comma_ && (in_object ? !expect_key_ : false)))
+            malformed(std::string("unexpected ")+c);
+        ++pos_;
+        stack_.pop_back();
+        end_value();
+        expect_key_=false;
+        done_=stack_.empty();
+        return (c=='}' ? token_type::end_object : token_type::end_array);
+    }
+    if(need_comma_)
+    {
+        if(c!=',')malformed("expected a comma");
+        ++pos_;
+        need_comma_=false;
+        expect_key_=in_object;
+        c=peek();
+        if(c=='}' || c==']')malformed("trailing comma");
+    }
+    if(expect_key_)
+    {
+        if(c!='"')malformed("expected a key");
+        read_string();
+        //Looking for the colon may pull bytes, moving the key
+        if(source_ && value_.data()!=scratch_.data())
+        {
+            scratch_.assign(value_);
+            value_=scratch_;
+        }
+        if(peek()!=':')malformed("expected a colon");
+        ++pos_;
+        expect_key_=false;
+        return token_type::key;
+    }
+
+    token_type rv;
+    if(c=='{' || c=='[')
+    {
+        ++pos_;
+        stack_.push_back(c);
+        need_comma_=false;
+        expect_key_=(c=='{');
+        return (c=='{' ? token_type::begin_object : token_type::begin_array);
+    }
+    else if(c=='"')
+    {
+        read_string();
+        rv=token_type::string;
+    }
+    else
+        rv=read_scalar();
+    end_value();
+    done_=stack_.empty();
+    return rv;
+}
+
+void JsonReader::skip(token_type first)
+{
+    if(first!=token_type::begin_object && first!=token_type::begin_array)
+        return;
+    for(size_t depth=1;depth;)
+    {
+        const token_type t=next();
+        if(t==token_type::begin_object || t==token_type::begin_array)
+            ++depth;
+        else if(t==token_type::end_object || t==token_type::end_array)
+            --depth;
+    }
+}
+
+}}//End namespaces
@@ -0,0 +1,99 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LibChemist/detail_/PipelinedLineReader.hpp"
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief A pull parser for JSON.
+ *
+ *  The document is handed out one token at a time, so readers build their
+ *  objects straight from the tokens and nothing resembling a DOM is ever
+ *  built.  Documents that are already in memory (e.g. mapped files) are read
+ *  in place.  Otherwise bytes are pulled from a ByteSource into a buffer
+ *  holding only the tokens not handed out yet, so memory usage does not depend
+ *  on the size of the document.
+ *
+ *  Commas and colons are checked and consumed internally; object members are
+ *  handed out as a key token followed by the tokens of the value.
+ */
+class JsonReader {
+public:
+    enum class token_type{begin_object,end_object,begin_array,end_array,key,
+                          string,number,literal,end};
+
+    ///Reads the document in \p data, which must outlive the reader
+    explicit JsonReader(std::string_view data);
+
+    /** \brief Reads the document pulled from \p source.
+     *
+     *  \param[in] source Where the bytes of the document come from.
+     *  \param[in] chunk_size The number of bytes to pull at a time.
+     */
+    explicit JsonReader(ByteSource source, size_t chunk_size=1<<16);
+
+    /** \brief Returns the type of the next token.
+     *
+     *  \returns token_type::end once the document is exhausted.
+     *  \throws std::runtime_error if the document is not valid JSON.
+     */
+    token_type next();
+
+    /** \brief Returns the text of the last key, string, number or literal.
+     *
+     *  Escape sequences in keys and strings have been replaced by the
+     *  characters they stand for.  The view is empty for the other tokens and
+     *  only valid until the next call to next.
+     */
+    std::string_view value()const noexcept
+    {
+        return value_;
+    }
+
+    /** \brief Skips the rest of the value whose first token was \p first.
+     *
+     *  Only objects and arrays have a rest, for other values this is a no-op.
+     *
+     *  \throws std::runtime_error if the document is not valid JSON.
+     */
+    void skip(token_type first);
+
+private:
+    ///Pulls more bytes, dropping those before pos_.  False at the end
+    bool refill();
+
+    ///Skips whitespace and returns the next character, '\0' at the end
+    char peek();
+
+    ///Reads the string starting at pos_ into value_
+    void read_string();
+
+    ///Reads the number or literal starting at pos_ into value_
+    token_type read_scalar();
+
+    ///A value just ended, the next token must be a comma or a closing bracket
+    void end_value()noexcept
+    {
+        need_comma_=!stack_.empty();
+    }
+
+    ByteSource source_;
+    size_t chunk_size_=0;
+    std::string buffer_;
+    std::string_view data_;
+    size_t pos_=0;
+
+    ///Holds strings that needed unescaping
+    std::string scratch_;
+    std::string_view value_;
+
+    ///The open objects ('{') and arrays ('[') enclosing pos_
+    std::vector<char> stack_;
+    bool need_comma_=false;
+    bool expect_key_=false;
+    bool done_=false;
+};
+
+}}//End namespaces
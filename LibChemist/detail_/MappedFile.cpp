@@ -0,0 +1,89 @@
+#include "LibChemist/detail_/MappedFile.hpp"
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LibChemist {
+namespace detail_ {
+
+MappedFile::MappedFile(const std::string& path)
+{
+    const int fd=::open(path.c_str(),O_RDONLY);
+    if(fd<0)
+        throw std::runtime_error("Could not open file: "+path);
+    struct stat info;
+    if(::fstat(fd,&info)!=0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Could not stat file: "+path);
+    }
+    size_=info.st_size;
+    //mmap rejects zero-length mappings, an empty file is just an empty view
+    if(size_)
+    {
+        void* ptr=::mmap(nullptr,size_,PROT_READ,MAP_PRIVATE,fd,0);
+        if(ptr==MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("Could not map file: "+path);
+        }
+        ::madvise(ptr,size_,MADV_SEQUENTIAL);
+        data_=static_cast<const char*>(ptr);
+    }
+    //The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()noexcept
+{
+    if(data_)
+        ::munmap(const_cast<char*>(data_),size_);
+}
+
+MappedFile::MappedFile(MappedFile&& other)noexcept:
+    data_(std::exchange(other.data_,nullptr)),
+    size_(std::exchange(other.size_,0))
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs)noexcept
+{
+    std::swap(data_,rhs.data_);
+    std::swap(size_,rhs.size_);
+    return *this;
+}
+
+void read_file(const std::string& path, std::string& buffer)
+{
+    const int fd=::open(path.c_str(),O_RDONLY);
+    if(fd<0)
+        throw std::runtime_error("Could not open file: "+path);
+    struct stat info;
+    if(::fstat(fd,&info)!=0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Could not stat file: "+path);
+    }
+    buffer.resize(info.st_size);
+    size_t size=0;
+    while(size<buffer.size())
+    {
+        const ssize_t n=::read(fd,&buffer[size],buffer.size()-size);
+        if(n<0 && errno==EINTR)continue;
+        if(n<0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Could not read file: "+path);
+        }
+        //The file shrank while we were reading it
+        if(n==0)break;
+        size+=n;
+    }
+    buffer.resize(size);
+    ::close(fd);
+}
+
+}}//End namespaces
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief RAII wrapper around a read-only memory mapping of a file.
+ *
+ *  The contents of the file are exposed as a view; no copies are made.  Pages
+ *  are brought in by the OS as they are touched.
+ */
+class MappedFile {
+public:
+    /** \brief Maps the file at \p path into memory.
+     *
+     *  \param[in] path The path to the file to map.
+     *  \throws std::runtime_error if the file can not be opened or mapped.
+     */
+    explicit MappedFile(const std::string& path);
+
+    ///Unmaps the file
+    ~MappedFile()noexcept;
+
+    MappedFile(const MappedFile&)=delete;
+    MappedFile& operator=(const MappedFile&)=delete;
+
+    MappedFile(MappedFile&& other)noexcept;
+    MappedFile& operator=(MappedFile&& rhs)noexcept;
+
+    ///Returns the contents of the file
+    std::string_view data()const noexcept
+    {
+        return std::string_view(data_,size_);
+    }
+
+    ///Returns the size of the file in bytes
+    size_t size()const noexcept
+    {
+        return size_;
+    }
+
+private:
+    const char* data_=nullptr;
+    size_t size_=0;
+};
+
+/** \brief Reads the file at \p path into \p buffer.
+ *
+ *  For small files mapping costs more than it saves, and reading into a buffer
+ *  that is reused from file to file avoids allocating too.
+ *
+ *  \param[in] path The path to the file to read.
+ *  \param[out] buffer Overwritten with the contents of the file.  Its capacity
+ *                     is reused.
+ *  \throws std::runtime_error if the file can not be opened or read.
+ */
+void read_file(const std::string& path, std::string& buffer);
+
+}}//End namespaces
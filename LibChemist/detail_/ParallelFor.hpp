@@ -0,0 +1,69 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief Resolves a user-provided thread count.
+ *
+ *  \param[in] nthreads The requested number of threads, 0 means one per
+ *                      hardware thread.
+ *  \returns The number of threads to use, which is always at least 1.
+ */
+inline size_t resolve_nthreads(size_t nthreads)noexcept
+{
+    if(!nthreads)nthreads=std::thread::hardware_concurrency();
+    return std::max<size_t>(nthreads,1);
+}
+
+/** \brief Calls \p fxn(i, thread) for each i in [0,n) using up to \p nthreads
+ *         threads.
+ *
+ *  Tasks are handed out dynamically so they need not take the same amount of
+ *  time.  thread is in the range [0,nthreads) and identifies the thread
+ *  running the task, which allows \p fxn to use per-thread scratch space.  The
+ *  calling thread participates as thread 0.
+ *
+ *  \param[in] n The number of tasks.
+ *  \param[in] nthreads The maximum number of threads to use, 0 means one per
+ *                      hardware thread.
+ *  \param[in] fxn A callable taking the task index and thread index.
+ *  \throws Rethrows the first exception thrown by \p fxn, after all threads
+ *          have stopped.  Tasks not yet started when an exception is thrown
+ *          are skipped.
+ */
+template<typename task_fxn>
+void parallel_for(size_t n, size_t nthreads, task_fxn&& fxn)
+{
+    nthreads=std::min(resolve_nthreads(nthreads),std::max<size_t>(n,1));
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker=[&](size_t thread){
+        for(size_t i=next++;i<n && !failed;i=next++)
+        {
+            try{fxn(i,thread);}
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if(!error)error=std::current_exception();
+                failed=true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads-1);
+    for(size_t t=1;t<nthreads;++t)
+        threads.emplace_back(worker,t);
+    worker(0);
+    for(auto& t: threads)t.join();
+    if(error)std::rethrow_exception(error);
+}
+
+}}//End namespaces
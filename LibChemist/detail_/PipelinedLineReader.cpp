@@ -0,0 +1,140 @@
+#include "LibChemist/detail_/PipelinedLineReader.hpp"
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace LibChemist {
+namespace detail_ {
+
+namespace {
+
+//Owns the descriptor so it is closed when the last copy of the source goes
+struct FileDescriptor {
+    FileDescriptor(int fd_in, const std::string& path_in):
+        fd(fd_in),path(path_in)
+    {}
+    ~FileDescriptor(){::close(fd);}
+    FileDescriptor(const FileDescriptor&)=delete;
+    FileDescriptor& operator=(const FileDescriptor&)=delete;
+
+    int fd;
+    std::string path;
+};
+
+}//End anonymous namespace
+
+ByteSource file_source(const std::string& path)
+{
+    const int fd=::open(path.c_str(),O_RDONLY);
+    if(fd<0)
+        throw std::runtime_error("Could not open file: "+path);
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd,0,0,POSIX_FADV_SEQUENTIAL);
+#endif
+    auto file=std::make_shared<FileDescriptor>(fd,path);
+    return [file](char* buffer, size_t n){
+        while(true)
+        {
+            const ssize_t nread=::read(file->fd,buffer,n);
+            if(nread>=0)return static_cast<size_t>(nread);
+            if(errno!=EINTR)
+                throw std::runtime_error("Could not read file: "+file->path);
+        }
+    };
+}
+
+PipelinedLineReader::PipelinedLineReader(ByteSource source, size_t chunk_size,
+                                         size_t nchunks):
+    source_(std::move(source)),full_(nchunks),empty_(nchunks)
+{
+    chunk_size=std::max<size_t>(chunk_size,1);
+    for(size_t i=0;i<std::max<size_t>(nchunks,1);++i)
+        empty_.push(Chunk{std::vector<char>(chunk_size),0});
+    thread_=std::thread(&PipelinedLineReader::produce,this);
+}
+
+PipelinedLineReader::~PipelinedLineReader()noexcept
+{
+    empty_.close();
+    full_.close();
+    if(thread_.joinable())thread_.join();
+}
+
+void PipelinedLineReader::produce()
+{
+    bool finished=false;
+    Chunk chunk;
+    while(!finished && empty_.pop(chunk))
+    {
+        chunk.size=0;
+        try
+        {
+            while(chunk.size<chunk.data.size())
+            {
+                const size_t n=source_(chunk.data.data()+chunk.size,
+                                       chunk.data.size()-chunk.size);
+                if(!n)
+                {
+                    finished=true;
+                    break;
+                }
+                chunk.size+=n;
+            }
+        }
+        catch(...)
+        {
+            //What was read before the failure is still handed out
+            error_=std::current_exception();
+            finished=true;
+        }
+        if(chunk.size && !full_.push(chunk))break;
+    }
+    full_.close();
+}
+
+bool PipelinedLineReader::next(std::string_view& line)
+{
+    if(clear_carry_)
+    {
+        carry_.clear();
+        clear_carry_=false;
+    }
+    while(true)
+    {
+        const char* begin=current_.data.data()+pos_;
+        const size_t n=current_.size-pos_;
+        const void* nl=(n ? std::memchr(begin,'\n',n) : nullptr);
+        if(nl)
+        {
+            const size_t len=static_cast<const char*>(nl)-begin;
+            pos_+=len+1;
+            if(carry_.empty())
+                line=std::string_view(begin,len);
+            else
+            {
+                carry_.append(begin,len);
+                line=carry_;
+                clear_carry_=true;
+            }
+            return true;
+        }
+        carry_.append(begin,n);
+
+        //Hand the chunk back to be refilled and wait for the next one
+        if(!current_.data.empty())empty_.push(current_);
+        current_=Chunk();
+        pos_=0;
+        if(!full_.pop(current_))
+        {
+            if(error_)std::rethrow_exception(error_);
+            if(carry_.empty())return false;
+            line=carry_;
+            clear_carry_=true;
+            return true;
+        }
+    }
+}
+
+}}//End namespaces
@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "LibChemist/detail_/BoundedQueue.hpp"
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief Something bytes can be pulled from, e.g. a file or a decompressor.
+ *
+ *  Calling it with a buffer and its size fills (part of) the buffer and
+ *  returns the number of bytes written, 0 meaning there are no more bytes.
+ *  It throws std::runtime_error if the bytes can not be produced.
+ */
+using ByteSource=std::function<size_t(char*, size_t)>;
+
+///Returns a ByteSource handing out \p data, which must outlive it
+inline ByteSource memory_source(std::string_view data)
+{
+    return [data](char* buffer, size_t n) mutable {
+        n=std::min(n,data.size());
+        std::memcpy(buffer,data.data(),n);
+        data.remove_prefix(n);
+        return n;
+    };
+}
+
+/** \brief Returns a ByteSource reading the file at \p path with plain reads.
+ *
+ *  \throws std::runtime_error if the file can not be opened.  The source
+ *          throws std::runtime_error if a read fails.
+ */
+ByteSource file_source(const std::string& path);
+
+///How many bytes the pipelined readers pull at a time, unless told otherwise
+inline constexpr size_t pipeline_chunk_size=1<<20;
+
+///How many chunks the pipelined readers fill ahead, unless told otherwise
+inline constexpr size_t pipeline_nchunks=4;
+
+/** \brief Splits the bytes of a ByteSource into lines, pulling them on a
+ *         separate thread.
+ *
+ *  The producer thread fills fixed-size chunks from the source and hands them
+ *  over through a bounded queue, while the thread calling next splits the
+ *  chunks it has received into lines.  This way reading (or decompressing) the
+ *  next chunk overlaps with parsing the current one, so the time taken is
+ *  roughly the larger of the two rather than their sum, and memory usage does
+ *  not depend on the size of the input.  Lines that straddle two chunks are
+ *  stitched together before being handed out.
+ */
+class PipelinedLineReader {
+public:
+    /** \brief Starts pulling bytes from \p source.
+     *
+     *  \param[in] source Where the bytes come from.  It is only called from
+     *                    the producer thread.
+     *  \param[in] chunk_size The number of bytes to pull at a time.
+     *  \param[in] nchunks The number of chunks the producer thread may fill
+     *                     ahead of the reader.
+     */
+    explicit PipelinedLineReader(ByteSource source,
+                                 size_t chunk_size=pipeline_chunk_size,
+                                 size_t nchunks=pipeline_nchunks);
+
+    ///Stops the producer thread
+    ~PipelinedLineReader()noexcept;
+
+    PipelinedLineReader(const PipelinedLineReader&)=delete;
+    PipelinedLineReader& operator=(const PipelinedLineReader&)=delete;
+
+    /** \brief Returns the next line, without its newline.
+     *
+     *  \param[out] line The line.  It is only valid until the next call.
+     *  \returns False if there are no more lines.
+     *  \throws Whatever the source threw, once the lines before the failure
+     *          have been handed out.
+     */
+    bool next(std::string_view& line);
+
+private:
+    struct Chunk {
+        std::vector<char> data;
+        size_t size=0;
+    };
+
+    ///The body of the producer thread
+    void produce();
+
+    ByteSource source_;
+
+    ///Filled chunks, on their way to the reader
+    BoundedQueue<Chunk> full_;
+
+    ///Chunks the reader is done with, on their way back to be refilled
+    BoundedQueue<Chunk> empty_;
+
+    ///Set by the producer thread if the source throws
+    std::exception_ptr error_;
+
+    ///The chunk being split into lines and where the next line starts in it
+    Chunk current_;
+    size_t pos_=0;
+
+    ///The start of a line that continues into the next chunk
+    std::string carry_;
+    bool clear_carry_=false;
+
+    std::thread thread_;
+};
+
+}}//End namespaces
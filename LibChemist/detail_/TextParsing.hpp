@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LibChemist/lut/AtomicInfo.hpp"
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/** \file Low-level, allocation-free helpers shared by the text file parsers.
+ *
+ * None of these functions are part of the public API.  They exist so that the
+ * various parsers tokenize lines and convert numbers the same way.
+ *
+ * Whitespace is found 16 bytes at a time with SSE2, or 32 at a time with AVX2
+ * if the library is compiled with it enabled (e.g. -mavx2), and byte by byte
+ * otherwise.  Newlines are found with std::memchr, which the C library already
+ * vectorizes with the widest instructions the CPU supports.  Numbers are
+ * converted with std::from_chars, which unlike strtod and stream extraction
+ * does not depend on the locale.
+ */
+
+namespace LibChemist {
+namespace detail_ {
+
+///CODATA 2014, the same value bin/generate_atomicinfo.py uses
+inline constexpr double angstrom2bohr=1.0/0.52917721067;
+
+///True for the characters std::isspace considers whitespace in the "C" locale
+inline bool is_space(char c)noexcept
+{
+    return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\v' || c=='\f';
+}
+
+inline bool is_digit(char c)noexcept
+{
+    return c>='0' && c<='9';
+}
+
+inline bool is_alpha(char c)noexcept
+{
+    return (c>='a' && c<='z') || (c>='A' && c<='Z');
+}
+
+inline bool is_alpha(std::string_view token)noexcept
+{
+    for(char c: token)
+        if(!is_alpha(c))return false;
+    return !token.empty();
+}
+
+//Strips leading and trailing whitespace
+inline std::string_view trim(std::string_view s)noexcept
+{
+    size_t begin=0, end=s.size();
+    while(begin<end && is_space(s[begin]))++begin;
+    while(end>begin && is_space(s[end-1]))--end;
+    return s.substr(begin,end-begin);
+}
+
+//The characters [begin,end) of line, trimmed, or empty if line is too short
+inline std::string_view column(std::string_view line, size_t begin,
+                               size_t end)noexcept
+{
+    if(begin>=line.size())return std::string_view();
+    return trim(line.substr(begin,end-begin));
+}
+
+/** \brief Calls \p fxn with each line of \p buffer.
+ *
+ *  Lines are passed as views into \p buffer (without the newline), so no
+ *  copies are made.
+ *
+ *  \param[in] buffer The text to split into lines.
+ *  \param[in] fxn A callable taking an std::string_view.
+ */
+template<typename line_fxn>
+void for_each_line(std::string_view buffer, line_fxn&& fxn)
+{
+    const char* begin=buffer.data();
+    const char* const end=begin+buffer.size();
+    while(begin<end)
+    {
+        const void* nl=std::memchr(begin,'\n',end-begin);
+        const char* eol=(nl ? static_cast<const char*>(nl) : end);
+        fxn(std::string_view(begin,eol-begin));
+        begin=eol+1;
+    }
+}
+
+/** \brief Calls \p fxn with each line read from \p is.
+ *
+ *  The stream is read in large blocks which are split with for_each_line,
+ *  rather than a line at a time with std::getline.  Lines straddling two
+ *  blocks are stitched together first.
+ *
+ *  \param[in] is The stream to read until it is exhausted.
+ *  \param[in] fxn A callable taking an std::string_view.
+ */
+template<typename line_fxn>
+void for_each_stream_line(std::istream& is, line_fxn&& fxn)
+{
+    constexpr size_t block_size=1<<16;
+    std::vector<char> block(block_size);
+    std::string carry;
+    while(is)
+    {
+        is.read(block.data(),block.size());
+        const std::string_view data(block.data(),is.gcount());
+        const size_t last_nl=data.rfind('\n');
+        if(last_nl==std::string_view::npos)
+        {
+            carry.append(data);
+            continue;
+        }
+        size_t begin=0;
+        if(!carry.empty())
+        {
+            begin=data.find('\n')+1;
+            carry.append(data.substr(0,begin-1));
+            fxn(std::string_view(carry));
+            carry.clear();
+        }
+        //Every line ending in this block, including a blank one ending at
+        //last_nl, which is why last_nl itself is passed along
+        for_each_line(data.substr(begin,last_nl+1-begin),fxn);
+        carry.append(data.substr(last_nl+1));
+    }
+    if(!carry.empty())fxn(std::string_view(carry));
+}
+
+/** \brief Returns the first character in [begin,end) that is (if \p space is
+ *         true) or is not (if \p space is false) whitespace.
+ *
+ *  \returns \p end if there is no such character.
+ */
+inline const char* find_space(const char* begin, const char* end,
+                              bool space)noexcept
+{
+#ifdef __AVX2__
+    const __m256i blank32=_mm256_set1_epi8(' ');
+    const __m256i below_tab32=_mm256_set1_epi8('\t'-1);
+    const __m256i above_cr32=_mm256_set1_epi8('\r'+1);
+    for(;end-begin>=32;begin+=32)
+    {
+        const __m256i c=
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        //'\t' through '\r' are contiguous, and bytes above 127 are negative
+        const __m256i is_blank=_mm256_or_si256(
+            _mm256_cmpeq_epi8(c,blank32),
+            _mm256_and_si256(_mm256_cmpgt_epi8(c,below_tab32),
+                             _mm256_cmpgt_epi8(above_cr32,c)));
+        unsigned mask=_mm256_movemask_epi8(is_blank);
+        if(!space)mask=~mask;
+        if(mask)return begin+__builtin_ctz(mask);
+    }
+#endif
+#ifdef __SSE2__
+    const __m128i blank=_mm_set1_epi8(' ');
+    const __m128i below_tab=_mm_set1_epi8('\t'-1);
+    const __m128i above_cr=_mm_set1_epi8('\r'+1);
+    for(;end-begin>=16;begin+=16)
+    {
+        const __m128i c=_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const __m128i is_blank=_mm_or_si128(
+            _mm_cmpeq_epi8(c,blank),
+            _mm_and_si128(_mm_cmpgt_epi8(c,below_tab),
+                          _mm_cmplt_epi8(c,above_cr)));
+        unsigned mask=_mm_movemask_epi8(is_blank);
+        if(!space)mask=~mask & 0xFFFFu;
+        if(mask)return begin+__builtin_ctz(mask);
+    }
+#endif
+    while(begin<end && is_space(*begin)!=space)++begin;
+    return begin;
+}
+
+/** \brief Returns the next whitespace delimited token of \p line.
+ *
+ *  \param[in] line The line being tokenized.
+ *  \param[in,out] pos Where to start looking for the token.  On exit it points
+ *                     just past the returned token.
+ *  \returns The token, or an empty view if there are no more tokens.
+ */
+inline std::string_view next_token(std::string_view line, size_t& pos)noexcept
+{
+    const char* const data=line.data();
+    const char* const end=data+line.size();
+    const char* const begin=find_space(data+std::min(pos,line.size()),end,
+                                       false);
+    const char* const token_end=find_space(begin,end,true);
+    pos=token_end-data;
+    return std::string_view(begin,token_end-begin);
+}
+
+/** \brief Returns the power of ten of the leading digit of a token to_double
+ *         has accepted.
+ *
+ *  For example, it is 2 for "123.4" and -2 for "0.05e0".  Exponents too large
+ *  to matter are clamped.  Only meaningful if the token is not zero.
+ */
+inline long decimal_magnitude(std::string_view token)noexcept
+{
+    const size_t n=token.size();
+    size_t i=(token[0]=='+' || token[0]=='-');
+    while(i<n && token[i]=='0')++i;
+    long rv=-1;
+    for(;i<n && is_digit(token[i]);++i)++rv;
+    if(i<n && token[i]=='.')
+    {
+        ++i;
+        if(rv<0)
+            for(;i<n && token[i]=='0';++i)--rv;
+        while(i<n && is_digit(token[i]))++i;
+    }
+    if(i<n)
+    {
+        ++i;//The e, E, d, or D
+        const bool negative=(token[i]=='-');
+        if(negative || token[i]=='+')++i;
+        long exponent=0;
+        for(;i<n;++i)exponent=std::min(10*exponent+(token[i]-'0'),100000L);
+        rv+=(negative ? -exponent : exponent);
+    }
+    return rv;
+}
+
+/** \brief Converts a token to a double.
+ *
+ *  The token must be of the form [+-]digits[.digits][(e|E|d|D)[+-]digits],
+ *  i.e. Fortran-style "D" exponents are allowed.  Numbers too big for a
+ *  double become +-HUGE_VAL and numbers too small become +-0, as with strtod.
+ *
+ *  \param[in] token The token to convert.
+ *  \param[out] value The converted number.
+ *  \param[out] is_int True if \p token has neither a decimal point nor an
+ *                     exponent.
+ *  \returns False if \p token is not a number, in which case \p value is
+ *           unchanged.
+ */
+inline bool to_double(std::string_view token, double& value,
+                      bool& is_int)noexcept
+{
+    char buffer[64];
+    const size_t n=token.size();
+    if(n>=sizeof(buffer))return false;
+    size_t i=0, ndigits=0;
+    is_int=true;
+    if(i<n && (token[i]=='+' || token[i]=='-'))++i;
+    for(;i<n && is_digit(token[i]);++i)++ndigits;
+    if(i<n && token[i]=='.')
+    {
+        is_int=false;
+        for(++i;i<n && is_digit(token[i]);++i)++ndigits;
+    }
+    if(!ndigits)return false;
+    //from_chars takes neither a leading '+' nor Fortran's 'D'
+    const bool plus=(token[0]=='+');
+    bool fortran=false;
+    if(i<n)
+    {
+        const char e=token[i];
+        if(e!='e' && e!='E' && e!='d' && e!='D')return false;
+        is_int=false;
+        fortran=(e=='d' || e=='D');
+        ++i;
+        if(i<n && (token[i]=='+' || token[i]=='-'))++i;
+        if(i==n)return false;
+        for(;i<n;++i)
+            if(!is_digit(token[i]))return false;
+    }
+    const char* first=token.data()+plus;
+    if(fortran)
+    {
+        for(size_t j=0;j<n;++j)
+            buffer[j]=(token[j]=='d' || token[j]=='D' ? 'e' : token[j]);
+        first=buffer+plus;
+    }
+    const char* const last=first+n-plus;
+    //Out of range values are still numbers, but from_chars leaves value alone
+    if(std::from_chars(first,last,value).ec==std::errc::result_out_of_range)
+    {
+        value=(decimal_magnitude(token)>=0 ? HUGE_VAL : 0.0);
+        if(token[0]=='-')value=-value;
+    }
+    return true;
+}
+
+///Same as the other overload for when we don't care if it's an integer
+inline bool to_double(std::string_view token, double& value)noexcept
+{
+    bool is_int;
+    return to_double(token,value,is_int);
+}
+
+/** \brief Returns the atomic number of an atomic symbol, ignoring case.
+ *
+ *  \param[in] sym The atomic symbol, e.g. "He", "HE", or "he".
+ *  \returns The atomic number of \p sym.
+ *  \throws std::out_of_range if \p sym is not a known atomic symbol.
+ */
+inline size_t symbol_to_Z(std::string_view sym)
+{
+    const size_t Z=find_symbol_Z(sym);
+    if(Z==no_symbol_Z_)
+        throw std::out_of_range("Unknown atomic symbol: "+std::string(sym));
+    return Z;
+}
+
+}}//End namespaces
@@ -0,0 +1,36 @@
+#include "LibChemist/detail_/TextWriting.hpp"
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace LibChemist {
+namespace detail_ {
+
+FileWriter::FileWriter(const std::string& path, bool append):
+    path_(path),
+    fd_(::open(path.c_str(),O_WRONLY|O_CREAT|(append ? O_APPEND : O_TRUNC),
+               0644))
+{
+    if(fd_<0)
+        throw std::runtime_error("Could not open file for writing: "+path);
+}
+
+FileWriter::~FileWriter()noexcept
+{
+    ::close(fd_);
+}
+
+void FileWriter::write(std::string_view data)
+{
+    while(!data.empty())
+    {
+        const ssize_t n=::write(fd_,data.data(),data.size());
+        if(n<0 && errno==EINTR)continue;
+        if(n<0)
+            throw std::runtime_error("Could not write file: "+path_);
+        data.remove_prefix(n);
+    }
+}
+
+}}//End namespaces
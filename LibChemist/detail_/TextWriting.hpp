@@ -0,0 +1,83 @@
+#pragma once
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/** \file Low-level helpers shared by the text file writers.
+ *
+ * The writers format into a std::string that is reused from call to call and
+ * hand it to a FileWriter once it is large, so the cost is one write call per
+ * megabyte or so rather than per number.  Doubles are written with
+ * std::to_chars, which produces the shortest string that reads back to the
+ * same double, so writing and then parsing a file is exact.
+ */
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief Appends the shortest representation of \p x that round trips.
+ *
+ *  \param[in] x The number to append.
+ *  \param[in,out] buffer The string to append to.
+ *  \param[in] mark_real If true and the representation looks like an integer,
+ *                       ".0" is added.  Some formats (e.g. G94 exponents) use
+ *                       the decimal point to tell reals from integers.
+ */
+inline void append_double(double x, std::string& buffer, bool mark_real=false)
+{
+    char digits[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+    const auto result=std::to_chars(digits,digits+sizeof(digits),x);
+    const std::string_view number(digits,result.ptr-digits);
+#else
+    const std::string_view number(digits,std::snprintf(digits,sizeof(digits),
+                                                       "%.17g",x));
+#endif
+    buffer.append(number);
+    if(mark_real && number.find_first_of(".eEin")==std::string_view::npos)
+        buffer.append(".0");
+}
+
+///Appends \p n in decimal
+inline void append_integer(long long n, std::string& buffer)
+{
+    char digits[24];
+    const auto result=std::to_chars(digits,digits+sizeof(digits),n);
+    buffer.append(digits,result.ptr-digits);
+}
+
+/** \brief Writes buffers to a file with one write call per buffer.
+ *
+ *  Unlike an std::ofstream there is no intermediate buffering or formatting
+ *  layer; the caller formats into its own (large) buffer and hands it over.
+ */
+class FileWriter {
+public:
+    /** \brief Opens \p path for writing.
+     *
+     *  \param[in] path The file to write.
+     *  \param[in] append If true the file is appended to, otherwise it is
+     *                    truncated.  Either way it is created if need be.
+     *  \throws std::runtime_error if the file can not be opened.
+     */
+    explicit FileWriter(const std::string& path, bool append=false);
+
+    ///Closes the file
+    ~FileWriter()noexcept;
+
+    FileWriter(const FileWriter&)=delete;
+    FileWriter& operator=(const FileWriter&)=delete;
+
+    /** \brief Writes all of \p data to the file.
+     *
+     *  \throws std::runtime_error if the write fails, e.g. the disk is full.
+     */
+    void write(std::string_view data);
+
+private:
+    std::string path_;
+    int fd_;
+};
+
+}}//End namespaces
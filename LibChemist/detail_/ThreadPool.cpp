@@ -0,0 +1,64 @@
+#include "LibChemist/detail_/ThreadPool.hpp"
+#include "LibChemist/detail_/ParallelFor.hpp"
+
+namespace LibChemist {
+namespace detail_ {
+
+ThreadPool::ThreadPool(size_t nthreads)
+{
+    nthreads=resolve_nthreads(nthreads);
+    threads_.reserve(nthreads);
+    try
+    {
+        for(size_t i=0;i<nthreads;++i)
+            threads_.emplace_back(&ThreadPool::work,this);
+    }
+    catch(...)
+    {
+        stop();
+        throw;
+    }
+}
+
+ThreadPool::~ThreadPool()noexcept
+{
+    stop();
+}
+
+void ThreadPool::stop()noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_=true;
+    }
+    not_empty_.notify_all();
+    for(auto& t: threads_)
+        if(t.joinable())t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    not_empty_.notify_one();
+}
+
+void ThreadPool::work()noexcept
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock,[this]{return stopping_ || !tasks_.empty();});
+            if(tasks_.empty())return;
+            task=std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+}}//End namespaces
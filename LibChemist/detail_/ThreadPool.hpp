@@ -0,0 +1,55 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LibChemist {
+namespace detail_ {
+
+/** \brief A fixed set of threads running tasks in the order they are queued.
+ *
+ *  Unlike parallel_for, which runs a known number of tasks and returns when
+ *  they are done, the pool lives on and tasks can be queued from any thread
+ *  at any time.  Tasks must not throw; reporting errors (e.g. through a
+ *  std::promise) is up to them.
+ */
+class ThreadPool {
+public:
+    /** \brief Starts the threads.
+     *
+     *  \param[in] nthreads The number of threads, 0 means one per hardware
+     *                      thread.
+     *  \throws std::system_error if a thread can not be started.
+     */
+    explicit ThreadPool(size_t nthreads);
+
+    ///Runs the tasks that are still queued, then stops the threads
+    ~ThreadPool()noexcept;
+
+    ThreadPool(const ThreadPool&)=delete;
+    ThreadPool& operator=(const ThreadPool&)=delete;
+
+    ///Queues \p task to be run by the first free thread
+    void submit(std::function<void()> task);
+
+    ///Returns the number of threads
+    size_t size()const noexcept{return threads_.size();}
+
+private:
+    ///Lets the threads drain the queue and waits for them
+    void stop()noexcept;
+
+    ///What each thread runs, until the pool stops and the queue is empty
+    void work()noexcept;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_=false;
+    std::vector<std::thread> threads_;
+};
+
+}}//End namespaces
@@ -1,5 +1,6 @@
 #include "LibChemist/lut/AtomicInfo.hpp"
 #include <algorithm>
+#include <stdexcept>
 
 namespace LibChemist {
 namespace detail_ {
@@ -1,5 +1,8 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -61,4 +64,239 @@ size_t most_common_isotope(size_t Z);
  */
 double isotope_mass(size_t Z, size_t isonum);
 
+//! An element symbol packed by symbol_key and its atomic number
+struct SymbolEntry {
+    std::uint32_t key;
+    std::uint16_t Z;
+};
+
+//! The symbols known to find_symbol_Z, in order of atomic number
+inline constexpr std::array<SymbolEntry, 121> symbols_{{
+  { 0x6F6867 , 0 }, // Gho
+  { 0x000068 , 1 }, // H
+  { 0x006568 , 2 }, // He
+  { 0x00696C , 3 }, // Li
+  { 0x006562 , 4 }, // Be
+  { 0x000062 , 5 }, // B
+  { 0x000063 , 6 }, // C
+  { 0x00006E , 7 }, // N
+  { 0x00006F , 8 }, // O
+  { 0x000066 , 9 }, // F
+  { 0x00656E , 10 }, // Ne
+  { 0x00616E , 11 }, // Na
+  { 0x00676D , 12 }, // Mg
+  { 0x006C61 , 13 }, // Al
+  { 0x006973 , 14 }, // Si
+  { 0x000070 , 15 }, // P
+  { 0x000073 , 16 }, // S
+  { 0x006C63 , 17 }, // Cl
+  { 0x007261 , 18 }, // Ar
+  { 0x00006B , 19 }, // K
+  { 0x006163 , 20 }, // Ca
+  { 0x006373 , 21 }, // Sc
+  { 0x006974 , 22 }, // Ti
+  { 0x000076 , 23 }, // V
+  { 0x007263 , 24 }, // Cr
+  { 0x006E6D , 25 }, // Mn
+  { 0x006566 , 26 }, // Fe
+  { 0x006F63 , 27 }, // Co
+  { 0x00696E , 28 }, // Ni
+  { 0x007563 , 29 }, // Cu
+  { 0x006E7A , 30 }, // Zn
+  { 0x006167 , 31 }, // Ga
+  { 0x006567 , 32 }, // Ge
+  { 0x007361 , 33 }, // As
+  { 0x006573 , 34 }, // Se
+  { 0x007262 , 35 }, // Br
+  { 0x00726B , 36 }, // Kr
+  { 0x006272 , 37 }, // Rb
+  { 0x007273 , 38 }, // Sr
+  { 0x000079 , 39 }, // Y
+  { 0x00727A , 40 }, // Zr
+  { 0x00626E , 41 }, // Nb
+  { 0x006F6D , 42 }, // Mo
+  { 0x006374 , 43 }, // Tc
+  { 0x007572 , 44 }, // Ru
+  { 0x006872 , 45 }, // Rh
+  { 0x006470 , 46 }, // Pd
+  { 0x006761 , 47 }, // Ag
+  { 0x006463 , 48 }, // Cd
+  { 0x006E69 , 49 }, // In
+  { 0x006E73 , 50 }, // Sn
+  { 0x006273 , 51 }, // Sb
+  { 0x006574 , 52 }, // Te
+  { 0x000069 , 53 }, // I
+  { 0x006578 , 54 }, // Xe
+  { 0x007363 , 55 }, // Cs
+  { 0x006162 , 56 }, // Ba
+  { 0x00616C , 57 }, // La
+  { 0x006563 , 58 }, // Ce
+  { 0x007270 , 59 }, // Pr
+  { 0x00646E , 60 }, // Nd
+  { 0x006D70 , 61 }, // Pm
+  { 0x006D73 , 62 }, // Sm
+  { 0x007565 , 63 }, // Eu
+  { 0x006467 , 64 }, // Gd
+  { 0x006274 , 65 }, // Tb
+  { 0x007964 , 66 }, // Dy
+  { 0x006F68 , 67 }, // Ho
+  { 0x007265 , 68 }, // Er
+  { 0x006D74 , 69 }, // Tm
+  { 0x006279 , 70 }, // Yb
+  { 0x00756C , 71 }, // Lu
+  { 0x006668 , 72 }, // Hf
+  { 0x006174 , 73 }, // Ta
+  { 0x000077 , 74 }, // W
+  { 0x006572 , 75 }, // Re
+  { 0x00736F , 76 }, // Os
+  { 0x007269 , 77 }, // Ir
+  { 0x007470 , 78 }, // Pt
+  { 0x007561 , 79 }, // Au
+  { 0x006768 , 80 }, // Hg
+  { 0x006C74 , 81 }, // Tl
+  { 0x006270 , 82 }, // Pb
+  { 0x006962 , 83 }, // Bi
+  { 0x006F70 , 84 }, // Po
+  { 0x007461 , 85 }, // At
+  { 0x006E72 , 86 }, // Rn
+  { 0x007266 , 87 }, // Fr
+  { 0x006172 , 88 }, // Ra
+  { 0x006361 , 89 }, // Ac
+  { 0x006874 , 90 }, // Th
+  { 0x006170 , 91 }, // Pa
+  { 0x000075 , 92 }, // U
+  { 0x00706E , 93 }, // Np
+  { 0x007570 , 94 }, // Pu
+  { 0x006D61 , 95 }, // Am
+  { 0x006D63 , 96 }, // Cm
+  { 0x006B62 , 97 }, // Bk
+  { 0x006663 , 98 }, // Cf
+  { 0x007365 , 99 }, // Es
+  { 0x006D66 , 100 }, // Fm
+  { 0x00646D , 101 }, // Md
+  { 0x006F6E , 102 }, // No
+  { 0x00726C , 103 }, // Lr
+  { 0x006672 , 104 }, // Rf
+  { 0x006264 , 105 }, // Db
+  { 0x006773 , 106 }, // Sg
+  { 0x006862 , 107 }, // Bh
+  { 0x007368 , 108 }, // Hs
+  { 0x00746D , 109 }, // Mt
+  { 0x007364 , 110 }, // Ds
+  { 0x006772 , 111 }, // Rg
+  { 0x006E63 , 112 }, // Cn
+  { 0x747575 , 113 }, // Uut
+  { 0x006C66 , 114 }, // Fl
+  { 0x707575 , 115 }, // Uup
+  { 0x00766C , 116 }, // Lv
+  { 0x737575 , 117 }, // Uus
+  { 0x6F7575 , 118 }, // Uuo
+  { 0x676863 , 999 }, // Chg
+  { 0x6D7564 , 9999 }, // Dum
+}}; // close symbols_
+
+//! Perfect hash table, slot i holds an index into symbols_ or 255
+inline constexpr std::array<std::uint8_t, 1024> symbol_slots_{{
+  255, 255,  45, 255, 255, 255, 255, 255, 255, 255, 255, 255,  11, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  70, 255, 255, 255,
+  255, 112, 255, 255,  66, 255, 255, 255,   9, 255, 255, 255, 255, 255, 101, 255,
+  102, 255, 105, 255, 255, 255, 255, 255, 255, 255, 117, 255, 255,  54, 118, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  16, 255, 255, 255, 255,
+  255, 255, 255,  58, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255,  85, 255, 255, 255, 255, 255, 255, 255, 255,  81, 255, 255, 255,
+  255, 255, 255,  71, 107,  40, 255,  55, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 119, 255, 255,  19, 255, 255, 255, 255, 255, 255,  68, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  43, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,   2,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,   6, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 108, 255, 255, 255, 255, 255, 255,  25,  20, 255, 255, 255, 255,
+  255,  15, 255, 255, 255, 255, 255, 255, 255, 255,  41, 255, 255, 255, 255, 255,
+  255, 255, 255, 255,  90, 255, 255, 255, 255, 255, 255, 255, 255,  30,  91,  27,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  93, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255,   1, 255, 255,  47, 255, 255,
+   35, 255,  84, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255,  98, 255, 255, 255, 255,  86, 255, 255, 255, 255, 255, 255,  92, 255, 255,
+  255,  79, 255, 255, 255, 255, 255,  51, 255, 255,  69, 255, 255, 255, 255, 255,
+  255, 116,  83, 255, 255, 255, 255, 255,  64, 255, 255,  67, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255,  75,  99, 255, 255, 255, 255, 255, 255,
+  255, 255, 255,  13, 255, 255, 255, 255,  78, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  72, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 106, 255, 255,
+  255, 255, 255, 255, 255,  89, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255,  42, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  114, 255,  22, 255, 255, 255, 255, 255, 255, 103,   4, 255,  82, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+   88, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,   3, 255, 255, 109, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255,  76, 255, 255, 255,  21, 255, 255, 255, 255, 255, 255, 255, 255, 255,  74,
+  255, 255, 255,  29, 255, 255,  32, 255, 255, 113, 120, 255, 255, 115, 255, 255,
+  255, 255, 255, 255,   5, 255, 104, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255,  95, 255, 255, 255, 255,  94, 255, 255, 255,  52, 255,   0, 255, 255, 255,
+  255, 255,  56, 255, 255,  17, 255, 255,   8, 255, 255,  80, 255, 255,  77, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255,  60,  18, 255, 255, 255, 255, 255, 255, 100, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  31, 255,
+  255, 255, 255, 255, 255, 255, 255, 255,  12, 255, 255, 255, 255, 255,  37, 255,
+  255,  62, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255,  73, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  110, 255, 255, 255, 255, 255,  49, 255, 255, 255, 255, 255,  28, 255, 255, 255,
+  255, 255, 255,  87, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  97, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  57, 255, 255, 255, 255,
+   39, 255, 255, 255, 111,  63, 255,  38, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255,  96, 255, 255, 255, 255,  44, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255,  14, 255, 255, 255, 255, 255, 255,
+   36, 255, 255, 255, 255, 255,  61, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255,  48, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255,  10,  33, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255,  53, 255, 255, 255, 255,  46,  24, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  50,
+  255, 255, 255, 255, 255, 255,  23, 255, 255, 255, 255, 255,  59, 255,  26, 255,
+   65, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255,  34, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,   7,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+}}; // close symbol_slots_
+
+//! What find_symbol_Z returns for something that is not a symbol
+inline constexpr size_t no_symbol_Z_ = static_cast<size_t>(-1);
+
+/** \brief Packs a one to three letter element symbol into a key,
+ *  ignoring case
+ *
+ * \param[in] sym The symbol to pack
+ * \returns The key, or 0 if \p sym is not one to three letters
+ */
+constexpr std::uint32_t symbol_key(std::string_view sym) noexcept {
+  if(sym.empty() || sym.size() > 3) return 0;
+  std::uint32_t key = 0;
+  for(size_t i = 0; i < sym.size(); ++i) {
+    const char c = static_cast<char>(sym[i] | 0x20);
+    if(c < 'a' || c > 'z') return 0;
+    key |= static_cast<std::uint32_t>(c) << (8 * i);
+  }
+  return key;
+}
+
+/** \brief Returns the atomic number of the element with symbol \p sym
+ *
+ * The symbol is matched without regard to case, through a perfect hash
+ * over the known symbols, so this neither allocates nor probes.
+ *
+ * \param[in] sym The atomic symbol, e.g. "He", "HE", or "he"
+ * \returns The atomic number, or no_symbol_Z_ if \p sym is not a symbol
+ */
+constexpr size_t find_symbol_Z(std::string_view sym) noexcept {
+  const std::uint32_t key = symbol_key(sym);
+  const std::uint8_t i =
+    symbol_slots_[static_cast<std::uint32_t>(key * 0x9E377FBDu) >> 22];
+  return (key && i != 255 && symbols_[i].key == key) ?
+         symbols_[i].Z : no_symbol_Z_;
+}
+
 }}//End namespaces
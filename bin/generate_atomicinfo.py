@@ -135,6 +135,30 @@ for l in open(mult_file).readlines()[5:]:
   atomicinfo[z]["mult"] = int(mult)
   atomicinfo[z]["termsym"] = termsym
 
+#Perfect hash for the element symbols.  Symbols are case-folded and packed
+#into a 32-bit key (first letter in the lowest byte), which is hashed with a
+#multiply-shift.  We search for a multiplier that leaves no collisions.
+symbol_hash_bits = 10
+
+def symbol_key(sym):
+    key = 0
+    for i, c in enumerate(sym.lower()):
+        key |= ord(c) << (8 * i)
+    return key
+
+def symbol_slot(key, mult):
+    return ((key * mult) & 0xFFFFFFFF) >> (32 - symbol_hash_bits)
+
+symbol_keys = [symbol_key(v["sym"]) for k, v in sorted(atomicinfo.items())]
+symbol_mult = 0x9E3779B1
+while len(set(symbol_slot(k, symbol_mult) for k in symbol_keys)) != \
+        len(symbol_keys):
+    symbol_mult = (symbol_mult + 2) & 0xFFFFFFFF
+
+symbol_slots = [255] * (1 << symbol_hash_bits)
+for i, key in enumerate(symbol_keys):
+    symbol_slots[symbol_slot(key, symbol_mult)] = i
+
 header_file = os.path.join(outbase,"AtomicInfo.hpp")
 src_file = os.path.join(outbase,"AtomicInfo.cpp")
 
@@ -150,7 +174,10 @@ comment ="""
 with open(header_file,'w') as f:
 
     f.write("#pragma once\n")
+    f.write("#include <array>\n")
+    f.write("#include <cstdint>\n")
     f.write("#include <string>\n")
+    f.write("#include <string_view>\n")
     f.write("#include <unordered_map>\n")
     f.write("#include <vector>\n")
     f.write(comment+'\n')
@@ -198,11 +225,62 @@ with open(header_file,'w') as f:
     f.write(" *      there is no data for that isotope number.\n")
     f.write(" */\n")
     f.write("double isotope_mass(size_t Z, size_t isonum);\n\n")
+    f.write("//! An element symbol packed by symbol_key and its atomic number\n")
+    f.write("struct SymbolEntry {\n")
+    f.write("    std::uint32_t key;\n")
+    f.write("    std::uint16_t Z;\n")
+    f.write("};\n\n")
+    f.write("//! The symbols known to find_symbol_Z, in order of atomic number\n")
+    f.write("inline constexpr std::array<SymbolEntry, {}> symbols_{{{{\n".
+            format(len(symbol_keys)))
+    for (k,v), key in zip(sorted(atomicinfo.items()), symbol_keys):
+        f.write("  {{ 0x{:06X} , {} }}, // {}\n".format(key, k, v["sym"]))
+    f.write("}}; // close symbols_\n\n")
+    f.write("//! Perfect hash table, slot i holds an index into symbols_ or 255\n")
+    f.write("inline constexpr std::array<std::uint8_t, {}> symbol_slots_{{{{\n".
+            format(len(symbol_slots)))
+    for i in range(0, len(symbol_slots), 16):
+        f.write("  "+", ".join("{:>3}".format(x) for x in
+                               symbol_slots[i:i+16])+",\n")
+    f.write("}}; // close symbol_slots_\n\n")
+    f.write("//! What find_symbol_Z returns for something that is not a symbol\n")
+    f.write("inline constexpr size_t no_symbol_Z_ = static_cast<size_t>(-1);\n\n")
+    f.write("/** \\brief Packs a one to three letter element symbol into a key,\n")
+    f.write(" *  ignoring case\n")
+    f.write(" *\n")
+    f.write(" * \\param[in] sym The symbol to pack\n")
+    f.write(" * \\returns The key, or 0 if \\p sym is not one to three letters\n")
+    f.write(" */\n")
+    f.write("constexpr std::uint32_t symbol_key(std::string_view sym) noexcept {\n")
+    f.write("  if(sym.empty() || sym.size() > 3) return 0;\n")
+    f.write("  std::uint32_t key = 0;\n")
+    f.write("  for(size_t i = 0; i < sym.size(); ++i) {\n")
+    f.write("    const char c = static_cast<char>(sym[i] | 0x20);\n")
+    f.write("    if(c < 'a' || c > 'z') return 0;\n")
+    f.write("    key |= static_cast<std::uint32_t>(c) << (8 * i);\n")
+    f.write("  }\n")
+    f.write("  return key;\n}\n\n")
+    f.write("/** \\brief Returns the atomic number of the element with symbol \\p sym\n")
+    f.write(" *\n")
+    f.write(" * The symbol is matched without regard to case, through a perfect hash\n")
+    f.write(" * over the known symbols, so this neither allocates nor probes.\n")
+    f.write(" *\n")
+    f.write(" * \\param[in] sym The atomic symbol, e.g. \"He\", \"HE\", or \"he\"\n")
+    f.write(" * \\returns The atomic number, or no_symbol_Z_ if \\p sym is not a symbol\n")
+    f.write(" */\n")
+    f.write("constexpr size_t find_symbol_Z(std::string_view sym) noexcept {\n")
+    f.write("  const std::uint32_t key = symbol_key(sym);\n")
+    f.write("  const std::uint8_t i =\n")
+    f.write("    symbol_slots_[static_cast<std::uint32_t>(key * 0x{:08X}u) >> {}];\n".
+            format(symbol_mult, 32 - symbol_hash_bits))
+    f.write("  return (key && i != 255 && symbols_[i].key == key) ?\n")
+    f.write("         symbols_[i].Z : no_symbol_Z_;\n}\n\n")
     f.write("}}//End namespaces\n")
 
 with open(src_file,'w') as f:
     f.write("#include \"LibChemist/lut/AtomicInfo.hpp\"\n")
-    f.write("#include <algorithm>\n\n")
+    f.write("#include <algorithm>\n")
+    f.write("#include <stdexcept>\n\n")
     f.write("namespace LibChemist {\n")
     f.write("namespace detail_ {\n")
 